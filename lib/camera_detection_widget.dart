@@ -1,10 +1,8 @@
 import 'dart:developer' as developer;
-import 'dart:ffi' as ffi;
-import 'dart:typed_data';
+import 'dart:io';
 import 'package:flutter/material.dart';
-import 'package:ffi/ffi.dart';
 import 'package:camera/camera.dart';
-import 'spotitml_ffi.dart';
+import 'detection_engine.dart';
 
 class CameraDetectionWidget extends StatefulWidget {
   const CameraDetectionWidget({super.key});
@@ -16,15 +14,44 @@ class CameraDetectionWidget extends StatefulWidget {
 class _CameraDetectionWidgetState extends State<CameraDetectionWidget> {
   CameraController? _controller;
   List<CameraDescription>? _cameras;
+  DetectionEngine? _engine;
+  DetectionWorker? _worker;
   String? _detectionResult;
   bool _isDetecting = false;
+  bool _captureRequested = false;
+  bool _liveMode = false;
 
   @override
   void initState() {
     super.initState();
+    // The engine is created and warmed up on a native thread while the camera
+    // initializes, so the first detection does not pay for either.
+    _initializeEngine();
     _initializeCamera();
   }
 
+  Future<void> _initializeEngine() async {
+    try {
+      final engine = await DetectionEngine.load();
+      if (!mounted) {
+        engine.dispose();
+        return;
+      }
+      // The live detection switch is enabled by the worker appearing.
+      setState(() {
+        _engine = engine;
+        // Cards barely move while scanning, so the detector only runs on
+        // keyframes and tracked boxes fill the frames in between.
+        _worker = DetectionWorker(engine, onResults: _onResults, onError: _onDetectionError, tracking: true);
+      });
+    } catch (e) {
+      developer.log('Error creating detection engine: $e', name: 'spotitml.ffi');
+      setState(() {
+        _detectionResult = 'Model loading failed: $e';
+      });
+    }
+  }
+
   Future<void> _initializeCamera() async {
     try {
       _cameras = await availableCameras();
@@ -33,9 +60,13 @@ class _CameraDetectionWidgetState extends State<CameraDetectionWidget> {
         _controller = CameraController(
           _cameras![0], // Use the first available camera
           ResolutionPreset.medium,
+          enableAudio: false,
+          // Raw stream planes go straight to the native preprocessor
+          imageFormatGroup: Platform.isAndroid ? ImageFormatGroup.yuv420 : ImageFormatGroup.bgra8888,
         );
         
         await _controller!.initialize();
+        await _controller!.startImageStream(_onCameraImage);
         
         if (mounted) {
           setState(() {});
@@ -49,61 +80,73 @@ class _CameraDetectionWidgetState extends State<CameraDetectionWidget> {
     }
   }
 
-  Future<void> _detectObjects() async {
-    if (_controller == null || !_controller!.value.isInitialized || _isDetecting) {
+  // Detection runs on the next frame of the image stream, so no picture is
+  // written, re-read or JPEG decoded.
+  void _detectObjects() {
+    if (_controller == null || !_controller!.value.isInitialized || _worker == null || _isDetecting) {
       return;
     }
 
+    developer.log('Starting object detection...', name: 'spotitml.detection');
     setState(() {
       _isDetecting = true;
+      _captureRequested = true;
       _detectionResult = 'Processing...';
     });
+  }
+
+  // Runs on the camera stream. Submitting only copies the planes into the
+  // native mailbox; inference happens on the worker thread, and frames that
+  // arrive while it is busy replace each other instead of piling up.
+  void _onCameraImage(CameraImage image) {
+    if (_worker == null || !(_liveMode || _captureRequested)) {
+      return;
+    }
+    _captureRequested = false;
 
     try {
-      developer.log('Starting object detection...', name: 'spotitml.detection');
-      
-      // Capture image from camera
-      final XFile imageFile = await _controller!.takePicture();
-      final Uint8List imageBytes = await imageFile.readAsBytes();
-      
-      developer.log('Captured image, size: ${imageBytes.length} bytes', name: 'spotitml.detection');
-      
-      // For now, we'll pass dummy dimensions and the image data to FFI
-      // In a real implementation, we'd need to decode the image and convert to RGB
-      final imagePtr = malloc<ffi.Uint8>(imageBytes.length);
-      
-      try {
-        imagePtr.asTypedList(imageBytes.length).setAll(0, imageBytes);
-        developer.log('Calling detect_objects via FFI...', name: 'spotitml.ffi');
-        
-        // Use image dimensions (this is a simplification - real implementation 
-        // would need proper image decoding)
-        final detectPtr = SpotitmlNative.detectObjects(imagePtr, 640, 480);
-        final detectStr = detectPtr.cast<Utf8>().toDartString();
-        developer.log('FFI returned: $detectStr', name: 'spotitml.ffi');
-        
-        setState(() {
-          _detectionResult = detectStr;
-          _isDetecting = false;
-        });
-        
-      } finally {
-        malloc.free(imagePtr);
-      }
+      _worker!.submit(image);
     } catch (e, stackTrace) {
-      developer.log('Detection failed', name: 'spotitml.detection', error: e, stackTrace: stackTrace);
-      // Stack trace now handled by developer.log above
-      
-      setState(() {
-        _detectionResult = "Detection error: $e";
-        _isDetecting = false;
-      });
+      developer.log('Frame submission failed', name: 'spotitml.detection', error: e, stackTrace: stackTrace);
+      _onDetectionError(e);
+    }
+  }
+
+  void _onResults(DetectionResults results, int frameId) {
+    if (!mounted) {
+      return;
+    }
+    final buffer = StringBuffer('${results.length} detections (frame $frameId)');
+    for (var i = 0; i < results.length; i++) {
+      final d = results[i];
+      buffer.write('\nclass ${d.classId}  ${(d.score * 100).toStringAsFixed(0)}%  '
+          '[${d.x1.round()}, ${d.y1.round()}, ${d.x2.round()}, ${d.y2.round()}]');
+    }
+    final detectStr = buffer.toString();
+    developer.log('Detection returned: $detectStr', name: 'spotitml.ffi');
+
+    setState(() {
+      _detectionResult = detectStr;
+      _isDetecting = false;
+    });
+  }
+
+  void _onDetectionError(Object error) {
+    developer.log('Detection failed', name: 'spotitml.detection', error: error);
+    if (!mounted) {
+      return;
     }
+    setState(() {
+      _detectionResult = "Detection error: $error";
+      _isDetecting = false;
+    });
   }
 
   @override
   void dispose() {
     _controller?.dispose();
+    _worker?.dispose();
+    _engine?.dispose();
     super.dispose();
   }
 
@@ -133,11 +176,22 @@ class _CameraDetectionWidgetState extends State<CameraDetectionWidget> {
           ),
         ),
         
+        // Continuous detection on every camera frame
+        SwitchListTile(
+          title: const Text('Live detection'),
+          value: _liveMode,
+          onChanged: _worker == null
+              ? null
+              : (value) => setState(() {
+                    _liveMode = value;
+                  }),
+        ),
+
         // Detection button
         Padding(
           padding: const EdgeInsets.all(16.0),
           child: ElevatedButton(
-            onPressed: _isDetecting ? null : _detectObjects,
+            onPressed: _isDetecting || _liveMode ? null : _detectObjects,
             style: ElevatedButton.styleFrom(
               minimumSize: const Size(double.infinity, 50),
             ),
@@ -0,0 +1,711 @@
+import 'dart:async';
+import 'dart:developer' as developer;
+import 'dart:ffi' as ffi;
+import 'dart:io';
+import 'package:camera/camera.dart';
+import 'package:ffi/ffi.dart';
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+import 'spotitml_ffi.dart';
+
+// Zero-copy view over the detections written by the last detect() call.
+// Entries are valid until the next detect() or dispose().
+class DetectionResults {
+  final ffi.Pointer<SpotitmlDetection> _detections;
+  final int length;
+
+  const DetectionResults._(this._detections, this.length);
+
+  SpotitmlDetection operator [](int index) {
+    RangeError.checkValidIndex(index, this, 'index', length);
+    return _detections[index];
+  }
+}
+
+// Zero-copy view over the cards found by the last detectCards() call; each
+// card carries its own detections in source image pixels. Entries are valid
+// until the next detectCards() or dispose().
+class CardResults {
+  final ffi.Pointer<SpotitmlCardResult> _cards;
+  final int length;
+
+  const CardResults._(this._cards, this.length);
+
+  SpotitmlCardResult operator [](int index) {
+    RangeError.checkValidIndex(index, this, 'index', length);
+    return _cards[index];
+  }
+}
+
+// Outcome of detectMatch(): the cards in view and, if two of them share a
+// symbol, where it is on each. Views native memory that stays valid until the
+// next detectMatch() or dispose().
+class MatchResult {
+  final CardResults cards;
+  // Null if fewer than two cards were found or they share no symbol.
+  final SpotitmlMatch? match;
+
+  const MatchResult._(this.cards, this.match);
+}
+
+// Zero-copy view over the tracks delivered to DetectionWorker.onTracks.
+// Entries are valid until the next callback or dispose().
+class TrackResults {
+  final ffi.Pointer<SpotitmlTrack> _tracks;
+  final int length;
+
+  const TrackResults._(this._tracks, this.length);
+
+  SpotitmlTrack operator [](int index) {
+    RangeError.checkValidIndex(index, this, 'index', length);
+    return _tracks[index];
+  }
+}
+
+typedef StageStats = ({int count, double meanMs, double p50Ms, double p95Ms, double p99Ms, double maxMs});
+
+// Copy of the native pipeline statistics (stats_snapshot), taken in one call
+// so on-device profiling does not depend on parsing log output.
+class PipelineStats {
+  // False if the native library was built without SPOTITML_INSTRUMENTATION;
+  // then only lastLoad is filled in.
+  final bool enabled;
+  // Indexed by SpotitmlStage.
+  final List<StageStats> stages;
+  final int framesSubmitted;
+  final int framesDropped;
+  final int framesProcessed;
+  final int framesFailed;
+  // Frames answered by the tracker without running the detector.
+  final int framesTracked;
+  final int candidates;
+  final int candidateOverflow;
+  final int detections;
+  final ({double loadMs, double warmupMs, int cacheState}) lastLoad;
+
+  PipelineStats._(SpotitmlStats s)
+      : enabled = s.enabled != 0,
+        stages = [
+          for (var i = 0; i < SpotitmlStage.count; i++)
+            (count: s.stages[i].count, meanMs: s.stages[i].meanMs, p50Ms: s.stages[i].p50Ms,
+             p95Ms: s.stages[i].p95Ms, p99Ms: s.stages[i].p99Ms, maxMs: s.stages[i].maxMs),
+        ],
+        framesSubmitted = s.framesSubmitted,
+        framesDropped = s.framesDropped,
+        framesProcessed = s.framesProcessed,
+        framesFailed = s.framesFailed,
+        framesTracked = s.framesTracked,
+        candidates = s.candidates,
+        candidateOverflow = s.candidateOverflow,
+        detections = s.detections,
+        lastLoad = (loadMs: s.lastLoad.loadMs, warmupMs: s.lastLoad.warmupMs, cacheState: s.lastLoad.cacheState);
+}
+
+// Owns one native inference engine for the bundled YOLOv8 model.
+// Create it once (session setup is expensive), reuse it for every frame,
+// and dispose it when the camera screen goes away.
+class DetectionEngine {
+  static const String modelAsset = 'assets/models/yolov8n.onnx';
+  // Reduced-precision builds of modelAsset written by native/tools/
+  // quantize_model.py; whichever of them are bundled are offered to the
+  // native variant policy alongside the FP32 model.
+  static const Map<String, int> variantAssets = {
+    modelAsset: SpotitmlPrecision.fp32,
+    'assets/models/yolov8n_fp16.onnx': SpotitmlPrecision.fp16,
+    'assets/models/yolov8n_int8.onnx': SpotitmlPrecision.int8,
+  };
+  static const int maxDetections = 100;
+  // One buffer being filled, one queued in the worker, one being processed,
+  // plus one for a synchronous detect in between.
+  static const int framePoolSize = 4;
+
+  ffi.Pointer<SpotitmlEngine> _handle;
+
+  // Result array handed to engine_detect; allocated once per engine.
+  final ffi.Pointer<SpotitmlDetection> _detections = calloc<SpotitmlDetection>(maxDetections);
+  final ffi.Pointer<SpotitmlFrame> _frame = calloc<SpotitmlFrame>();
+  final ffi.Pointer<SpotitmlCardResult> _cards = calloc<SpotitmlCardResult>(SpotitmlCards.maxCards);
+  final ffi.Pointer<SpotitmlMatch> _match = calloc<SpotitmlMatch>();
+
+  // Camera planes are written straight into these native buffers; created on
+  // the first camera frame.
+  ffi.Pointer<SpotitmlFramePool> _pool = ffi.nullptr;
+  final List<ffi.Pointer<SpotitmlFramePool>> _retiredPools = [];
+
+  DetectionEngine._(this._handle);
+
+  ffi.Pointer<SpotitmlEngine> get handle => _handle;
+
+  // Creates the engine on a native background thread and runs warmupRuns
+  // dummy inferences there, so neither session setup nor first-run warm-up
+  // blocks the UI, and the first real detection runs at steady-state latency.
+  // The future completes once the engine is ready.
+  //
+  // Unset options keep the native defaults. providers is a priority list of
+  // SpotitmlExecutionProvider values; ones this device or runtime build does
+  // not offer are skipped, so check activeProviders for what was used.
+  //
+  // variantPolicy (a SpotitmlVariantPolicy value) picks among the bundled
+  // model precisions; auto times each on this device and keeps the most
+  // accurate one that is about as fast as the fastest. variantReports tells
+  // which one was chosen.
+  static Future<DetectionEngine> load({
+    int intraOpThreads = 0,
+    int interOpThreads = 0,
+    double? scoreThreshold,
+    double? iouThreshold,
+    int? graphOptimization,
+    int? executionMode,
+    bool? enableCpuMemArena,
+    bool? enableMemPattern,
+    int? logSeverity,
+    List<int>? providers,
+    bool useModelCache = true,
+    int warmupRuns = 2,
+    int variantPolicy = SpotitmlVariantPolicy.auto,
+    int benchRuns = 0,
+  }) async {
+    final variants = await _extractModels();
+
+    final ready = Completer<int>();
+    final callback = ffi.NativeCallable<SpotitmlReadyCallback>.listener(
+        (int state, ffi.Pointer<ffi.Void> userData) => ready.complete(state));
+
+    final options = calloc<SpotitmlEngineOptions>();
+    final variantsPtr = calloc<SpotitmlModelVariant>(variants.length);
+    final cacheDirPtr = useModelCache ? _modelCacheDir().toNativeUtf8() : ffi.nullptr.cast<Utf8>();
+    final ffi.Pointer<SpotitmlPrewarm> prewarm;
+    try {
+      for (var i = 0; i < variants.length; i++) {
+        variantsPtr[i].modelPath = variants[i].path.toNativeUtf8();
+        variantsPtr[i].precision = variants[i].precision;
+      }
+      SpotitmlNative.engineDefaultOptions(options);
+      final o = options.ref;
+      o.intraOpThreads = intraOpThreads;
+      o.interOpThreads = interOpThreads;
+      if (scoreThreshold != null) o.scoreThreshold = scoreThreshold;
+      if (iouThreshold != null) o.iouThreshold = iouThreshold;
+      if (graphOptimization != null) o.graphOptimization = graphOptimization;
+      if (executionMode != null) o.executionMode = executionMode;
+      if (enableCpuMemArena != null) o.enableCpuMemArena = enableCpuMemArena ? 1 : 0;
+      if (enableMemPattern != null) o.enableMemPattern = enableMemPattern ? 1 : 0;
+      if (logSeverity != null) o.logSeverity = logSeverity;
+      o.cacheDir = cacheDirPtr;
+      if (providers != null) {
+        if (providers.length > SpotitmlExecutionProvider.maxProviders) {
+          throw ArgumentError.value(providers, 'providers', 'at most ${SpotitmlExecutionProvider.maxProviders}');
+        }
+        o.providerCount = providers.length;
+        for (var i = 0; i < providers.length; i++) {
+          o.providers[i] = providers[i];
+        }
+      }
+
+      // The paths and options are copied natively; they can go right away.
+      prewarm = SpotitmlNative.enginePrewarmVariant(variantsPtr, variants.length, variantPolicy, benchRuns, options,
+                                                    warmupRuns, callback.nativeFunction, ffi.nullptr);
+    } catch (_) {
+      callback.close();
+      rethrow;
+    } finally {
+      for (var i = 0; i < variants.length; i++) {
+        if (variantsPtr[i].modelPath != ffi.nullptr) calloc.free(variantsPtr[i].modelPath);
+      }
+      calloc.free(variantsPtr);
+      if (cacheDirPtr != ffi.nullptr) calloc.free(cacheDirPtr);
+      calloc.free(options);
+    }
+    if (prewarm == ffi.nullptr) {
+      callback.close();
+      throw StateError(SpotitmlNative.engineLastError().toDartString());
+    }
+
+    try {
+      await ready.future;
+      final handle = SpotitmlNative.prewarmTakeEngine(prewarm);
+      if (handle == ffi.nullptr) {
+        throw StateError(SpotitmlNative.engineLastError().toDartString());
+      }
+      final engine = DetectionEngine._(handle);
+      final stats = engine.loadStats;
+      final chosen = engine.variantReports.where((r) => r.status == SpotitmlVariantStatus.chosen);
+      developer.log('Engine created for precision ${chosen.map((r) => r.precision).join()} '
+                    'in ${stats.loadMs.toStringAsFixed(1)} ms, '
+                    'warm-up ${stats.warmupMs.toStringAsFixed(1)} ms '
+                    '(cache state ${stats.cacheState}, providers ${engine.activeProviders})', name: 'spotitml.ffi');
+      return engine;
+    } finally {
+      SpotitmlNative.prewarmDestroy(prewarm);
+      callback.close();
+    }
+  }
+
+  // Optimized models live next to the extracted .onnx; the native side keys
+  // entries by model hash, runtime version and options, and prunes stale ones.
+  static String _modelCacheDir() => '${Directory.systemTemp.path}/spotitml_model_cache';
+
+  // Time spent loading the model and warming it up, and whether the optimized
+  // model cache made it a warm (SpotitmlModelCacheState.hit) or cold load.
+  ({double loadMs, double warmupMs, int cacheState}) get loadStats {
+    final stats = calloc<SpotitmlLoadStats>();
+    try {
+      SpotitmlNative.engineLoadStats(_handle, stats);
+      return (loadMs: stats.ref.loadMs, warmupMs: stats.ref.warmupMs, cacheState: stats.ref.cacheState);
+    } finally {
+      calloc.free(stats);
+    }
+  }
+
+  // Stage timings and counters across every engine and worker since the
+  // last resetStats().
+  static PipelineStats stats() {
+    final out = calloc<SpotitmlStats>();
+    try {
+      SpotitmlNative.statsSnapshot(out);
+      return PipelineStats._(out.ref);
+    } finally {
+      calloc.free(out);
+    }
+  }
+
+  static void resetStats() => SpotitmlNative.statsReset();
+
+  // Records per-frame pipeline spans for duration and writes them as Chrome
+  // trace JSON (open in ui.perfetto.dev); returns the file path. Pull it with
+  // e.g. `adb exec-out run-as <app id> cat <path>`.
+  static Future<String> captureTrace(Duration duration, {String? path}) async {
+    final file = path ?? '${Directory.systemTemp.path}/spotitml_trace_${DateTime.now().millisecondsSinceEpoch}.json';
+    if (SpotitmlNative.traceStart(duration.inMilliseconds) != 0) {
+      throw StateError(SpotitmlNative.engineLastError().toDartString());
+    }
+    await Future<void>.delayed(duration);
+    SpotitmlNative.traceStop();
+
+    final pathPtr = file.toNativeUtf8();
+    try {
+      final count = SpotitmlNative.traceWrite(pathPtr);
+      if (count < 0) {
+        throw StateError(SpotitmlNative.engineLastError().toDartString());
+      }
+      developer.log('Wrote $count trace events to $file', name: 'spotitml.ffi');
+      return file;
+    } finally {
+      calloc.free(pathPtr);
+    }
+  }
+
+  // Native log verbosity, a SpotitmlLogLevel value.
+  static void setLogLevel(int level) => SpotitmlNative.logSetLevel(level);
+
+  // Execution providers the session runs on, highest priority first; always
+  // ends with SpotitmlExecutionProvider.cpu.
+  List<int> get activeProviders {
+    final out = calloc<ffi.Int32>(SpotitmlExecutionProvider.maxProviders + 1);
+    try {
+      final count = SpotitmlNative.engineActiveProviders(_handle, out, SpotitmlExecutionProvider.maxProviders + 1);
+      return [for (var i = 0; i < count; i++) out[i]];
+    } finally {
+      calloc.free(out);
+    }
+  }
+
+  // Outcome for every offered model variant: its precision, whether it was
+  // chosen, loaded, skipped or failed, and (under the auto policy) its
+  // measured load and inference times.
+  List<({int precision, int status, double loadMs, double inferenceMs})> get variantReports {
+    final out = calloc<SpotitmlVariantReport>(variantAssets.length);
+    try {
+      final count = SpotitmlNative.engineVariantReports(_handle, out, variantAssets.length);
+      return [
+        for (var i = 0; i < count; i++)
+          (precision: out[i].precision, status: out[i].status, loadMs: out[i].loadMs,
+           inferenceMs: out[i].inferenceMs),
+      ];
+    } finally {
+      calloc.free(out);
+    }
+  }
+
+  // ONNX Runtime needs a file path, but Flutter assets are not files on
+  // every platform, so the models are copied out once per app install.
+  // Variants that were not generated for this build are skipped.
+  static Future<List<({String path, int precision})>> _extractModels() async {
+    final variants = <({String path, int precision})>[];
+    for (final MapEntry(key: asset, value: precision) in variantAssets.entries) {
+      final ByteData data;
+      try {
+        data = await rootBundle.load(asset);
+      } on FlutterError {
+        if (asset == modelAsset) rethrow;
+        continue;
+      }
+      final file = File('${Directory.systemTemp.path}/${asset.split('/').last}');
+      if (!await file.exists() || await file.length() != data.lengthInBytes) {
+        await file.writeAsBytes(data.buffer.asUint8List(data.offsetInBytes, data.lengthInBytes), flush: true);
+      }
+      variants.add((path: file.path, precision: precision));
+    }
+    return variants;
+  }
+
+  // Decodes only the given classes (e.g. COCO person, bird, cat, dog), which
+  // also skips the score rows of every other class; null or empty restores
+  // all classes. Applies to running workers from their next frame.
+  void setClassFilter(List<int>? classIds) {
+    final count = classIds?.length ?? 0;
+    final ids = calloc<ffi.Int32>(count == 0 ? 1 : count);
+    try {
+      for (var i = 0; i < count; i++) {
+        ids[i] = classIds![i];
+      }
+      if (SpotitmlNative.engineSetClassFilter(_handle, ids, count) < 0) {
+        throw StateError(SpotitmlNative.engineLastError().toDartString());
+      }
+    } finally {
+      calloc.free(ids);
+    }
+  }
+
+  // Runs the full native pipeline on a packed RGB frame.
+  DetectionResults detect(ffi.Pointer<ffi.Uint8> rgb, int width, int height) {
+    final count = SpotitmlNative.engineDetect(_handle, rgb, width, height, _detections, maxDetections);
+    if (count < 0) {
+      throw StateError(SpotitmlNative.engineLastError().toDartString());
+    }
+    return DetectionResults._(_detections, count);
+  }
+
+  // Runs the full native pipeline on a camera stream frame. The planes are
+  // handed over as delivered (YUV420 / NV21 / BGRA); color conversion happens
+  // natively inside the letterbox pass. Returns null if no pool buffer is free.
+  DetectionResults? detectCameraImage(CameraImage image) {
+    final index = _stageFrame(image);
+    if (index < 0) {
+      return null;
+    }
+    try {
+      final count = SpotitmlNative.engineDetectFrame(_handle, _frame, _detections, maxDetections);
+      if (count < 0) {
+        throw StateError(SpotitmlNative.engineLastError().toDartString());
+      }
+      return DetectionResults._(_detections, count);
+    } finally {
+      SpotitmlNative.framePoolRelease(_pool, index);
+    }
+  }
+
+  // Whether the model has a dynamic batch axis, so detectCards() runs both
+  // card crops in one inference instead of two.
+  bool get supportsBatch => SpotitmlNative.engineSupportsBatch(_handle) != 0;
+
+  // Two-stage detection on a camera stream frame: the cards are located on a
+  // downsampled copy of the luma and the detector runs on each card's crop,
+  // which keeps far more pixels per symbol than letterboxing the whole frame.
+  // If no card is found the whole frame is one card with score 0. Returns
+  // null if no pool buffer is free.
+  CardResults? detectCards(CameraImage image) {
+    final index = _stageFrame(image);
+    if (index < 0) {
+      return null;
+    }
+    try {
+      final count = SpotitmlNative.engineDetectCards(_handle, _frame, _cards, SpotitmlCards.maxCards);
+      if (count < 0) {
+        throw StateError(SpotitmlNative.engineLastError().toDartString());
+      }
+      return CardResults._(_cards, count);
+    } finally {
+      SpotitmlNative.framePoolRelease(_pool, index);
+    }
+  }
+
+  // Card detection and match finding (REQ-F3.1-F3.3) in one native call: the
+  // two largest cards are detected as in detectCards() and intersected
+  // natively, so no detection list crosses into Dart just to be compared.
+  //
+  // With a Dobble model (class ids = deck symbols), deckDistance enables the
+  // deck model: each card's symbols snap to the nearest real card when at
+  // most deckDistance symbols are missed or spurious, and the answer is the
+  // one symbol those cards share, even if the detector missed it.
+  // Returns null if no pool buffer is free.
+  MatchResult? detectMatch(CameraImage image, {int? deckDistance}) {
+    final index = _stageFrame(image);
+    if (index < 0) {
+      return null;
+    }
+    try {
+      final found = deckDistance == null
+          ? SpotitmlNative.engineDetectMatch(_handle, _frame, _cards, _match)
+          : SpotitmlNative.engineDetectDeckMatch(_handle, _frame, deckDistance, _cards, _match);
+      if (found < 0) {
+        throw StateError(SpotitmlNative.engineLastError().toDartString());
+      }
+      return MatchResult._(CardResults._(_cards, _match.ref.cardCount), found == 1 ? _match.ref : null);
+    } finally {
+      SpotitmlNative.framePoolRelease(_pool, index);
+    }
+  }
+
+  // Writes the camera image's planes into a free pool buffer and describes
+  // them in _frame. Returns the buffer index, which the caller must release
+  // or hand to the worker, or -1 if every buffer is in use (frame dropped).
+  int _stageFrame(CameraImage image) {
+    final format = switch (image.format.group) {
+      ImageFormatGroup.yuv420 => SpotitmlPixelFormat.yuv420,
+      ImageFormatGroup.nv21 => SpotitmlPixelFormat.nv21,
+      ImageFormatGroup.bgra8888 => SpotitmlPixelFormat.bgra,
+      _ => throw UnsupportedError('Unsupported camera format ${image.format.group}'),
+    };
+
+    final planeCount = image.planes.length.clamp(0, 3);
+    var required = 0;
+    for (var i = 0; i < planeCount; i++) {
+      required += _alignPlane(image.planes[i].bytes.length);
+    }
+    _ensurePool(required);
+
+    final index = SpotitmlNative.framePoolAcquire(_pool);
+    if (index < 0) {
+      return -1;
+    }
+    final buffer = SpotitmlNative.framePoolBuffer(_pool, index);
+
+    final frame = _frame.ref;
+    frame.format = format;
+    frame.width = image.width;
+    frame.height = image.height;
+    for (var i = 0; i < 3; i++) {
+      frame.planes[i] = ffi.nullptr;
+      frame.rowStrides[i] = 0;
+      frame.pixelStrides[i] = 0;
+    }
+    var offset = 0;
+    for (var i = 0; i < planeCount; i++) {
+      final plane = image.planes[i];
+      final target = buffer + offset;
+      target.asTypedList(plane.bytes.length).setAll(0, plane.bytes);
+      frame.planes[i] = target;
+      frame.rowStrides[i] = plane.bytesPerRow;
+      frame.pixelStrides[i] = plane.bytesPerPixel ?? 0;
+      offset += _alignPlane(plane.bytes.length);
+    }
+    return index;
+  }
+
+  static int _alignPlane(int bytes) => (bytes + 63) & ~63;
+
+  // The pool is sized from the first frame; the camera keeps its resolution
+  // for the lifetime of a controller. A larger frame gets a new pool, and the
+  // old one is kept until dispose() since the worker may still hold buffers.
+  void _ensurePool(int required) {
+    if (_pool != ffi.nullptr && SpotitmlNative.framePoolBufferSize(_pool) >= required) {
+      return;
+    }
+    final pool = SpotitmlNative.framePoolCreate(framePoolSize, required);
+    if (pool == ffi.nullptr) {
+      throw StateError(SpotitmlNative.engineLastError().toDartString());
+    }
+    if (_pool != ffi.nullptr) {
+      _retiredPools.add(_pool);
+    }
+    _pool = pool;
+  }
+
+  void dispose() {
+    if (_handle != ffi.nullptr) {
+      SpotitmlNative.engineDestroy(_handle);
+      _handle = ffi.nullptr;
+      calloc.free(_detections);
+      calloc.free(_frame);
+      calloc.free(_cards);
+      calloc.free(_match);
+      for (final pool in [..._retiredPools, if (_pool != ffi.nullptr) _pool]) {
+        SpotitmlNative.framePoolDestroy(pool);
+      }
+      _retiredPools.clear();
+      _pool = ffi.nullptr;
+    }
+  }
+}
+
+// Symbol detection through an embedding table instead of the detector's class
+// head: the engine proposes boxes, a small embedding model embeds every crop
+// in one batch, and each crop is named by its nearest table row. Swapping in
+// the table of another deck (loadTable) needs no model rebuild. Tables are
+// written by native/tools/build_embedding_table.py. Dispose the classifier
+// before its engine.
+class SymbolClassifier {
+  final DetectionEngine _engine;
+  ffi.Pointer<SpotitmlClassifier> _handle = ffi.nullptr;
+  final ffi.Pointer<SpotitmlDetection> _detections = calloc<SpotitmlDetection>(DetectionEngine.maxDetections);
+
+  SymbolClassifier(this._engine, {required String modelPath, required String tablePath}) {
+    final model = modelPath.toNativeUtf8();
+    final table = tablePath.toNativeUtf8();
+    try {
+      _handle = SpotitmlNative.classifierCreate(_engine.handle, model, table, ffi.nullptr);
+    } finally {
+      calloc.free(model);
+      calloc.free(table);
+    }
+    if (_handle == ffi.nullptr) {
+      calloc.free(_detections);
+      throw StateError(SpotitmlNative.engineLastError().toDartString());
+    }
+  }
+
+  int get tableSize => SpotitmlNative.classifierTableSize(_handle);
+
+  // Replaces the embedding table; the current one stays if this throws.
+  void loadTable(String tablePath) {
+    final table = tablePath.toNativeUtf8();
+    try {
+      if (SpotitmlNative.classifierLoadTable(_handle, table) < 0) {
+        throw StateError(SpotitmlNative.engineLastError().toDartString());
+      }
+    } finally {
+      calloc.free(table);
+    }
+  }
+
+  // Crops whose cosine similarity to their nearest row is below minSimilarity
+  // are dropped. Returns null if no pool buffer is free.
+  DetectionResults? detectCameraImage(CameraImage image, {double minSimilarity = 0.5}) {
+    final index = _engine._stageFrame(image);
+    if (index < 0) {
+      return null;
+    }
+    try {
+      final count = SpotitmlNative.classifierDetectFrame(
+          _handle, _engine._frame, minSimilarity, _detections, DetectionEngine.maxDetections);
+      if (count < 0) {
+        throw StateError(SpotitmlNative.engineLastError().toDartString());
+      }
+      return DetectionResults._(_detections, count);
+    } finally {
+      SpotitmlNative.framePoolRelease(_engine._pool, index);
+    }
+  }
+
+  void dispose() {
+    if (_handle != ffi.nullptr) {
+      SpotitmlNative.classifierDestroy(_handle);
+      _handle = ffi.nullptr;
+      calloc.free(_detections);
+    }
+  }
+}
+
+// Continuous detection on native background threads. submit() hands a frame
+// to a latest-frame-wins mailbox and returns immediately; onResults is called
+// on the isolate that created the worker whenever a frame finishes.
+// Dispose the worker before its engine (which owns the frame pool).
+class DetectionWorker {
+  final DetectionEngine _engine;
+  final void Function(DetectionResults results, int frameId) onResults;
+  final void Function(Object error)? onError;
+  // Set for tracking workers; receives the tracked boxes with their ids
+  // instead of onResults.
+  final void Function(TrackResults tracks, int frameId)? onTracks;
+
+  late final ffi.NativeCallable<SpotitmlResultCallback> _callback;
+  ffi.Pointer<SpotitmlWorker> _handle = ffi.nullptr;
+  final ffi.Pointer<SpotitmlDetection> _results = calloc<SpotitmlDetection>(DetectionEngine.maxDetections);
+  final ffi.Pointer<ffi.Int64> _frameId = calloc<ffi.Int64>();
+  ffi.Pointer<SpotitmlTrack> _tracks = ffi.nullptr;
+
+  static const int maxTracks = 128;
+
+  // pipelineDepth is the number of frames in flight across the native
+  // preprocess / inference / postprocess stages; 0 picks the native default.
+  //
+  // With tracking, the detector only runs every keyframeInterval frames or
+  // when the picture changes by more than motionThreshold (mean absolute
+  // luma change, 0-255); in between the native side moves the tracked boxes
+  // along their motion, which saves most of the inference work while the
+  // cards lie still. Results then also carry stable track ids (onTracks).
+  DetectionWorker(this._engine,
+      {required this.onResults,
+      this.onError,
+      this.onTracks,
+      int pipelineDepth = 0,
+      bool tracking = false,
+      int? keyframeInterval,
+      double? motionThreshold}) {
+    _callback = ffi.NativeCallable<SpotitmlResultCallback>.listener(_onNativeResult);
+    if (tracking) {
+      final options = calloc<SpotitmlTrackingOptions>();
+      try {
+        SpotitmlNative.workerDefaultTrackingOptions(options);
+        if (keyframeInterval != null) options.ref.keyframeInterval = keyframeInterval;
+        if (motionThreshold != null) options.ref.motionThreshold = motionThreshold;
+        _handle = SpotitmlNative.workerCreateTracked(
+            _engine.handle, pipelineDepth, options, _callback.nativeFunction, ffi.nullptr);
+      } finally {
+        calloc.free(options);
+      }
+      _tracks = calloc<SpotitmlTrack>(maxTracks);
+    } else {
+      _handle = SpotitmlNative.workerCreate(_engine.handle, pipelineDepth, _callback.nativeFunction, ffi.nullptr);
+    }
+    if (_handle == ffi.nullptr) {
+      if (_tracks != ffi.nullptr) calloc.free(_tracks);
+      _callback.close();
+      throw StateError(SpotitmlNative.engineLastError().toDartString());
+    }
+  }
+
+  // Returns the frame id assigned to the submitted frame, or -1 if it was
+  // dropped because every pool buffer is still in flight.
+  int submit(CameraImage image) {
+    final index = _engine._stageFrame(image);
+    if (index < 0) {
+      return -1;
+    }
+    // On success the worker owns the buffer and releases it when done.
+    final frameId = SpotitmlNative.workerSubmitPooled(_handle, _engine._frame, _engine._pool, index);
+    if (frameId < 0) {
+      SpotitmlNative.framePoolRelease(_engine._pool, index);
+      throw StateError(SpotitmlNative.engineLastError().toDartString());
+    }
+    return frameId;
+  }
+
+  int get droppedFrames => SpotitmlNative.workerDroppedFrames(_handle);
+
+  void _onNativeResult(int frameId, int count, ffi.Pointer<ffi.Void> userData) {
+    if (_handle == ffi.nullptr) {
+      return;
+    }
+    // The callback only signals; the newest results are copied out here, so
+    // a slow listener never sees a half-overwritten array.
+    final onTracks = this.onTracks;
+    if (_tracks != ffi.nullptr && onTracks != null) {
+      final count = SpotitmlNative.workerLatestTracks(_handle, _tracks, maxTracks, _frameId);
+      if (count < 0) {
+        onError?.call(StateError(SpotitmlNative.engineLastError().toDartString()));
+        return;
+      }
+      onTracks(TrackResults._(_tracks, count), _frameId.value);
+      return;
+    }
+    final latest = SpotitmlNative.workerLatestResults(_handle, _results, DetectionEngine.maxDetections, _frameId);
+    if (latest < 0) {
+      onError?.call(StateError(SpotitmlNative.engineLastError().toDartString()));
+      return;
+    }
+    onResults(DetectionResults._(_results, latest), _frameId.value);
+  }
+
+  void dispose() {
+    if (_handle != ffi.nullptr) {
+      SpotitmlNative.workerDestroy(_handle);
+      _handle = ffi.nullptr;
+      _callback.close();
+      calloc.free(_results);
+      calloc.free(_frameId);
+      if (_tracks != ffi.nullptr) calloc.free(_tracks);
+    }
+  }
+}
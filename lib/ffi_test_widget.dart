@@ -3,6 +3,7 @@ import 'dart:ffi' as ffi;
 import 'dart:typed_data';
 import 'package:flutter/material.dart';
 import 'package:ffi/ffi.dart';
+import 'detection_engine.dart';
 import 'spotitml_ffi.dart';
 
 class FfiTestWidget extends StatefulWidget {
@@ -14,9 +15,18 @@ class FfiTestWidget extends StatefulWidget {
 
 class _FfiTestWidgetState extends State<FfiTestWidget> {
   String? detectResult;
+  DetectionEngine? _engine;
 
-  void _callFfi() {
+  @override
+  void dispose() {
+    _engine?.dispose();
+    super.dispose();
+  }
+
+  Future<void> _callFfi() async {
     try {
+      _engine ??= await DetectionEngine.load();
+
       developer.log('Starting FFI calls...', name: 'spotitml.ffi');
 
       // Test detect_objects with dummy data
@@ -26,7 +36,7 @@ class _FfiTestWidgetState extends State<FfiTestWidget> {
       try {
         imagePtr.asTypedList(dummyImageData.length).setAll(0, dummyImageData);
         developer.log('Calling detect_objects...', name: 'spotitml.ffi');
-        final detectPtr = SpotitmlNative.detectObjects(imagePtr, 640, 480);
+        final detectPtr = SpotitmlNative.detectObjects(_engine!.handle, imagePtr, 640, 480);
         final detectStr = detectPtr.cast<Utf8>().toDartString();
         print("DEBUG: detect_objects returned: $detectStr");
 
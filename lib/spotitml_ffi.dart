@@ -2,12 +2,380 @@ import 'dart:ffi' as ffi;
 import 'dart:io';
 import 'package:ffi/ffi.dart';
 
+// Opaque native engine handle (spotitml_engine in spotitml_native.h)
+final class SpotitmlEngine extends ffi.Opaque {}
+
+// Opaque native background engine loader (spotitml_prewarm in spotitml_native.h)
+final class SpotitmlPrewarm extends ffi.Opaque {}
+
+// spotitml_ready_callback in spotitml_native.h
+typedef SpotitmlReadyCallback = ffi.Void Function(ffi.Int32 state, ffi.Pointer<ffi.Void> userData);
+
+// Opaque native frame buffer pool (spotitml_frame_pool in spotitml_native.h)
+final class SpotitmlFramePool extends ffi.Opaque {}
+
+// Opaque native worker handle (spotitml_worker in spotitml_native.h)
+final class SpotitmlWorker extends ffi.Opaque {}
+
+// Opaque native embedding classifier (spotitml_classifier in spotitml_native.h)
+final class SpotitmlClassifier extends ffi.Opaque {}
+
+// spotitml_result_callback in spotitml_native.h
+typedef SpotitmlResultCallback = ffi.Void Function(ffi.Int64 frameId, ffi.Int32 count, ffi.Pointer<ffi.Void> userData);
+
+// Mirrors spotitml_engine_options in spotitml_native.h
+final class SpotitmlEngineOptions extends ffi.Struct {
+  @ffi.Int32()
+  external int intraOpThreads;
+
+  @ffi.Int32()
+  external int interOpThreads;
+
+  @ffi.Float()
+  external double scoreThreshold;
+
+  @ffi.Float()
+  external double iouThreshold;
+
+  @ffi.Int32()
+  external int graphOptimization;
+
+  @ffi.Int32()
+  external int executionMode;
+
+  @ffi.Int32()
+  external int enableCpuMemArena;
+
+  @ffi.Int32()
+  external int enableMemPattern;
+
+  @ffi.Int32()
+  external int logSeverity;
+
+  @ffi.Int32()
+  external int providerCount;
+
+  @ffi.Array(SpotitmlExecutionProvider.maxProviders)
+  external ffi.Array<ffi.Int32> providers;
+
+  external ffi.Pointer<Utf8> cacheDir;
+}
+
+// Values of spotitml_model_cache_state in spotitml_native.h
+abstract final class SpotitmlModelCacheState {
+  static const int disabled = 0;
+  static const int miss = 1;
+  static const int hit = 2;
+  static const int bypassed = 3;
+}
+
+// Mirrors spotitml_load_stats in spotitml_native.h
+final class SpotitmlLoadStats extends ffi.Struct {
+  @ffi.Double()
+  external double loadMs;
+
+  @ffi.Double()
+  external double warmupMs;
+
+  @ffi.Int32()
+  external int cacheState;
+}
+
+// Values of spotitml_precision in spotitml_native.h
+abstract final class SpotitmlPrecision {
+  static const int fp32 = 0;
+  static const int fp16 = 1;
+  static const int int8 = 2;
+}
+
+// Values of spotitml_variant_policy in spotitml_native.h
+abstract final class SpotitmlVariantPolicy {
+  static const int fastest = 0;
+  static const int mostAccurate = 1;
+  static const int auto = 2;
+}
+
+// Values of spotitml_variant_status in spotitml_native.h
+abstract final class SpotitmlVariantStatus {
+  static const int failed = -1;
+  static const int skipped = 0;
+  static const int loaded = 1;
+  static const int chosen = 2;
+}
+
+// Mirrors spotitml_model_variant in spotitml_native.h
+final class SpotitmlModelVariant extends ffi.Struct {
+  external ffi.Pointer<Utf8> modelPath;
+
+  @ffi.Int32()
+  external int precision;
+}
+
+// Mirrors spotitml_variant_report in spotitml_native.h
+final class SpotitmlVariantReport extends ffi.Struct {
+  @ffi.Int32()
+  external int precision;
+
+  @ffi.Int32()
+  external int status;
+
+  @ffi.Double()
+  external double loadMs;
+
+  @ffi.Double()
+  external double inferenceMs;
+}
+
+// Values of spotitml_stage in spotitml_native.h
+abstract final class SpotitmlStage {
+  static const int preprocess = 0;
+  static const int inference = 1;
+  static const int decode = 2;
+  static const int nms = 3;
+  static const int frame = 4;
+  static const int locate = 5;
+
+  // SPOTITML_STAGE_COUNT
+  static const int count = 6;
+}
+
+// Mirrors spotitml_stage_stats in spotitml_native.h
+final class SpotitmlStageStats extends ffi.Struct {
+  @ffi.Int64()
+  external int count;
+
+  @ffi.Double()
+  external double meanMs;
+
+  @ffi.Double()
+  external double p50Ms;
+
+  @ffi.Double()
+  external double p95Ms;
+
+  @ffi.Double()
+  external double p99Ms;
+
+  @ffi.Double()
+  external double maxMs;
+}
+
+// Mirrors spotitml_stats in spotitml_native.h
+final class SpotitmlStats extends ffi.Struct {
+  @ffi.Int32()
+  external int enabled;
+
+  @ffi.Int32()
+  external int threads;
+
+  @ffi.Array(SpotitmlStage.count)
+  external ffi.Array<SpotitmlStageStats> stages;
+
+  @ffi.Int64()
+  external int framesSubmitted;
+
+  @ffi.Int64()
+  external int framesDropped;
+
+  @ffi.Int64()
+  external int framesProcessed;
+
+  @ffi.Int64()
+  external int framesFailed;
+
+  @ffi.Int64()
+  external int framesTracked;
+
+  @ffi.Int64()
+  external int candidates;
+
+  @ffi.Int64()
+  external int candidateOverflow;
+
+  @ffi.Int64()
+  external int detections;
+
+  external SpotitmlLoadStats lastLoad;
+}
+
+// Values of spotitml_log_level in spotitml_native.h
+abstract final class SpotitmlLogLevel {
+  static const int debug = 0;
+  static const int info = 1;
+  static const int warn = 2;
+  static const int error = 3;
+  static const int off = 4;
+}
+
+// Values of spotitml_graph_optimization in spotitml_native.h
+abstract final class SpotitmlGraphOptimization {
+  static const int disabled = 0;
+  static const int basic = 1;
+  static const int extended = 2;
+  static const int all = 3;
+}
+
+// Values of spotitml_execution_mode in spotitml_native.h
+abstract final class SpotitmlExecutionMode {
+  static const int sequential = 0;
+  static const int parallel = 1;
+}
+
+// Values of spotitml_execution_provider in spotitml_native.h
+abstract final class SpotitmlExecutionProvider {
+  static const int cpu = 0;
+  static const int xnnpack = 1;
+  static const int nnapi = 2;
+  static const int coreml = 3;
+
+  // SPOTITML_MAX_PROVIDERS
+  static const int maxProviders = 4;
+}
+
+// Values of spotitml_pixel_format in spotitml_native.h
+abstract final class SpotitmlPixelFormat {
+  static const int rgb = 0;
+  static const int bgra = 1;
+  static const int nv21 = 2;
+  static const int yuv420 = 3;
+}
+
+// Mirrors spotitml_frame in spotitml_native.h
+final class SpotitmlFrame extends ffi.Struct {
+  @ffi.Int32()
+  external int format;
+
+  @ffi.Int32()
+  external int width;
+
+  @ffi.Int32()
+  external int height;
+
+  @ffi.Array(3)
+  external ffi.Array<ffi.Pointer<ffi.Uint8>> planes;
+
+  @ffi.Array(3)
+  external ffi.Array<ffi.Int32> rowStrides;
+
+  @ffi.Array(3)
+  external ffi.Array<ffi.Int32> pixelStrides;
+}
+
+// Mirrors spotitml_detection in spotitml_native.h; read in place, no parsing
+final class SpotitmlDetection extends ffi.Struct {
+  @ffi.Float()
+  external double x1;
+
+  @ffi.Float()
+  external double y1;
+
+  @ffi.Float()
+  external double x2;
+
+  @ffi.Float()
+  external double y2;
+
+  @ffi.Float()
+  external double score;
+
+  @ffi.Int32()
+  external int classId;
+}
+
+// SPOTITML_MAX_CARDS and SPOTITML_MAX_CARD_DETECTIONS in spotitml_native.h
+abstract final class SpotitmlCards {
+  static const int maxCards = 2;
+  static const int maxDetections = 32;
+}
+
+// Mirrors spotitml_card_result in spotitml_native.h
+final class SpotitmlCardResult extends ffi.Struct {
+  @ffi.Float()
+  external double x1;
+
+  @ffi.Float()
+  external double y1;
+
+  @ffi.Float()
+  external double x2;
+
+  @ffi.Float()
+  external double y2;
+
+  @ffi.Float()
+  external double score;
+
+  @ffi.Int32()
+  external int detectionCount;
+
+  @ffi.Array(SpotitmlCards.maxDetections)
+  external ffi.Array<SpotitmlDetection> detections;
+}
+
+// Mirrors spotitml_match in spotitml_native.h
+final class SpotitmlMatch extends ffi.Struct {
+  @ffi.Int32()
+  external int classId;
+
+  @ffi.Float()
+  external double score;
+
+  @ffi.Int32()
+  external int sharedCount;
+
+  @ffi.Int32()
+  external int cardCount;
+
+  @ffi.Array(2)
+  external ffi.Array<ffi.Int32> cardCounts;
+
+  @ffi.Array(2)
+  external ffi.Array<ffi.Int32> deckCards;
+
+  @ffi.Array(2)
+  external ffi.Array<SpotitmlDetection> boxes;
+}
+
+// Mirrors spotitml_tracking_options in spotitml_native.h
+final class SpotitmlTrackingOptions extends ffi.Struct {
+  @ffi.Int32()
+  external int keyframeInterval;
+
+  @ffi.Float()
+  external double motionThreshold;
+
+  @ffi.Float()
+  external double iouThreshold;
+
+  @ffi.Int32()
+  external int maxMissed;
+}
+
+// Mirrors spotitml_track in spotitml_native.h
+final class SpotitmlTrack extends ffi.Struct {
+  external SpotitmlDetection detection;
+
+  @ffi.Int32()
+  external int trackId;
+
+  @ffi.Int32()
+  external int hits;
+
+  @ffi.Int32()
+  external int missed;
+
+  @ffi.Int32()
+  external int detected;
+}
+
 // Bindings for the native C++ library
 class SpotitmlNative {
   static final ffi.DynamicLibrary _lib = _open();
 
   static ffi.DynamicLibrary _open() {
-    if (Platform.isMacOS) {
+    if (Platform.isAndroid) {
+      return ffi.DynamicLibrary.open('libspotitml_native.so');
+    } else if (Platform.isMacOS) {
       return ffi.DynamicLibrary.open('libspotitml_native.dylib');
     } else if (Platform.isLinux) {
       return ffi.DynamicLibrary.open('libspotitml_native.so');
@@ -18,8 +386,256 @@ class SpotitmlNative {
     }
   }
 
-  // Phase 1b: Simplified to only detect_objects function
+  // Engine lifecycle: create once, run many times, destroy
+  static final engineDefaultOptions = _lib
+      .lookupFunction<ffi.Void Function(ffi.Pointer<SpotitmlEngineOptions>),
+                      void Function(ffi.Pointer<SpotitmlEngineOptions>)>('engine_default_options');
+
+  static final engineCreate = _lib
+      .lookupFunction<ffi.Pointer<SpotitmlEngine> Function(ffi.Pointer<Utf8>, ffi.Pointer<SpotitmlEngineOptions>),
+                      ffi.Pointer<SpotitmlEngine> Function(ffi.Pointer<Utf8>, ffi.Pointer<SpotitmlEngineOptions>)>('engine_create');
+
+  static final engineActiveProviders = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<ffi.Int32>, ffi.Int32),
+                      int Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<ffi.Int32>, int)>('engine_active_providers');
+
+  // Background creation + warm-up; completes through a ready callback
+  static final enginePrewarm = _lib
+      .lookupFunction<ffi.Pointer<SpotitmlPrewarm> Function(ffi.Pointer<Utf8>, ffi.Pointer<SpotitmlEngineOptions>,
+                                                            ffi.Int32,
+                                                            ffi.Pointer<ffi.NativeFunction<SpotitmlReadyCallback>>,
+                                                            ffi.Pointer<ffi.Void>),
+                      ffi.Pointer<SpotitmlPrewarm> Function(ffi.Pointer<Utf8>, ffi.Pointer<SpotitmlEngineOptions>, int,
+                                                            ffi.Pointer<ffi.NativeFunction<SpotitmlReadyCallback>>,
+                                                            ffi.Pointer<ffi.Void>)>('engine_prewarm');
+
+  static final enginePrewarmVariant = _lib
+      .lookupFunction<ffi.Pointer<SpotitmlPrewarm> Function(ffi.Pointer<SpotitmlModelVariant>, ffi.Int32, ffi.Int32,
+                                                            ffi.Int32, ffi.Pointer<SpotitmlEngineOptions>, ffi.Int32,
+                                                            ffi.Pointer<ffi.NativeFunction<SpotitmlReadyCallback>>,
+                                                            ffi.Pointer<ffi.Void>),
+                      ffi.Pointer<SpotitmlPrewarm> Function(ffi.Pointer<SpotitmlModelVariant>, int, int, int,
+                                                            ffi.Pointer<SpotitmlEngineOptions>, int,
+                                                            ffi.Pointer<ffi.NativeFunction<SpotitmlReadyCallback>>,
+                                                            ffi.Pointer<ffi.Void>)>('engine_prewarm_variant');
+
+  static final prewarmTakeEngine = _lib
+      .lookupFunction<ffi.Pointer<SpotitmlEngine> Function(ffi.Pointer<SpotitmlPrewarm>),
+                      ffi.Pointer<SpotitmlEngine> Function(ffi.Pointer<SpotitmlPrewarm>)>('prewarm_take_engine');
+
+  static final prewarmDestroy = _lib
+      .lookupFunction<ffi.Void Function(ffi.Pointer<SpotitmlPrewarm>),
+                      void Function(ffi.Pointer<SpotitmlPrewarm>)>('prewarm_destroy');
+
+  static final engineLoadStats = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<SpotitmlLoadStats>),
+                      int Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<SpotitmlLoadStats>)>('engine_load_stats');
+
+  static final engineVariantReports = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<SpotitmlVariantReport>, ffi.Int32),
+                      int Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<SpotitmlVariantReport>, int)>('engine_variant_reports');
+
+  static final engineDetect = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<ffi.Uint8>, ffi.Int32, ffi.Int32,
+                                         ffi.Pointer<SpotitmlDetection>, ffi.Int32),
+                      int Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<ffi.Uint8>, int, int,
+                                   ffi.Pointer<SpotitmlDetection>, int)>('engine_detect');
+
+  static final engineDetectFrame = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<SpotitmlFrame>,
+                                         ffi.Pointer<SpotitmlDetection>, ffi.Int32),
+                      int Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<SpotitmlFrame>,
+                                   ffi.Pointer<SpotitmlDetection>, int)>('engine_detect_frame');
+
+  static final engineSetClassFilter = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<ffi.Int32>, ffi.Int32),
+                      int Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<ffi.Int32>, int)>(
+          'engine_set_class_filter');
+
+  static final engineDetectBatch = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<SpotitmlFrame>, ffi.Int32,
+                                         ffi.Pointer<SpotitmlDetection>, ffi.Int32, ffi.Pointer<ffi.Int32>),
+                      int Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<SpotitmlFrame>, int,
+                                   ffi.Pointer<SpotitmlDetection>, int, ffi.Pointer<ffi.Int32>)>('engine_detect_batch');
+
+  static final engineSupportsBatch = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlEngine>),
+                      int Function(ffi.Pointer<SpotitmlEngine>)>('engine_supports_batch');
+
+  static final engineDetectCards = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<SpotitmlFrame>,
+                                         ffi.Pointer<SpotitmlCardResult>, ffi.Int32),
+                      int Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<SpotitmlFrame>,
+                                   ffi.Pointer<SpotitmlCardResult>, int)>('engine_detect_cards');
+
+  static final findMatch = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlDetection>, ffi.Int32, ffi.Pointer<ffi.Float>,
+                                         ffi.Pointer<ffi.Float>, ffi.Pointer<SpotitmlMatch>),
+                      int Function(ffi.Pointer<SpotitmlDetection>, int, ffi.Pointer<ffi.Float>,
+                                   ffi.Pointer<ffi.Float>, ffi.Pointer<SpotitmlMatch>)>('find_match');
+
+  static final engineDetectMatch = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<SpotitmlFrame>,
+                                         ffi.Pointer<SpotitmlCardResult>, ffi.Pointer<SpotitmlMatch>),
+                      int Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<SpotitmlFrame>,
+                                   ffi.Pointer<SpotitmlCardResult>, ffi.Pointer<SpotitmlMatch>)>('engine_detect_match');
+
+  static final deckCardSymbols = _lib
+      .lookupFunction<ffi.Uint64 Function(ffi.Int32), int Function(int)>('deck_card_symbols');
+
+  static final deckSnap = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Uint64, ffi.Int32, ffi.Pointer<ffi.Int32>),
+                      int Function(int, int, ffi.Pointer<ffi.Int32>)>('deck_snap');
+
+  static final deckSharedSymbol = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Int32, ffi.Int32), int Function(int, int)>('deck_shared_symbol');
+
+  static final findDeckMatch = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlDetection>, ffi.Int32, ffi.Pointer<ffi.Float>,
+                                         ffi.Pointer<ffi.Float>, ffi.Int32, ffi.Pointer<SpotitmlMatch>),
+                      int Function(ffi.Pointer<SpotitmlDetection>, int, ffi.Pointer<ffi.Float>,
+                                   ffi.Pointer<ffi.Float>, int, ffi.Pointer<SpotitmlMatch>)>('find_deck_match');
+
+  static final engineDetectDeckMatch = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<SpotitmlFrame>, ffi.Int32,
+                                         ffi.Pointer<SpotitmlCardResult>, ffi.Pointer<SpotitmlMatch>),
+                      int Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<SpotitmlFrame>, int,
+                                   ffi.Pointer<SpotitmlCardResult>, ffi.Pointer<SpotitmlMatch>)>('engine_detect_deck_match');
+
+  static final classifierCreate = _lib
+      .lookupFunction<ffi.Pointer<SpotitmlClassifier> Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<Utf8>,
+                                                               ffi.Pointer<Utf8>, ffi.Pointer<SpotitmlEngineOptions>),
+                      ffi.Pointer<SpotitmlClassifier> Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<Utf8>,
+                                                               ffi.Pointer<Utf8>, ffi.Pointer<SpotitmlEngineOptions>)>(
+          'classifier_create');
+
+  static final classifierLoadTable = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlClassifier>, ffi.Pointer<Utf8>),
+                      int Function(ffi.Pointer<SpotitmlClassifier>, ffi.Pointer<Utf8>)>('classifier_load_table');
+
+  static final classifierTableSize = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlClassifier>),
+                      int Function(ffi.Pointer<SpotitmlClassifier>)>('classifier_table_size');
+
+  static final classifierDetectFrame = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlClassifier>, ffi.Pointer<SpotitmlFrame>, ffi.Float,
+                                         ffi.Pointer<SpotitmlDetection>, ffi.Int32),
+                      int Function(ffi.Pointer<SpotitmlClassifier>, ffi.Pointer<SpotitmlFrame>, double,
+                                   ffi.Pointer<SpotitmlDetection>, int)>('classifier_detect_frame');
+
+  static final classifierDestroy = _lib
+      .lookupFunction<ffi.Void Function(ffi.Pointer<SpotitmlClassifier>),
+                      void Function(ffi.Pointer<SpotitmlClassifier>)>('classifier_destroy');
+
+  static final engineDestroy = _lib
+      .lookupFunction<ffi.Void Function(ffi.Pointer<SpotitmlEngine>),
+                      void Function(ffi.Pointer<SpotitmlEngine>)>('engine_destroy');
+
+  // Aligned frame buffers that camera planes are written into directly
+  static final framePoolCreate = _lib
+      .lookupFunction<ffi.Pointer<SpotitmlFramePool> Function(ffi.Int32, ffi.Int64),
+                      ffi.Pointer<SpotitmlFramePool> Function(int, int)>('frame_pool_create');
+
+  static final framePoolAcquire = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlFramePool>),
+                      int Function(ffi.Pointer<SpotitmlFramePool>)>('frame_pool_acquire');
+
+  static final framePoolRelease = _lib
+      .lookupFunction<ffi.Void Function(ffi.Pointer<SpotitmlFramePool>, ffi.Int32),
+                      void Function(ffi.Pointer<SpotitmlFramePool>, int)>('frame_pool_release');
+
+  static final framePoolBuffer = _lib
+      .lookupFunction<ffi.Pointer<ffi.Uint8> Function(ffi.Pointer<SpotitmlFramePool>, ffi.Int32),
+                      ffi.Pointer<ffi.Uint8> Function(ffi.Pointer<SpotitmlFramePool>, int)>('frame_pool_buffer');
+
+  static final framePoolBufferSize = _lib
+      .lookupFunction<ffi.Int64 Function(ffi.Pointer<SpotitmlFramePool>),
+                      int Function(ffi.Pointer<SpotitmlFramePool>)>('frame_pool_buffer_size');
+
+  static final framePoolDestroy = _lib
+      .lookupFunction<ffi.Void Function(ffi.Pointer<SpotitmlFramePool>),
+                      void Function(ffi.Pointer<SpotitmlFramePool>)>('frame_pool_destroy');
+
+  // Background worker with a latest-frame-wins mailbox
+  static final workerCreate = _lib
+      .lookupFunction<ffi.Pointer<SpotitmlWorker> Function(ffi.Pointer<SpotitmlEngine>, ffi.Int32,
+                                                           ffi.Pointer<ffi.NativeFunction<SpotitmlResultCallback>>,
+                                                           ffi.Pointer<ffi.Void>),
+                      ffi.Pointer<SpotitmlWorker> Function(ffi.Pointer<SpotitmlEngine>, int,
+                                                           ffi.Pointer<ffi.NativeFunction<SpotitmlResultCallback>>,
+                                                           ffi.Pointer<ffi.Void>)>('worker_create');
+
+  static final workerDefaultTrackingOptions = _lib
+      .lookupFunction<ffi.Void Function(ffi.Pointer<SpotitmlTrackingOptions>),
+                      void Function(ffi.Pointer<SpotitmlTrackingOptions>)>('worker_default_tracking_options');
+
+  static final workerCreateTracked = _lib
+      .lookupFunction<ffi.Pointer<SpotitmlWorker> Function(ffi.Pointer<SpotitmlEngine>, ffi.Int32,
+                                                           ffi.Pointer<SpotitmlTrackingOptions>,
+                                                           ffi.Pointer<ffi.NativeFunction<SpotitmlResultCallback>>,
+                                                           ffi.Pointer<ffi.Void>),
+                      ffi.Pointer<SpotitmlWorker> Function(ffi.Pointer<SpotitmlEngine>, int,
+                                                           ffi.Pointer<SpotitmlTrackingOptions>,
+                                                           ffi.Pointer<ffi.NativeFunction<SpotitmlResultCallback>>,
+                                                           ffi.Pointer<ffi.Void>)>('worker_create_tracked');
+
+  static final workerLatestTracks = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlWorker>, ffi.Pointer<SpotitmlTrack>, ffi.Int32,
+                                         ffi.Pointer<ffi.Int64>),
+                      int Function(ffi.Pointer<SpotitmlWorker>, ffi.Pointer<SpotitmlTrack>, int,
+                                   ffi.Pointer<ffi.Int64>)>('worker_latest_tracks');
+
+  static final workerSubmit = _lib
+      .lookupFunction<ffi.Int64 Function(ffi.Pointer<SpotitmlWorker>, ffi.Pointer<SpotitmlFrame>),
+                      int Function(ffi.Pointer<SpotitmlWorker>, ffi.Pointer<SpotitmlFrame>)>('worker_submit');
+
+  static final workerSubmitPooled = _lib
+      .lookupFunction<ffi.Int64 Function(ffi.Pointer<SpotitmlWorker>, ffi.Pointer<SpotitmlFrame>,
+                                         ffi.Pointer<SpotitmlFramePool>, ffi.Int32),
+                      int Function(ffi.Pointer<SpotitmlWorker>, ffi.Pointer<SpotitmlFrame>,
+                                   ffi.Pointer<SpotitmlFramePool>, int)>('worker_submit_pooled');
+
+  static final workerLatestResults = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlWorker>, ffi.Pointer<SpotitmlDetection>, ffi.Int32,
+                                         ffi.Pointer<ffi.Int64>),
+                      int Function(ffi.Pointer<SpotitmlWorker>, ffi.Pointer<SpotitmlDetection>, int,
+                                   ffi.Pointer<ffi.Int64>)>('worker_latest_results');
+
+  static final workerDroppedFrames = _lib
+      .lookupFunction<ffi.Int64 Function(ffi.Pointer<SpotitmlWorker>),
+                      int Function(ffi.Pointer<SpotitmlWorker>)>('worker_dropped_frames');
+
+  static final workerDestroy = _lib
+      .lookupFunction<ffi.Void Function(ffi.Pointer<SpotitmlWorker>),
+                      void Function(ffi.Pointer<SpotitmlWorker>)>('worker_destroy');
+
+  // Process-wide stage timings and counters, and native log verbosity
+  static final statsSnapshot = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Pointer<SpotitmlStats>),
+                      int Function(ffi.Pointer<SpotitmlStats>)>('stats_snapshot');
+
+  static final statsReset = _lib
+      .lookupFunction<ffi.Void Function(), void Function()>('stats_reset');
+
+  // Chrome trace-event capture of per-frame pipeline spans
+  static final traceStart = _lib
+      .lookupFunction<ffi.Int32 Function(ffi.Int32), int Function(int)>('trace_start');
+
+  static final traceStop = _lib
+      .lookupFunction<ffi.Void Function(), void Function()>('trace_stop');
+
+  static final traceWrite = _lib
+      .lookupFunction<ffi.Int64 Function(ffi.Pointer<Utf8>), int Function(ffi.Pointer<Utf8>)>('trace_write');
+
+  static final logSetLevel = _lib
+      .lookupFunction<ffi.Void Function(ffi.Int32), void Function(int)>('log_set_level');
+
+  static final engineLastError = _lib
+      .lookupFunction<ffi.Pointer<Utf8> Function(),
+                      ffi.Pointer<Utf8> Function()>('engine_last_error');
+
+  // Phase 1b: detect_objects on a prepared engine
   static final detectObjects = _lib
-      .lookupFunction<ffi.Pointer<Utf8> Function(ffi.Pointer<ffi.Uint8>, ffi.Int32, ffi.Int32), 
-                      ffi.Pointer<Utf8> Function(ffi.Pointer<ffi.Uint8>, int, int)>('detect_objects');
+      .lookupFunction<ffi.Pointer<Utf8> Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<ffi.Uint8>, ffi.Int32, ffi.Int32), 
+                      ffi.Pointer<Utf8> Function(ffi.Pointer<SpotitmlEngine>, ffi.Pointer<ffi.Uint8>, int, int)>('detect_objects');
 }
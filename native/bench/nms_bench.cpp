@@ -0,0 +1,61 @@
+// NMS microbenchmark: reports ns per input candidate for synthetic,
+// clustered candidate sets resembling a cluttered Dobble card.
+
+#include "nms.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using spotitml::Candidate;
+using spotitml::Nms;
+
+namespace {
+
+// Roughly ten jittered boxes per symbol, as the YOLOv8 head produces around
+// each true object.
+std::vector<Candidate> make_candidates(int count, int classes, std::mt19937& rng) {
+    std::uniform_real_distribution<float> position(0.0f, 600.0f);
+    std::uniform_real_distribution<float> size(20.0f, 80.0f);
+    std::normal_distribution<float> jitter(0.0f, 3.0f);
+    std::uniform_real_distribution<float> score(0.25f, 1.0f);
+    std::uniform_int_distribution<int> class_id(0, classes - 1);
+
+    std::vector<Candidate> candidates;
+    candidates.reserve(count);
+    while (static_cast<int>(candidates.size()) < count) {
+        const float x = position(rng), y = position(rng), w = size(rng), h = size(rng);
+        const int cls = class_id(rng);
+        for (int k = 0; k < 10 && static_cast<int>(candidates.size()) < count; ++k) {
+            const float x1 = x + jitter(rng), y1 = y + jitter(rng);
+            candidates.push_back({x1, y1, x1 + w + jitter(rng), y1 + h + jitter(rng), score(rng), cls});
+        }
+    }
+    return candidates;
+}
+
+} // namespace
+
+int main() {
+    constexpr int kIterations = 2000;
+    constexpr float kIouThreshold = 0.45f;
+    std::mt19937 rng(42);
+
+    std::printf("%10s %10s %12s %12s\n", "candidates", "kept", "us/run", "ns/candidate");
+    for (int count : {50, 100, 300, 1000, 2000, 8400}) {
+        const auto candidates = make_candidates(count, 57, rng);
+        Nms nms;
+
+        int kept = nms.run(candidates.data(), count, kIouThreshold);
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kIterations; ++i) {
+            kept = nms.run(candidates.data(), count, kIouThreshold);
+        }
+        const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                          kIterations;
+
+        std::printf("%10d %10d %12.2f %12.2f\n", count, kept, ns / 1000.0, ns / count);
+    }
+    return 0;
+}
@@ -0,0 +1,639 @@
+// End-to-end pipeline benchmark: runs ingest, preprocess, inference, decode
+// and NMS over camera-like frames on the CPU provider and reports per-stage
+// latency percentiles, throughput, peak RSS and heap allocations per frame.
+//
+//   spotitml_bench --model yolov8n.onnx [--images DIR | --synthetic]
+//                  [--frames 200] [--warmup 10] [--format nv21|bgra|rgb]
+//                  [--width 1280] [--height 720] [--threads 0]
+//                  [--cache-dir DIR] [--json report.json] [--check-allocs]
+//                  [--batch N]
+//
+// Images are binary PPM (P6) files, so the benchmark needs no image codec;
+// convert samples with e.g. `convert card.jpg card.ppm`. They are fed as RGB
+// frames at their own size. Without --images a deterministic synthetic
+// generator renders NV21 (or --format) frames of disc-shaped "symbols".
+//
+// Ingest is the copy of the camera planes into a frame pool buffer, as the
+// app does; the remaining stages are exactly what a DetectionWorker runs.
+//
+// --check-allocs exits with status 3 if ingest, preprocess, decode or NMS
+// touched the heap during the measured frames; those stages must run out of
+// buffers sized up front. Inference is exempt since ONNX Runtime owns it.
+//
+// --batch N also times N frames through Engine::detect_batch against the same
+// N frames through detect() one by one. Batching only happens for models
+// exported with a dynamic batch axis; otherwise both numbers match.
+
+#include "engine.h"
+#include "frame_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+using namespace spotitml;
+
+// Counts every operator new made anywhere in the process (ONNX Runtime
+// included) so steady-state allocations per stage show up. ORT's arenas call
+// malloc directly and are not counted; they are reflected in peak RSS.
+static std::atomic<uint64_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// Frame pool and scratch arena blocks are over-aligned.
+void* operator new(size_t size, std::align_val_t alignment) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    const size_t align = static_cast<size_t>(alignment);
+    if (void* p = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum Stage { kIngest, kPreprocess, kInference, kDecode, kNms, kTotal, kStageCount };
+const char* const kStageNames[kStageCount] = {"ingest", "preprocess", "inference", "decode", "nms", "total"};
+
+struct Config {
+    std::string model;
+    std::string images;
+    std::string json;
+    std::string cache_dir;
+    int frames = 200;
+    int warmup = 10;
+    int width = 1280;
+    int height = 720;
+    int threads = 0;
+    int batch = 0;
+    int32_t format = SPOTITML_FORMAT_NV21;
+    bool check_allocs = false;
+};
+
+// A frame's planes packed back to back, with the strides a camera would report.
+struct SourceFrame {
+    std::vector<uint8_t> data;
+    spotitml_frame frame{};
+};
+
+[[noreturn]] void usage(const char* error) {
+    std::fprintf(stderr, "spotitml_bench: %s\n", error);
+    std::fprintf(stderr,
+                 "usage: spotitml_bench --model PATH [--images DIR | --synthetic] [--frames N] [--warmup N]\n"
+                 "                      [--format nv21|bgra|rgb] [--width W] [--height H] [--threads N]\n"
+                 "                      [--cache-dir DIR] [--json PATH] [--check-allocs] [--batch N]\n");
+    std::exit(2);
+}
+
+Config parse_args(int argc, char** argv) {
+    Config config;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--synthetic") {
+            config.images.clear();
+            continue;
+        }
+        if (arg == "--check-allocs") {
+            config.check_allocs = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage(("missing value for " + arg).c_str());
+        }
+        const std::string value = argv[++i];
+        if (arg == "--model") {
+            config.model = value;
+        } else if (arg == "--images") {
+            config.images = value;
+        } else if (arg == "--json") {
+            config.json = value;
+        } else if (arg == "--cache-dir") {
+            config.cache_dir = value;
+        } else if (arg == "--frames") {
+            config.frames = std::atoi(value.c_str());
+        } else if (arg == "--warmup") {
+            config.warmup = std::atoi(value.c_str());
+        } else if (arg == "--width") {
+            config.width = std::atoi(value.c_str());
+        } else if (arg == "--height") {
+            config.height = std::atoi(value.c_str());
+        } else if (arg == "--threads") {
+            config.threads = std::atoi(value.c_str());
+        } else if (arg == "--batch") {
+            config.batch = std::atoi(value.c_str());
+        } else if (arg == "--format") {
+            if (value == "nv21") {
+                config.format = SPOTITML_FORMAT_NV21;
+            } else if (value == "bgra") {
+                config.format = SPOTITML_FORMAT_BGRA;
+            } else if (value == "rgb") {
+                config.format = SPOTITML_FORMAT_RGB;
+            } else {
+                usage(("unknown format " + value).c_str());
+            }
+        } else {
+            usage(("unknown argument " + arg).c_str());
+        }
+    }
+    if (config.model.empty()) {
+        usage("--model is required");
+    }
+    if (config.frames <= 0 || config.width <= 1 || config.height <= 1) {
+        usage("frames, width and height must be positive");
+    }
+    return config;
+}
+
+// Points frame.planes at data, laid out for the frame's format.
+void describe_planes(SourceFrame& source) {
+    spotitml_frame& f = source.frame;
+    f.planes[0] = source.data.data();
+    switch (f.format) {
+    case SPOTITML_FORMAT_RGB:
+        f.row_strides[0] = f.width * 3;
+        break;
+    case SPOTITML_FORMAT_BGRA:
+        f.row_strides[0] = f.width * 4;
+        break;
+    case SPOTITML_FORMAT_NV21:
+        f.row_strides[0] = f.width;
+        f.planes[1] = source.data.data() + static_cast<size_t>(f.width) * f.height;
+        f.row_strides[1] = (f.width + 1) / 2 * 2;
+        break;
+    }
+}
+
+size_t packed_size(int32_t format, int width, int height) {
+    const size_t pixels = static_cast<size_t>(width) * height;
+    switch (format) {
+    case SPOTITML_FORMAT_RGB:
+        return pixels * 3;
+    case SPOTITML_FORMAT_BGRA:
+        return pixels * 4;
+    default:
+        return pixels + static_cast<size_t>((width + 1) / 2 * 2) * ((height + 1) / 2);
+    }
+}
+
+// A light card on a darker table with eight colored discs; seeded, so
+// every run (and every machine) sees the same frames.
+SourceFrame make_synthetic(const Config& config, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> channel(0, 255);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    const int w = config.width;
+    const int h = config.height;
+    std::vector<uint8_t> rgb(static_cast<size_t>(w) * h * 3);
+    const float card_x = w * (0.4f + 0.2f * unit(rng));
+    const float card_y = h * (0.4f + 0.2f * unit(rng));
+    const float card_r = 0.45f * std::min(w, h);
+
+    struct Disc {
+        float x, y, r;
+        uint8_t color[3];
+    };
+    std::vector<Disc> discs(8);
+    for (Disc& d : discs) {
+        const float angle = 6.2831853f * unit(rng);
+        const float distance = card_r * 0.7f * unit(rng);
+        d = {card_x + distance * std::cos(angle), card_y + distance * std::sin(angle), card_r * (0.1f + 0.12f * unit(rng)),
+             {static_cast<uint8_t>(channel(rng)), static_cast<uint8_t>(channel(rng)),
+              static_cast<uint8_t>(channel(rng))}};
+    }
+
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            uint8_t* px = &rgb[(static_cast<size_t>(y) * w + x) * 3];
+            const float dx = x - card_x, dy = y - card_y;
+            const bool on_card = dx * dx + dy * dy < card_r * card_r;
+            px[0] = px[1] = px[2] = on_card ? 235 : 70;
+            for (const Disc& d : discs) {
+                const float ex = x - d.x, ey = y - d.y;
+                if (ex * ex + ey * ey < d.r * d.r) {
+                    std::memcpy(px, d.color, 3);
+                }
+            }
+        }
+    }
+
+    SourceFrame source;
+    source.frame.format = config.format;
+    source.frame.width = w;
+    source.frame.height = h;
+    source.data.resize(packed_size(config.format, w, h));
+    if (config.format == SPOTITML_FORMAT_RGB) {
+        source.data = std::move(rgb);
+    } else if (config.format == SPOTITML_FORMAT_BGRA) {
+        for (size_t i = 0, n = static_cast<size_t>(w) * h; i < n; ++i) {
+            source.data[i * 4 + 0] = rgb[i * 3 + 2];
+            source.data[i * 4 + 1] = rgb[i * 3 + 1];
+            source.data[i * 4 + 2] = rgb[i * 3 + 0];
+            source.data[i * 4 + 3] = 255;
+        }
+    } else {
+        // Full-range BT.601, matching what the preprocessor inverts.
+        uint8_t* luma = source.data.data();
+        uint8_t* vu = luma + static_cast<size_t>(w) * h;
+        const size_t vu_stride = (w + 1) / 2 * 2;
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                const uint8_t* px = &rgb[(static_cast<size_t>(y) * w + x) * 3];
+                const float r = px[0], g = px[1], b = px[2];
+                luma[static_cast<size_t>(y) * w + x] =
+                    static_cast<uint8_t>(std::clamp(0.299f * r + 0.587f * g + 0.114f * b, 0.0f, 255.0f));
+                if ((x & 1) == 0 && (y & 1) == 0) {
+                    uint8_t* out = &vu[static_cast<size_t>(y / 2) * vu_stride + x];
+                    out[0] = static_cast<uint8_t>(std::clamp(128.0f + 0.5f * r - 0.4187f * g - 0.0813f * b, 0.0f, 255.0f));
+                    out[1] = static_cast<uint8_t>(std::clamp(128.0f - 0.1687f * r - 0.3313f * g + 0.5f * b, 0.0f, 255.0f));
+                }
+            }
+        }
+    }
+    describe_planes(source);
+    return source;
+}
+
+// Binary PPM (P6, maxval 255) as an RGB frame.
+SourceFrame load_ppm(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::string magic;
+    int width = 0, height = 0, maxval = 0;
+    in >> magic;
+    // Skip comments between header fields.
+    const auto next_int = [&in](int& value) {
+        in >> std::ws;
+        while (in.peek() == '#') {
+            in.ignore(1 << 20, '\n');
+            in >> std::ws;
+        }
+        in >> value;
+    };
+    next_int(width);
+    next_int(height);
+    next_int(maxval);
+    in.get();
+    if (!in || magic != "P6" || maxval != 255 || width <= 1 || height <= 1) {
+        throw std::runtime_error(path + ": not an 8-bit binary PPM");
+    }
+
+    SourceFrame source;
+    source.frame.format = SPOTITML_FORMAT_RGB;
+    source.frame.width = width;
+    source.frame.height = height;
+    source.data.resize(packed_size(SPOTITML_FORMAT_RGB, width, height));
+    if (!in.read(reinterpret_cast<char*>(source.data.data()), static_cast<std::streamsize>(source.data.size()))) {
+        throw std::runtime_error(path + ": truncated");
+    }
+    describe_planes(source);
+    return source;
+}
+
+std::vector<SourceFrame> load_sources(const Config& config) {
+    std::vector<SourceFrame> sources;
+    if (config.images.empty()) {
+        // Enough distinct frames that nothing is trivially cache-resident.
+        for (uint32_t seed = 0; seed < 8; ++seed) {
+            sources.push_back(make_synthetic(config, seed));
+        }
+        return sources;
+    }
+
+    std::vector<std::string> paths;
+    if (DIR* dir = opendir(config.images.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            const std::string name = entry->d_name;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".ppm") == 0) {
+                paths.push_back(config.images + "/" + name);
+            }
+        }
+        closedir(dir);
+    }
+    if (paths.empty()) {
+        throw std::runtime_error("no .ppm images in " + config.images);
+    }
+    std::sort(paths.begin(), paths.end());
+    for (const std::string& path : paths) {
+        sources.push_back(load_ppm(path));
+    }
+    return sources;
+}
+
+struct Summary {
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+// Nearest-rank percentiles.
+Summary summarize(std::vector<double> samples) {
+    Summary s;
+    if (samples.empty()) {
+        return s;
+    }
+    std::sort(samples.begin(), samples.end());
+    const auto rank = [&samples](double p) {
+        const size_t index = static_cast<size_t>(std::ceil(p * samples.size()));
+        return samples[std::min(samples.size(), std::max<size_t>(index, 1)) - 1];
+    };
+    for (double v : samples) {
+        s.mean += v;
+    }
+    s.mean /= samples.size();
+    s.p50 = rank(0.50);
+    s.p95 = rank(0.95);
+    s.p99 = rank(0.99);
+    s.max = samples.back();
+    return s;
+}
+
+long peak_rss_kb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;  // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+// Writes text as the body of a JSON string, as trace_write() does; control
+// characters are \u-escaped too.
+void write_escaped(FILE* out, const char* text) {
+    for (; *text != '\0'; ++text) {
+        const unsigned char c = static_cast<unsigned char>(*text);
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', out);
+            std::fputc(c, out);
+        } else if (c < 0x20) {
+            std::fprintf(out, "\\u%04x", c);
+        } else {
+            std::fputc(c, out);
+        }
+    }
+}
+
+const char* format_name(int32_t format) {
+    switch (format) {
+    case SPOTITML_FORMAT_RGB:
+        return "rgb";
+    case SPOTITML_FORMAT_BGRA:
+        return "bgra";
+    default:
+        return "nv21";
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const Config config = parse_args(argc, argv);
+
+    std::vector<SourceFrame> sources;
+    spotitml_engine_options options;
+    engine_default_options(&options);
+    options.intra_op_threads = config.threads;
+    options.cache_dir = config.cache_dir.empty() ? nullptr : config.cache_dir.c_str();
+
+    try {
+        sources = load_sources(config);
+        size_t largest = 0;
+        for (const SourceFrame& s : sources) {
+            largest = std::max(largest, s.data.size());
+        }
+
+        const long rss_before_load = peak_rss_kb();
+        Engine engine(config.model.c_str(), options);
+        engine.warm_up(config.warmup);
+
+        FramePool pool(1, largest);
+        InferenceBuffers buffers = engine.create_buffers();
+        Preprocessor preprocessor;
+        Decoder decoder;
+        Nms nms;
+        std::vector<spotitml_detection> detections(100);
+        const int channels = static_cast<int>(engine.output_shape()[1]);
+        const int anchors = static_cast<int>(engine.output_shape()[2]);
+
+        std::vector<double> samples[kStageCount];
+        uint64_t allocations[kStageCount] = {};
+        uint64_t detection_total = 0;
+
+        // One frame through every stage; the first sources.size() frames of
+        // the warm-up pass fill preprocessor tables for each frame size.
+        const auto run_frame = [&](const SourceFrame& source, bool record) {
+            Clock::time_point marks[kStageCount];
+            uint64_t counts[kStageCount];
+            const auto mark = [&](int stage) {
+                marks[stage] = Clock::now();
+                counts[stage] = g_allocations.load(std::memory_order_relaxed);
+            };
+            const Clock::time_point start = Clock::now();
+            const uint64_t start_count = g_allocations.load(std::memory_order_relaxed);
+
+            const int index = pool.acquire();
+            std::memcpy(pool.buffer(index), source.data.data(), source.data.size());
+            spotitml_frame frame = source.frame;
+            const ptrdiff_t offset = pool.buffer(index) - source.data.data();
+            for (const uint8_t*& plane : frame.planes) {
+                if (plane != nullptr) {
+                    plane += offset;
+                }
+            }
+            mark(kIngest);
+            engine.preprocess(frame, preprocessor, buffers);
+            pool.release(index);
+            mark(kPreprocess);
+            engine.infer(buffers);
+            mark(kInference);
+            decoder.decode(buffers.output.data(), channels, anchors, options.score_threshold);
+            mark(kDecode);
+            const int kept = std::min(nms.run(decoder.candidates(), decoder.count(), options.iou_threshold),
+                                      static_cast<int>(detections.size()));
+            for (int i = 0; i < kept; ++i) {
+                const Candidate& c = nms.detections()[i];
+                spotitml_detection& d = detections[i];
+                d = {c.x1, c.y1, c.x2, c.y2, c.score, c.class_id};
+                unletterbox_box(buffers.letterbox, buffers.source_width, buffers.source_height, d.x1, d.y1, d.x2,
+                                d.y2);
+            }
+            mark(kNms);
+
+            if (!record) {
+                return;
+            }
+            Clock::time_point previous = start;
+            uint64_t previous_count = start_count;
+            for (int stage = 0; stage < kTotal; ++stage) {
+                samples[stage].push_back(std::chrono::duration<double, std::milli>(marks[stage] - previous).count());
+                allocations[stage] += counts[stage] - previous_count;
+                previous = marks[stage];
+                previous_count = counts[stage];
+            }
+            samples[kTotal].push_back(std::chrono::duration<double, std::milli>(marks[kNms] - start).count());
+            allocations[kTotal] += counts[kNms] - start_count;
+            detection_total += kept;
+        };
+
+        for (int i = 0; i < std::max<int>(config.warmup, static_cast<int>(sources.size())); ++i) {
+            run_frame(sources[i % sources.size()], false);
+        }
+        const Clock::time_point bench_start = Clock::now();
+        for (int i = 0; i < config.frames; ++i) {
+            run_frame(sources[i % sources.size()], true);
+        }
+        const double wall_s = std::chrono::duration<double>(Clock::now() - bench_start).count();
+        const double fps = config.frames / wall_s;
+        const long rss = peak_rss_kb();
+
+        double batched_ms = 0.0;
+        double sequential_ms = 0.0;
+        if (config.batch > 1) {
+            std::vector<spotitml_frame> batch(config.batch);
+            for (int i = 0; i < config.batch; ++i) {
+                batch[i] = sources[i % sources.size()].frame;
+            }
+            std::vector<spotitml_detection> results(config.batch * detections.size());
+            std::vector<int32_t> counts(config.batch);
+            const int per_frame = static_cast<int>(detections.size());
+            const int rounds = std::max(1, config.frames / config.batch);
+            const auto time_rounds = [&](auto&& body) {
+                body();  // shapes the batch tensors / warms the path
+                const Clock::time_point start = Clock::now();
+                for (int r = 0; r < rounds; ++r) {
+                    body();
+                }
+                return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / rounds;
+            };
+            batched_ms = time_rounds(
+                [&] { engine.detect_batch(batch.data(), config.batch, results.data(), per_frame, counts.data()); });
+            sequential_ms = time_rounds([&] {
+                for (int i = 0; i < config.batch; ++i) {
+                    engine.detect(batch[i], results.data() + i * per_frame, per_frame);
+                }
+            });
+        }
+
+        Summary summaries[kStageCount];
+        std::printf("%-11s %9s %9s %9s %9s %9s %12s\n", "stage", "mean ms", "p50 ms", "p95 ms", "p99 ms", "max ms",
+                    "allocs/frame");
+        for (int stage = 0; stage < kStageCount; ++stage) {
+            const Summary& s = summaries[stage] = summarize(samples[stage]);
+            std::printf("%-11s %9.3f %9.3f %9.3f %9.3f %9.3f %12.2f\n", kStageNames[stage], s.mean, s.p50, s.p95,
+                        s.p99, s.max, static_cast<double>(allocations[stage]) / config.frames);
+        }
+        std::printf("\n%d frames (%zu distinct, %s), %.1f frames/s, peak RSS %ld KB (%ld KB before load), "
+                    "%.1f detections/frame, cache state %d\n",
+                    config.frames, sources.size(), config.images.empty() ? format_name(config.format) : "ppm", fps,
+                    rss, rss_before_load, static_cast<double>(detection_total) / config.frames,
+                    engine.load_stats().cache_state);
+        if (config.batch > 1) {
+            std::printf("batch of %d: %.3f ms in one run%s, %.3f ms one by one (%.2fx)\n", config.batch, batched_ms,
+                        engine.dynamic_batch() ? "" : " (fixed batch axis, run one by one)", sequential_ms,
+                        batched_ms > 0.0 ? sequential_ms / batched_ms : 0.0);
+        }
+
+        if (!config.json.empty()) {
+            FILE* out = std::fopen(config.json.c_str(), "w");
+            if (out == nullptr) {
+                throw std::runtime_error("cannot write " + config.json);
+            }
+            std::fprintf(out, "{\n");
+            std::fprintf(out, "  \"model\": \"");
+            write_escaped(out, config.model.c_str());
+            std::fprintf(out, "\",\n");
+            std::fprintf(out, "  \"ort_version\": \"%s\",\n", Ort::GetVersionString().c_str());
+            std::fprintf(out, "  \"source\": \"%s\",\n", config.images.empty() ? "synthetic" : "images");
+            std::fprintf(out, "  \"format\": \"%s\",\n",
+                         config.images.empty() ? format_name(config.format) : "rgb");
+            std::fprintf(out, "  \"distinct_frames\": %zu,\n", sources.size());
+            std::fprintf(out, "  \"frames\": %d,\n", config.frames);
+            std::fprintf(out, "  \"warmup\": %d,\n", config.warmup);
+            std::fprintf(out, "  \"intra_op_threads\": %d,\n", config.threads);
+            std::fprintf(out, "  \"load_ms\": %.3f,\n", engine.load_stats().load_ms);
+            std::fprintf(out, "  \"warmup_ms\": %.3f,\n", engine.load_stats().warmup_ms);
+            std::fprintf(out, "  \"cache_state\": %d,\n", engine.load_stats().cache_state);
+            std::fprintf(out, "  \"fps\": %.3f,\n", fps);
+            std::fprintf(out, "  \"peak_rss_kb\": %ld,\n", rss);
+            std::fprintf(out, "  \"peak_rss_before_load_kb\": %ld,\n", rss_before_load);
+            std::fprintf(out, "  \"detections_per_frame\": %.3f,\n",
+                         static_cast<double>(detection_total) / config.frames);
+            if (config.batch > 1) {
+                std::fprintf(out,
+                             "  \"batch\": {\"size\": %d, \"dynamic\": %s, \"batched_ms\": %.4f, "
+                             "\"sequential_ms\": %.4f},\n",
+                             config.batch, engine.dynamic_batch() ? "true" : "false", batched_ms, sequential_ms);
+            }
+            std::fprintf(out, "  \"stages\": {\n");
+            for (int stage = 0; stage < kStageCount; ++stage) {
+                const Summary& s = summaries[stage];
+                std::fprintf(out,
+                             "    \"%s\": {\"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f, "
+                             "\"max_ms\": %.4f, \"allocations_per_frame\": %.3f}%s\n",
+                             kStageNames[stage], s.mean, s.p50, s.p95, s.p99, s.max,
+                             static_cast<double>(allocations[stage]) / config.frames,
+                             stage + 1 < kStageCount ? "," : "");
+            }
+            std::fprintf(out, "  }\n}\n");
+            std::fclose(out);
+        }
+
+        if (config.check_allocs) {
+            bool clean = true;
+            for (int stage : {kIngest, kPreprocess, kDecode, kNms}) {
+                if (allocations[stage] != 0) {
+                    std::fprintf(stderr, "spotitml_bench: %s made %llu heap allocations in %d frames\n",
+                                 kStageNames[stage], static_cast<unsigned long long>(allocations[stage]),
+                                 config.frames);
+                    clean = false;
+                }
+            }
+            if (!clean) {
+                return 3;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "spotitml_bench: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -86,6 +86,54 @@ function(_setup_onnxruntime_macos)
     message(STATUS "   Library: ${ONNXRUNTIME_LIB}")
 endfunction()
 
+#
+# Linux: ONNXRUNTIME_ROOT or a system install, else the official release tarball
+#
+function(_setup_onnxruntime_linux)
+    message(STATUS "🔍 Setting up ONNX Runtime ${ONNXRUNTIME_VERSION} for Linux...")
+    
+    set(ONNXRUNTIME_ROOT "" CACHE PATH "ONNX Runtime install prefix (optional)")
+    
+    find_path(ONNXRUNTIME_INCLUDE_DIRS NAMES onnxruntime_cxx_api.h
+        HINTS ${ONNXRUNTIME_ROOT}/include
+              ${ONNXRUNTIME_ROOT}/include/onnxruntime
+        PATHS /usr/local/include/onnxruntime
+              /usr/include/onnxruntime
+        DOC "ONNX Runtime include directory")
+        
+    find_library(ONNXRUNTIME_LIB NAMES onnxruntime
+        HINTS ${ONNXRUNTIME_ROOT}/lib
+        DOC "ONNX Runtime library")
+    
+    if(NOT ONNXRUNTIME_INCLUDE_DIRS OR NOT ONNXRUNTIME_LIB)
+        # The prebuilt CPU package; XNNPACK requests fall back to CPU unless
+        # ONNXRUNTIME_ROOT points at a build configured with --use_xnnpack.
+        if(CMAKE_SYSTEM_PROCESSOR MATCHES "^(aarch64|arm64)$")
+            set(_ort_arch "aarch64")
+        else()
+            set(_ort_arch "x64")
+        endif()
+        FetchContent_Declare(
+            onnxruntime_linux
+            URL https://github.com/microsoft/onnxruntime/releases/download/v${ONNXRUNTIME_VERSION}/onnxruntime-linux-${_ort_arch}-${ONNXRUNTIME_VERSION}.tgz
+            DOWNLOAD_EXTRACT_TIMESTAMP ON
+        )
+        FetchContent_MakeAvailable(onnxruntime_linux)
+        set(ONNXRUNTIME_INCLUDE_DIRS "${onnxruntime_linux_SOURCE_DIR}/include")
+        set(ONNXRUNTIME_LIB "${onnxruntime_linux_SOURCE_DIR}/lib/libonnxruntime.so")
+    endif()
+    
+    add_library(onnxruntime::headers INTERFACE IMPORTED)
+    target_include_directories(onnxruntime::headers INTERFACE "${ONNXRUNTIME_INCLUDE_DIRS}")
+    
+    add_library(onnxruntime::onnxruntime UNKNOWN IMPORTED)
+    set_target_properties(onnxruntime::onnxruntime PROPERTIES IMPORTED_LOCATION "${ONNXRUNTIME_LIB}")
+    
+    message(STATUS "✅ ONNX Runtime configured for Linux")
+    message(STATUS "   Headers: ${ONNXRUNTIME_INCLUDE_DIRS}")
+    message(STATUS "   Library: ${ONNXRUNTIME_LIB}")
+endfunction()
+
 #
 # Main ONNX Runtime setup - automatically detects platform
 #
@@ -93,8 +141,10 @@ if(ANDROID)
     _setup_onnxruntime_android()
 elseif(APPLE)
     _setup_onnxruntime_macos()
+elseif(CMAKE_SYSTEM_NAME STREQUAL "Linux")
+    _setup_onnxruntime_linux()
 else()
-    message(FATAL_ERROR "❌ Platform not supported. ONNX Runtime module supports Android and macOS only.")
+    message(FATAL_ERROR "❌ Platform not supported. ONNX Runtime module supports Android, macOS and Linux only.")
 endif()
 
 # Set standard CMake variables
@@ -6,12 +6,555 @@
 extern "C" {
 #endif
 
+// Inference engine lifecycle: create once per model, run many times, destroy.
+// The engine owns the ONNX Runtime environment, the prepared session and the
+// pre-allocated input/output tensors, so a run is only the model execution.
+typedef struct spotitml_engine spotitml_engine;
+
+// ONNX Runtime graph optimization levels.
+typedef enum spotitml_graph_optimization {
+    SPOTITML_OPTIMIZE_DISABLED = 0,
+    SPOTITML_OPTIMIZE_BASIC = 1,     // constant folding, redundant node removal
+    SPOTITML_OPTIMIZE_EXTENDED = 2,  // + operator fusions
+    SPOTITML_OPTIMIZE_ALL = 3,       // + layout optimizations
+} spotitml_graph_optimization;
+
+typedef enum spotitml_execution_mode {
+    SPOTITML_EXECUTION_SEQUENTIAL = 0,
+    SPOTITML_EXECUTION_PARALLEL = 1,  // runs independent graph branches on inter-op threads
+} spotitml_execution_mode;
+
+// Execution providers, tried in the order given in spotitml_engine_options.
+// A provider that is not compiled into the ONNX Runtime build or not offered
+// by the platform is skipped; nodes no provider claims run on the CPU.
+typedef enum spotitml_execution_provider {
+    SPOTITML_PROVIDER_CPU = 0,
+    SPOTITML_PROVIDER_XNNPACK = 1,
+    SPOTITML_PROVIDER_NNAPI = 2,   // Android only
+    SPOTITML_PROVIDER_COREML = 3,  // Apple only
+} spotitml_execution_provider;
+
+#define SPOTITML_MAX_PROVIDERS 4
+
+typedef struct spotitml_engine_options {
+    int32_t intra_op_threads;  // 0 lets ONNX Runtime decide
+    int32_t inter_op_threads;  // 0 lets ONNX Runtime decide
+    float score_threshold;     // minimum class score for a candidate box
+    float iou_threshold;       // NMS overlap above which the weaker box is dropped
+    int32_t graph_optimization;    // spotitml_graph_optimization
+    int32_t execution_mode;        // spotitml_execution_mode
+    int32_t enable_cpu_mem_arena;  // nonzero = on
+    int32_t enable_mem_pattern;    // nonzero = on
+    int32_t log_severity;          // ONNX Runtime log severity, 0 (verbose) to 4 (fatal)
+    int32_t provider_count;
+    int32_t providers[SPOTITML_MAX_PROVIDERS];  // spotitml_execution_provider, preferred first
+    const char* cache_dir;  // optimized-model cache directory; NULL disables the cache
+} spotitml_engine_options;
+
+// How the engine's model was loaded.
+typedef enum spotitml_model_cache_state {
+    SPOTITML_CACHE_DISABLED = 0,  // no cache_dir: optimized from the .onnx every time
+    SPOTITML_CACHE_MISS = 1,      // cold: optimized from the .onnx and written to the cache
+    SPOTITML_CACHE_HIT = 2,       // warm: loaded the cached optimized model
+    SPOTITML_CACHE_BYPASSED = 3,  // providers compile nodes that cannot be serialized
+} spotitml_model_cache_state;
+
+typedef struct spotitml_load_stats {
+    double load_ms;       // session creation, including cache lookup and write
+    double warmup_ms;     // dummy inferences run by engine_prewarm (0 otherwise)
+    int32_t cache_state;  // spotitml_model_cache_state
+} spotitml_load_stats;
+
+// One detection in source image pixel coordinates. Fixed layout so callers
+// (e.g. Dart through dart:ffi Structs) can read results in place.
+typedef struct spotitml_detection {
+    float x1;
+    float y1;
+    float x2;
+    float y2;
+    float score;
+    int32_t class_id;
+} spotitml_detection;
+
+// Pixel layouts accepted by engine_detect_frame.
+typedef enum spotitml_pixel_format {
+    SPOTITML_FORMAT_RGB = 0,     // plane 0: packed R, G, B
+    SPOTITML_FORMAT_BGRA = 1,    // plane 0: packed B, G, R, A (iOS / macOS camera)
+    SPOTITML_FORMAT_NV21 = 2,    // plane 0: Y; plane 1: interleaved V/U at half resolution
+    SPOTITML_FORMAT_YUV420 = 3,  // planes 0-2: Y, U, V; U/V pixel stride 1 (I420) or 2 (Android YUV_420_888)
+} spotitml_pixel_format;
+
+// A camera frame described by its planes, as delivered by the platform.
+// YUV is converted with full-range BT.601 (JFIF) coefficients.
+typedef struct spotitml_frame {
+    int32_t format;  // spotitml_pixel_format
+    int32_t width;
+    int32_t height;
+    const uint8_t* planes[3];
+    int32_t row_strides[3];    // bytes between rows of each plane
+    int32_t pixel_strides[3];  // bytes between pixels of each plane (0 = natural for the format)
+} spotitml_frame;
+
+// Fills options with the library defaults.
+void engine_default_options(spotitml_engine_options* options);
+
+// Loads the model and prepares the session. Options may be NULL for defaults.
+// Returns NULL on failure; engine_last_error() describes why.
+spotitml_engine* engine_create(const char* model_path, const spotitml_engine_options* options);
+
+// Writes the execution providers the session was actually created with, in
+// priority order, and returns how many there are (at most max_providers).
+// CPU is always last; anything requested but missing here was unavailable.
+int32_t engine_active_providers(const spotitml_engine* engine, int32_t* providers, int32_t max_providers);
+
+// Precision variants of the same detector. FP16 and INT8 (QDQ) variants must
+// keep float32 inputs and outputs (e.g. keep_io_types); see
+// native/tools/quantize_model.py.
+typedef enum spotitml_precision {
+    SPOTITML_PRECISION_FP32 = 0,
+    SPOTITML_PRECISION_FP16 = 1,
+    SPOTITML_PRECISION_INT8 = 2,
+} spotitml_precision;
+
+typedef enum spotitml_variant_policy {
+    SPOTITML_VARIANT_FASTEST = 0,        // expected fastest for the requested providers
+    SPOTITML_VARIANT_MOST_ACCURATE = 1,  // FP32, then FP16, then INT8
+    SPOTITML_VARIANT_AUTO = 2,           // benchmark all; most accurate within 10% of the fastest
+} spotitml_variant_policy;
+
+typedef struct spotitml_model_variant {
+    const char* model_path;
+    int32_t precision;  // spotitml_precision
+} spotitml_model_variant;
+
+typedef enum spotitml_variant_status {
+    SPOTITML_VARIANT_FAILED = -1,
+    SPOTITML_VARIANT_SKIPPED = 0,  // not needed by the policy
+    SPOTITML_VARIANT_LOADED = 1,
+    SPOTITML_VARIANT_CHOSEN = 2,
+} spotitml_variant_status;
+
+// What happened to each variant during selection (accuracy-vs-speed data).
+typedef struct spotitml_variant_report {
+    int32_t precision;    // spotitml_precision
+    int32_t status;       // spotitml_variant_status
+    double load_ms;
+    double inference_ms;  // mean per inference, measured under AUTO only
+} spotitml_variant_report;
+
+// Creates an engine from the variant the policy selects, falling back to the
+// next candidate when one fails to load. bench_runs (0 = default of 5) is
+// the number of timed inferences per variant under AUTO. Returns NULL if no
+// variant loads.
+spotitml_engine* engine_create_variant(const spotitml_model_variant* variants, int32_t variant_count,
+                                       int32_t policy, int32_t bench_runs,
+                                       const spotitml_engine_options* options);
+
+// One report per variant given at creation, in the same order; returns the
+// count written. Engines created from a single path report just that model.
+int32_t engine_variant_reports(const spotitml_engine* engine, spotitml_variant_report* reports,
+                               int32_t max_reports);
+
+// Creates an engine on a background thread and runs warmup_runs inferences
+// on a zero input (1-2 is enough to fault in weights and size the arenas), so
+// the first real detection runs at steady-state latency. callback, if not
+// NULL, is called on that thread with the spotitml_prewarm_state once done;
+// Dart can pass a NativeCallable.listener here and complete a future.
+typedef struct spotitml_prewarm spotitml_prewarm;
+
+typedef enum spotitml_prewarm_state {
+    SPOTITML_PREWARM_PENDING = 0,
+    SPOTITML_PREWARM_READY = 1,
+    SPOTITML_PREWARM_FAILED = -1,
+} spotitml_prewarm_state;
+
+typedef void (*spotitml_ready_callback)(int32_t state, void* user_data);
+
+// Arguments are as for engine_create; model_path and options are copied.
+// Returns NULL if the thread could not be started.
+spotitml_prewarm* engine_prewarm(const char* model_path, const spotitml_engine_options* options,
+                                 int32_t warmup_runs, spotitml_ready_callback callback, void* user_data);
+
+// engine_prewarm for engine_create_variant's arguments.
+spotitml_prewarm* engine_prewarm_variant(const spotitml_model_variant* variants, int32_t variant_count,
+                                         int32_t policy, int32_t bench_runs,
+                                         const spotitml_engine_options* options, int32_t warmup_runs,
+                                         spotitml_ready_callback callback, void* user_data);
+
+// spotitml_prewarm_state; never blocks.
+int32_t prewarm_state(const spotitml_prewarm* prewarm);
+
+// Waits until the engine is ready and transfers it to the caller, who then
+// owns it (engine_destroy). Returns NULL if creation failed, with
+// engine_last_error() set, or if the engine was already taken.
+spotitml_engine* prewarm_take_engine(spotitml_prewarm* prewarm);
+
+// Waits for the background thread; an engine that was not taken is destroyed.
+// Must not be called from the ready callback.
+void prewarm_destroy(spotitml_prewarm* prewarm);
+
+// Fills stats with how long engine_create took to load the model and whether
+// the optimized-model cache was hit. Returns 0, or -1 on invalid arguments.
+int32_t engine_load_stats(const spotitml_engine* engine, spotitml_load_stats* stats);
+
+// Runs the model on the current contents of the input buffer.
+// Returns 0 on success, -1 on failure (see engine_last_error()).
+int32_t engine_run(spotitml_engine* engine);
+
+// Pre-allocated NCHW float input tensor and its element count.
+float* engine_input_buffer(spotitml_engine* engine);
+int64_t engine_input_size(const spotitml_engine* engine);
+
+// Output tensor of the last run and its element count.
+const float* engine_output_buffer(const spotitml_engine* engine);
+int64_t engine_output_size(const spotitml_engine* engine);
+
+// Full detection on a packed RGB frame: preprocess, run, decode and NMS.
+// Writes at most max_detections results (best score first) into the caller's
+// array and returns how many were written, or -1 on failure.
+// Nothing is shared between engines; a single engine must not be used from
+// two threads at once.
+int32_t engine_detect(spotitml_engine* engine, const uint8_t* image_data, int32_t width, int32_t height,
+                      spotitml_detection* detections, int32_t max_detections);
+
+// Same as engine_detect for a camera frame in any spotitml_pixel_format.
+// Color conversion is fused into the letterbox pass, so no full-resolution
+// RGB copy of the frame is ever made.
+int32_t engine_detect_frame(spotitml_engine* engine, const spotitml_frame* frame,
+                            spotitml_detection* detections, int32_t max_detections);
+
+// Class allow-list: decoding reads only the score rows of these class ids,
+// so its cost scales with the classes wanted (e.g. person, bird, cat, dog
+// out of COCO's 80). class_ids = NULL or count = 0 restores every class; ids
+// the model does not have are ignored. Takes effect on the next frame, also
+// for workers already running on this engine. Returns 0, or -1 on invalid
+// arguments.
+int32_t engine_set_class_filter(spotitml_engine* engine, const int32_t* class_ids, int32_t count);
+
+// Batched detection: frame_count frames (or crops of one) in a single session
+// run. Needs a model whose batch axis is dynamic (e.g. `yolo export
+// format=onnx dynamic=True`); with a fixed batch of 1 the frames are run one
+// after another. Frames are letterboxed back to back into one contiguous
+// input tensor, at most 8 per run. Frame i writes at most
+// max_detections_per_frame results to detections + i * max_detections_per_frame
+// and their number to counts[i]. Returns frame_count, or -1 on failure.
+int32_t engine_detect_batch(spotitml_engine* engine, const spotitml_frame* frames, int32_t frame_count,
+                            spotitml_detection* detections, int32_t max_detections_per_frame, int32_t* counts);
+
+// 1 if engine_detect_batch runs a whole batch at once, 0 if frame by frame.
+int32_t engine_supports_batch(const spotitml_engine* engine);
+
+// Two-stage detection for frames in which the cards cover only part of the
+// view. A cheap localizer finds up to SPOTITML_MAX_CARDS round cards on a
+// downsampled luma image, and the detector then runs on each card's crop, so
+// the model input is spent on the card instead of the table around it and
+// small symbols keep more pixels. The crops are batched as by
+// engine_detect_batch. If no card is found the whole frame is
+// treated as one card with score 0.
+#define SPOTITML_MAX_CARDS 2
+#define SPOTITML_MAX_CARD_DETECTIONS 32
+
+typedef struct spotitml_card_result {
+    float x1;  // card region in source image pixels
+    float y1;
+    float x2;
+    float y2;
+    float score;  // how disc-like the region is, 0 to 1; 0 = no card found
+    int32_t detection_count;
+    spotitml_detection detections[SPOTITML_MAX_CARD_DETECTIONS];  // source image pixels, best first
+} spotitml_card_result;
+
+// Writes one result per card (at most max_cards, largest card first) and
+// returns how many, or -1 on failure.
+int32_t engine_detect_cards(spotitml_engine* engine, const spotitml_frame* frame, spotitml_card_result* cards,
+                            int32_t max_cards);
+
+// Match finding: the symbol two cards have in common. Symbols are class ids
+// below SPOTITML_MAX_SYMBOLS (enough for the 55/57-symbol Dobble vocabulary
+// and for COCO); each card's symbols form a bitset, and the cards are
+// intersected word by word. When detection errors leave more than one
+// shared class, the one whose best boxes have the highest score product wins.
+#define SPOTITML_MAX_SYMBOLS 128
+
+typedef struct spotitml_match {
+    int32_t class_id;             // shared symbol, -1 if the cards share none
+    float score;                  // product of the two boxes' scores, 0 without a match
+    int32_t shared_count;         // classes found on both cards; > 1 means the tie-break decided
+    int32_t card_count;           // cards in view (always 2 for find_match)
+    int32_t card_counts[2];       // distinct symbols on each card
+    int32_t deck_cards[2];        // deck card each side was snapped to, -1 if not (deck matching only)
+    spotitml_detection boxes[2];  // best box of class_id on card 0 and on card 1
+} spotitml_match;
+
+// Assigns each detection to card_a or card_b ({x1, y1, x2, y2}, the same
+// pixels as the boxes) by its box center, the nearer card center if both
+// contain it, and drops detections outside both. Returns 1 if the cards
+// share a symbol, 0 if not (match->class_id is then -1), or -1 on failure.
+int32_t find_match(const spotitml_detection* detections, int32_t count, const float* card_a, const float* card_b,
+                   spotitml_match* match);
+
+// engine_detect_cards followed by the match between the two largest cards,
+// in one call. cards may be NULL; otherwise it must hold SPOTITML_MAX_CARDS
+// results and receives the cards as from engine_detect_cards. Returns as
+// find_match; with fewer than two cards in view there is no match.
+int32_t engine_detect_match(spotitml_engine* engine, const spotitml_frame* frame, spotitml_card_result* cards,
+                            spotitml_match* match);
+
+// Deck model for a Dobble model whose class ids are the deck's symbols: the
+// finite projective plane of order 7, 57 symbols on 57 cards of 8, where any
+// two cards share exactly one symbol. Symbol sets are 64-bit masks (bit i =
+// class i). The card tables are built at compile time, so every query is a
+// handful of popcounts.
+#define SPOTITML_DECK_SYMBOLS 57
+#define SPOTITML_DECK_CARDS 57
+
+// Symbols of card (0 to SPOTITML_DECK_CARDS - 1), or 0 for an invalid card.
+uint64_t deck_card_symbols(int32_t card);
+
+// Snaps a detected symbol mask to the nearest card by Hamming distance, i.e.
+// missed plus spurious symbols. Returns the card, or -1 if the nearest card
+// is more than max_distance away. max_distance is capped at 6, below which
+// the nearest card is always unique; 3 tolerates e.g. two missed symbols and
+// one false one. distance may be NULL.
+int32_t deck_snap(uint64_t symbols, int32_t max_distance, int32_t* distance);
+
+// The one symbol two different cards share, or -1 if a and b are equal or invalid.
+int32_t deck_shared_symbol(int32_t card_a, int32_t card_b);
+
+// find_match resolved through the deck: each side's symbols are snapped to
+// a card (deck_snap with max_distance) and the answer is the symbol those
+// two cards share, even if the detector missed it on one or both cards
+// (the missing box then has score 0 and no extent, and match->score is 0).
+// If a side cannot be snapped (its deck_cards entry is then -1), the plain
+// intersection answers as in find_match. Returns as find_match.
+int32_t find_deck_match(const spotitml_detection* detections, int32_t count, const float* card_a,
+                        const float* card_b, int32_t max_distance, spotitml_match* match);
+
+// engine_detect_match resolved through the deck, as find_deck_match.
+int32_t engine_detect_deck_match(spotitml_engine* engine, const spotitml_frame* frame, int32_t max_distance,
+                                 spotitml_card_result* cards, spotitml_match* match);
+
+void engine_destroy(spotitml_engine* engine);
+
+// Embedding-based symbol classification, an alternative to training the
+// detector's class head on every deck variant. A class-agnostic proposer
+// engine (ideally a YOLOv8 exported with one "symbol" class) finds the boxes;
+// a small embedding model ([N, 3, S, S] input, [N, D] output) embeds every
+// box's crop in one batched run, and each crop takes the class of its
+// nearest row (cosine similarity) in an embedding table. The table is a
+// compact binary file written by native/tools/build_embedding_table.py, so a
+// new deck needs no model rebuild. The nearest-neighbor search runs SIMD dot
+// products over a contiguous, aligned float32 or int8 matrix.
+typedef struct spotitml_classifier spotitml_classifier;
+
+// proposer is borrowed: destroy the classifier first. options (may be NULL)
+// configure the embedding session as in engine_create. Returns NULL on failure.
+spotitml_classifier* classifier_create(spotitml_engine* proposer, const char* embedding_model_path,
+                                       const char* table_path, const spotitml_engine_options* options);
+
+// Swaps in another embedding table (e.g. a different deck). Returns 0, or -1
+// if it cannot be loaded, in which case the current table stays.
+int32_t classifier_load_table(spotitml_classifier* classifier, const char* table_path);
+
+// Rows of the current table.
+int32_t classifier_table_size(const spotitml_classifier* classifier);
+
+// Proposes, embeds and classifies; keeps crops whose best cosine similarity
+// is at least min_similarity. Each detection's score is the proposal score
+// times that similarity. Returns the count written (best first), or -1.
+int32_t classifier_detect_frame(spotitml_classifier* classifier, const spotitml_frame* frame, float min_similarity,
+                                spotitml_detection* detections, int32_t max_detections);
+
+void classifier_destroy(spotitml_classifier* classifier);
+
+// Pool of pre-allocated, 64-byte aligned frame buffers shared with the caller.
+// Acquire a buffer, write the camera planes straight into it (e.g. through
+// Dart's asTypedList), point a spotitml_frame at it and pass it to
+// engine_detect_frame (then release it) or worker_submit_pooled (which takes
+// ownership and releases it itself). Nothing is copied on the native side.
+typedef struct spotitml_frame_pool spotitml_frame_pool;
+
+// Returns NULL on failure: buffer_count outside 1..32, buffer_size <= 0 or
+// out of memory.
+spotitml_frame_pool* frame_pool_create(int32_t buffer_count, int64_t buffer_size);
+
+// Index of a free buffer, or -1 if every buffer is in use.
+int32_t frame_pool_acquire(spotitml_frame_pool* pool);
+void frame_pool_release(spotitml_frame_pool* pool, int32_t index);
+
+uint8_t* frame_pool_buffer(spotitml_frame_pool* pool, int32_t index);
+int64_t frame_pool_buffer_size(const spotitml_frame_pool* pool);
+
+// Destroy any worker that may still hold pool buffers first.
+void frame_pool_destroy(spotitml_frame_pool* pool);
+
+// Background detection for a camera stream. The worker runs the engine on the
+// newest submitted frame; submitting never blocks on inference, and a frame
+// that has not been started yet is replaced by the next one instead of being
+// queued. Preprocessing, inference and decode + NMS run on separate threads,
+// so consecutive frames overlap. While a worker exists, its engine must not be
+// used directly. Destroy the worker before the engine.
+typedef struct spotitml_worker spotitml_worker;
+
+// Called on the worker thread after each frame; count is -1 if it failed.
+// Fetch the detections with worker_latest_results. Dart can pass a
+// NativeCallable.listener here.
+typedef void (*spotitml_result_callback)(int64_t frame_id, int32_t count, void* user_data);
+
+// pipeline_depth is the number of frames in flight across the three stages
+// (0 = default of 3, at most 8); 1 processes one frame at a time. callback
+// may be NULL when results are polled. Returns NULL on failure.
+spotitml_worker* worker_create(spotitml_engine* engine, int32_t pipeline_depth, spotitml_result_callback callback,
+                               void* user_data);
+
+// Tracking mode for live scanning, where the cards barely move between
+// frames. The full detector only runs on keyframes: at least every
+// keyframe_interval frames, and whenever a cheap frame-difference metric
+// (mean absolute luma change over a coarse grid since the last keyframe)
+// exceeds motion_threshold. In between, the preprocess and inference stages
+// are skipped and tracked boxes are moved along their estimated motion. The
+// detector's boxes are associated with tracks by IoU (then center distance)
+// within a class, which gives every symbol a stable track id and rides out
+// single-frame misses.
+typedef struct spotitml_tracking_options {
+    int32_t keyframe_interval;  // run the detector at least every N frames (1 = every frame)
+    float motion_threshold;     // mean absolute luma change (0-255) that forces a detector run
+    float iou_threshold;        // minimum IoU to continue a track with a detection
+    int32_t max_missed;         // detector runs a track survives without a matching detection
+} spotitml_tracking_options;
+
+// One tracked detection.
+typedef struct spotitml_track {
+    spotitml_detection detection;  // smoothed box in source image pixels
+    int32_t track_id;              // stable while the track lives; never reused
+    int32_t hits;                  // detector runs that matched this track
+    int32_t missed;                // consecutive detector runs without a match
+    int32_t detected;              // 1 if the detector ran on this frame and matched, 0 if propagated
+} spotitml_track;
+
+// Fills options with the defaults (keyframe every 5 frames, motion threshold 6).
+void worker_default_tracking_options(spotitml_tracking_options* options);
+
+// worker_create with tracking; tracking may be NULL for the defaults.
+// worker_latest_results then returns the tracked boxes, and
+// worker_latest_tracks the same boxes with their track ids.
+spotitml_worker* worker_create_tracked(spotitml_engine* engine, int32_t pipeline_depth,
+                                       const spotitml_tracking_options* tracking,
+                                       spotitml_result_callback callback, void* user_data);
+
+// Copies the newest tracks (at most max_tracks, oldest track first) and
+// returns their count, or -1 if that frame failed or the worker does not track.
+int32_t worker_latest_tracks(spotitml_worker* worker, spotitml_track* tracks, int32_t max_tracks,
+                             int64_t* frame_id);
+
+// Copies the frame's planes into the mailbox and returns its frame id, or -1.
+int64_t worker_submit(spotitml_worker* worker, const spotitml_frame* frame);
+
+// Zero-copy submit: the frame's planes must lie inside pool buffer index,
+// which the worker owns from now on and releases when the frame is processed
+// or replaced. Returns the frame id, or -1 (the buffer is then still the caller's).
+int64_t worker_submit_pooled(spotitml_worker* worker, const spotitml_frame* frame,
+                             spotitml_frame_pool* pool, int32_t index);
+
+// Copies the newest finished detections into the caller's array and returns
+// their count (-1 if that frame failed). frame_id may be NULL.
+int32_t worker_latest_results(spotitml_worker* worker, spotitml_detection* detections, int32_t max_detections,
+                              int64_t* frame_id);
+
+// Frames replaced in the mailbox before the worker got to them.
+int64_t worker_dropped_frames(const spotitml_worker* worker);
+
+void worker_destroy(spotitml_worker* worker);
+
+// Process-wide pipeline statistics, covering every engine and worker.
+// Stage latencies come from per-thread histograms (about 12% bucket
+// resolution), so recording never takes a lock. Builds configured with
+// SPOTITML_INSTRUMENTATION=OFF record nothing and report enabled = 0; only
+// last_load is filled in then.
+typedef enum spotitml_stage {
+    SPOTITML_STAGE_PREPROCESS = 0,  // letterbox + color conversion into the input tensor
+    SPOTITML_STAGE_INFERENCE = 1,   // session run
+    SPOTITML_STAGE_DECODE = 2,      // head output to candidates
+    SPOTITML_STAGE_NMS = 3,         // candidates to detections
+    SPOTITML_STAGE_FRAME = 4,       // whole engine_detect call, or worker submit to result
+    SPOTITML_STAGE_LOCATE = 5,      // card localization in engine_detect_cards
+} spotitml_stage;
+
+#define SPOTITML_STAGE_COUNT 6
+
+typedef struct spotitml_stage_stats {
+    int64_t count;
+    double mean_ms;
+    double p50_ms;
+    double p95_ms;
+    double p99_ms;
+    double max_ms;
+} spotitml_stage_stats;
+
+typedef struct spotitml_stats {
+    int32_t enabled;
+    int32_t threads;  // threads that recorded anything since the last reset
+    spotitml_stage_stats stages[SPOTITML_STAGE_COUNT];  // indexed by spotitml_stage
+    int64_t frames_submitted;    // to workers
+    int64_t frames_dropped;      // replaced in a worker mailbox before being processed
+    int64_t frames_processed;
+    int64_t frames_failed;
+    int64_t frames_tracked;      // processed by propagating tracks instead of running the detector
+    int64_t candidates;          // boxes that cleared the score threshold
+    int64_t candidate_overflow;  // candidates that did not fit in the decoder
+    int64_t detections;          // boxes left after NMS
+    spotitml_load_stats last_load;  // most recently created or warmed-up engine
+} spotitml_stats;
+
+// Fills stats with everything recorded since the last stats_reset.
+// Returns 0, or -1 if stats is NULL.
+int32_t stats_snapshot(spotitml_stats* stats);
+
+void stats_reset(void);
+
+// Span capture for following individual frames through the pipeline threads.
+// While a capture runs, every stage records a span tagged with its frame id
+// into a per-thread ring (the newest 8192 per thread are kept), and each worker
+// frame gets an async span from submit to result. trace_write produces Chrome
+// trace-event JSON for Perfetto (ui.perfetto.dev) or chrome://tracing.
+//
+// Starts a capture, discarding the previous one; it ends by itself after
+// duration_ms (<= 0: at trace_stop). Returns -1 if the library was built
+// without SPOTITML_INSTRUMENTATION.
+int32_t trace_start(int32_t duration_ms);
+
+void trace_stop(void);
+
+// Writes the captured spans to path; returns how many, or -1 on failure.
+int64_t trace_write(const char* path);
+
+// Diagnostics go through an asynchronous logger (logcat on Android, stderr
+// elsewhere); a message never blocks the calling thread on I/O, and each call
+// site is rate limited so a failing frame loop cannot flood the log.
+typedef enum spotitml_log_level {
+    SPOTITML_LOG_DEBUG = 0,
+    SPOTITML_LOG_INFO = 1,
+    SPOTITML_LOG_WARN = 2,
+    SPOTITML_LOG_ERROR = 3,
+    SPOTITML_LOG_OFF = 4,
+} spotitml_log_level;
+
+// Messages below level are discarded (default SPOTITML_LOG_INFO).
+void log_set_level(int32_t level);
+
+// Message of the last failed engine call on the calling thread.
+const char* engine_last_error(void);
+
 // Phase 1b: Object detection with ONNX Runtime
-// Takes image data (RGB bytes) and dimensions, returns detection results as JSON string
-// The caller should not free the returned pointer.
-const char* detect_objects(const uint8_t* image_data, int width, int height);
+// Takes an engine, image data (packed RGB bytes) and dimensions. The image is letterboxed
+// into the model input and the model is run; returns detection results as JSON string
+// The caller should not free the returned pointer. It stays valid until the next
+// detect_objects call on the same engine. Error text is the calling thread's
+// engine_last_error() text and stays valid until the next failing call on
+// that thread.
+// Prefer engine_detect, which avoids the JSON round trip.
+const char* detect_objects(spotitml_engine* engine, const uint8_t* image_data, int width, int height);
 
 #ifdef __cplusplus
 }
 #endif
-
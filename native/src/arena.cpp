@@ -0,0 +1,76 @@
+#include "arena.h"
+
+#include <new>
+
+namespace spotitml {
+
+namespace {
+
+size_t round_up(size_t bytes) {
+    return (bytes + ScratchArena::kAlignment - 1) / ScratchArena::kAlignment * ScratchArena::kAlignment;
+}
+
+} // namespace
+
+void ScratchArena::AlignedDelete::operator()(uint8_t* p) const {
+    ::operator delete(p, std::align_val_t{kAlignment});
+}
+
+ScratchArena::Block ScratchArena::allocate_block(size_t bytes) {
+    return Block(static_cast<uint8_t*>(::operator new(bytes, std::align_val_t{kAlignment})));
+}
+
+ScratchArena::ScratchArena(size_t initial_bytes) {
+    reserve(initial_bytes);
+}
+
+ScratchArena::~ScratchArena() = default;
+
+void ScratchArena::reserve(size_t bytes) {
+    bytes = round_up(bytes);
+    if (bytes <= capacity_) {
+        return;
+    }
+    // Only between frames: whatever was handed out lives in the old block.
+    reset();
+    if (bytes <= capacity_) {
+        return;
+    }
+    block_ = allocate_block(bytes);
+    capacity_ = bytes;
+    ++heap_allocations_;
+}
+
+void ScratchArena::reset() {
+    if (!overflow_.empty()) {
+        const size_t needed = used_ + overflow_used_;
+        overflow_.clear();
+        overflow_used_ = 0;
+        used_ = 0;
+        if (needed > capacity_) {
+            // Some headroom so a slowly growing working set does not
+            // reallocate every frame.
+            const size_t grown = round_up(needed + needed / 4);
+            block_ = allocate_block(grown);
+            capacity_ = grown;
+            ++heap_allocations_;
+        }
+    }
+    used_ = 0;
+}
+
+void* ScratchArena::allocate_bytes(size_t bytes) {
+    bytes = round_up(bytes == 0 ? 1 : bytes);
+    if (used_ + bytes <= capacity_) {
+        void* p = block_.get() + used_;
+        used_ += bytes;
+        return p;
+    }
+    // Past the block for this frame; reset() folds this into the block.
+    overflow_.push_back(allocate_block(bytes));
+    overflow_used_ += bytes;
+    ++heap_allocations_;
+    return overflow_.back().get();
+}
+
+} // namespace spotitml
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace spotitml {
+
+// Bump allocator for per-frame scratch memory.
+//
+// Everything a stage needs for one frame is carved out of one cache-line
+// aligned block and given back at once by reset() at the start of the next
+// frame; nothing is freed individually and no destructors run, so only
+// trivially destructible types go in. If a frame needs more than the block
+// holds, the overflow comes from extra blocks and the next reset() replaces
+// them all with one block of the combined size. After the largest frame has
+// been seen (or after reserve()), frames never touch the heap.
+class ScratchArena {
+public:
+    static constexpr size_t kAlignment = 64;
+
+    explicit ScratchArena(size_t initial_bytes = 0);
+    ~ScratchArena();
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    // Ensures the next frames can use at least bytes without allocating.
+    void reserve(size_t bytes);
+
+    // Releases everything handed out since the last reset.
+    void reset();
+
+    // Uninitialized, kAlignment-aligned storage for count objects.
+    template <typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena memory is never destroyed");
+        return static_cast<T*>(allocate_bytes(count * sizeof(T)));
+    }
+
+    void* allocate_bytes(size_t bytes);
+
+    size_t capacity() const { return capacity_; }
+    // Bytes handed out since the last reset, including alignment padding.
+    size_t used() const { return used_ + overflow_used_; }
+    // Heap allocations made so far (initial block included).
+    uint64_t heap_allocations() const { return heap_allocations_; }
+
+private:
+    struct AlignedDelete {
+        void operator()(uint8_t* p) const;
+    };
+    using Block = std::unique_ptr<uint8_t, AlignedDelete>;
+
+    static Block allocate_block(size_t bytes);
+
+    Block block_;
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+
+    // Frame-local spill-over, merged into block_ on reset.
+    std::vector<Block> overflow_;
+    size_t overflow_used_ = 0;
+
+    uint64_t heap_allocations_ = 0;
+};
+
+} // namespace spotitml
@@ -0,0 +1,209 @@
+#include "card_locator.h"
+#include "preprocess.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace spotitml {
+
+namespace {
+
+enum Cell : uint8_t { kBackground = 0, kForeground = 1, kOutside = 2, kVisited = 3 };
+
+constexpr float kDiscFill = 0.78539816f;  // pi / 4
+// Accepted fill ratio and aspect of a component's bounding box.
+constexpr float kMinFill = 0.65f;
+constexpr float kMaxFill = 0.90f;
+constexpr float kMinAspect = 0.75f;
+// Smallest card diameter as a fraction of the shorter grid side.
+constexpr float kMinDiameter = 0.15f;
+// Margin added around a card on each side, as a fraction of its size.
+constexpr float kMargin = 0.04f;
+
+} // namespace
+
+void CardLocator::sample_luma(const spotitml_frame& frame) {
+    const int longer = std::max(frame.width, frame.height);
+    step_ = std::max(1, (longer + kWorkSize - 1) / kWorkSize);
+    grid_width_ = std::max(1, frame.width / step_);
+    grid_height_ = std::max(1, frame.height / step_);
+    const size_t cells = static_cast<size_t>(grid_width_) * grid_height_;
+    luma_.resize(cells);
+    mask_.resize(cells);
+    stack_.reserve(cells);
+
+    // Taps at a quarter and three quarters of each cell.
+    const int near = step_ / 4;
+    const int far = std::min(step_ - 1, 3 * step_ / 4);
+    for (int gy = 0; gy < grid_height_; ++gy) {
+        const int y0 = std::min(gy * step_ + near, frame.height - 1);
+        const int y1 = std::min(gy * step_ + far, frame.height - 1);
+        uint8_t* out = luma_.data() + static_cast<size_t>(gy) * grid_width_;
+        for (int gx = 0; gx < grid_width_; ++gx) {
+            const int x0 = std::min(gx * step_ + near, frame.width - 1);
+            const int x1 = std::min(gx * step_ + far, frame.width - 1);
+            const int sum = frame_luma(frame, x0, y0) + frame_luma(frame, x1, y0) + frame_luma(frame, x0, y1) +
+                            frame_luma(frame, x1, y1);
+            out[gx] = static_cast<uint8_t>((sum + 2) >> 2);
+        }
+    }
+}
+
+uint8_t CardLocator::otsu_threshold() const {
+    uint32_t histogram[256] = {};
+    for (uint8_t v : luma_) {
+        ++histogram[v];
+    }
+    const double total = static_cast<double>(luma_.size());
+    double sum_all = 0.0;
+    for (int i = 0; i < 256; ++i) {
+        sum_all += static_cast<double>(i) * histogram[i];
+    }
+
+    double weight_low = 0.0;
+    double sum_low = 0.0;
+    double best_variance = -1.0;
+    int best = 127;
+    for (int t = 0; t < 256; ++t) {
+        weight_low += histogram[t];
+        if (weight_low == 0.0) {
+            continue;
+        }
+        const double weight_high = total - weight_low;
+        if (weight_high == 0.0) {
+            break;
+        }
+        sum_low += static_cast<double>(t) * histogram[t];
+        const double mean_low = sum_low / weight_low;
+        const double mean_high = (sum_all - sum_low) / weight_high;
+        const double variance = weight_low * weight_high * (mean_low - mean_high) * (mean_low - mean_high);
+        if (variance > best_variance) {
+            best_variance = variance;
+            best = t;
+        }
+    }
+    return static_cast<uint8_t>(best);
+}
+
+int CardLocator::flood(int seed, uint8_t from, uint8_t to, int& x0, int& y0, int& x1, int& y1) {
+    x0 = x1 = seed % grid_width_;
+    y0 = y1 = seed / grid_width_;
+    int count = 0;
+    stack_.clear();
+    stack_.push_back(seed);
+    mask_[seed] = to;
+    while (!stack_.empty()) {
+        const int cell = stack_.back();
+        stack_.pop_back();
+        ++count;
+        const int x = cell % grid_width_;
+        const int y = cell / grid_width_;
+        x0 = std::min(x0, x);
+        x1 = std::max(x1, x);
+        y0 = std::min(y0, y);
+        y1 = std::max(y1, y);
+
+        const auto visit = [&](int next) {
+            if (mask_[next] == from) {
+                mask_[next] = to;
+                stack_.push_back(next);
+            }
+        };
+        if (x > 0) visit(cell - 1);
+        if (x + 1 < grid_width_) visit(cell + 1);
+        if (y > 0) visit(cell - grid_width_);
+        if (y + 1 < grid_height_) visit(cell + grid_width_);
+    }
+    return count;
+}
+
+void CardLocator::fill_holes() {
+    // Background reachable from the border is the table; anything else dark
+    // is enclosed by a card (its symbols) and belongs to it.
+    int x0, y0, x1, y1;
+    const int last_row = (grid_height_ - 1) * grid_width_;
+    for (int x = 0; x < grid_width_; ++x) {
+        if (mask_[x] == kBackground) flood(x, kBackground, kOutside, x0, y0, x1, y1);
+        if (mask_[last_row + x] == kBackground) flood(last_row + x, kBackground, kOutside, x0, y0, x1, y1);
+    }
+    for (int y = 0; y < grid_height_; ++y) {
+        const int left = y * grid_width_;
+        const int right = left + grid_width_ - 1;
+        if (mask_[left] == kBackground) flood(left, kBackground, kOutside, x0, y0, x1, y1);
+        if (mask_[right] == kBackground) flood(right, kBackground, kOutside, x0, y0, x1, y1);
+    }
+    for (uint8_t& cell : mask_) {
+        if (cell == kBackground) {
+            cell = kForeground;
+        }
+    }
+}
+
+int CardLocator::locate(const spotitml_frame& frame, CardRegion* regions, int max_cards) {
+    if (regions == nullptr || max_cards <= 0 || frame.planes[0] == nullptr || frame.width <= 0 ||
+        frame.height <= 0) {
+        return 0;
+    }
+    max_cards = std::min(max_cards, kMaxCards);
+    sample_luma(frame);
+
+    const uint8_t threshold = otsu_threshold();
+    for (size_t i = 0; i < luma_.size(); ++i) {
+        mask_[i] = luma_[i] > threshold ? kForeground : kBackground;
+    }
+    fill_holes();
+
+    const float min_diameter = kMinDiameter * std::min(grid_width_, grid_height_);
+    CardRegion found[kMaxCards];
+    int areas[kMaxCards] = {};
+    int count = 0;
+    for (int seed = 0; seed < static_cast<int>(mask_.size()); ++seed) {
+        if (mask_[seed] != kForeground) {
+            continue;
+        }
+        int x0, y0, x1, y1;
+        const int area = flood(seed, kForeground, kVisited, x0, y0, x1, y1);
+        const int w = x1 - x0 + 1;
+        const int h = y1 - y0 + 1;
+        const float aspect = static_cast<float>(std::min(w, h)) / std::max(w, h);
+        const float fill = static_cast<float>(area) / (static_cast<float>(w) * h);
+        if (std::max(w, h) < min_diameter || aspect < kMinAspect || fill < kMinFill || fill > kMaxFill) {
+            continue;
+        }
+
+        // Keep the largest max_cards components, largest first.
+        int slot = count;
+        while (slot > 0 && areas[slot - 1] < area) {
+            --slot;
+        }
+        if (slot >= max_cards) {
+            continue;
+        }
+        for (int i = std::min(count, max_cards - 1); i > slot; --i) {
+            found[i] = found[i - 1];
+            areas[i] = areas[i - 1];
+        }
+        count = std::min(count + 1, max_cards);
+
+        // Back to source pixels with a margin; even origin for YUV chroma.
+        const float margin_x = kMargin * w * step_;
+        const float margin_y = kMargin * h * step_;
+        const int left = std::max(0, static_cast<int>(x0 * step_ - margin_x)) & ~1;
+        const int top = std::max(0, static_cast<int>(y0 * step_ - margin_y)) & ~1;
+        const int right = std::min(frame.width, static_cast<int>((x1 + 1) * step_ + margin_x));
+        const int bottom = std::min(frame.height, static_cast<int>((y1 + 1) * step_ + margin_y));
+
+        CardRegion& region = found[slot];
+        region.x = left;
+        region.y = top;
+        region.width = right - left;
+        region.height = bottom - top;
+        region.score = aspect * (1.0f - std::fabs(fill - kDiscFill) / kDiscFill);
+        areas[slot] = area;
+    }
+
+    std::copy(found, found + count, regions);
+    return count;
+}
+
+} // namespace spotitml
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "spotitml_native.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace spotitml {
+
+// Card rectangle in source frame pixels. x and y are even so the crop stays
+// aligned with the half-resolution chroma of YUV frames.
+struct CardRegion {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    float score = 0.0f;  // 1 for a perfect disc
+};
+
+// Cheap localizer for the round, light cards on a darker table.
+//
+// The frame's luma is sampled onto a grid of at most kWorkSize pixels on the
+// longer side (four taps per cell, so even an 8 MP frame costs under 100k
+// reads), thresholded with Otsu's method and split into connected
+// components after filling the holes the symbols leave. Components whose bounding box is about square and whose
+// fill ratio is close to a disc's (pi / 4) are cards. Regions come back
+// largest first with a small margin, ready to crop.
+class CardLocator {
+public:
+    static constexpr int kMaxCards = SPOTITML_MAX_CARDS;
+    // Longer side of the analysis grid.
+    static constexpr int kWorkSize = 160;
+
+    // Writes at most max_cards regions; returns how many were found.
+    int locate(const spotitml_frame& frame, CardRegion* regions, int max_cards);
+
+private:
+    void sample_luma(const spotitml_frame& frame);
+    uint8_t otsu_threshold() const;
+    void fill_holes();
+    // Flood fills from seed over cells equal to from, setting them to to;
+    // returns the cell count and bounding box.
+    int flood(int seed, uint8_t from, uint8_t to, int& x0, int& y0, int& x1, int& y1);
+
+    int step_ = 1;
+    int grid_width_ = 0;
+    int grid_height_ = 0;
+    std::vector<uint8_t> luma_;
+    std::vector<uint8_t> mask_;
+    std::vector<int32_t> stack_;
+};
+
+} // namespace spotitml
@@ -0,0 +1,24 @@
+#include "deck.h"
+
+#include <algorithm>
+
+namespace spotitml::deck {
+
+int snap(uint64_t symbols, int max_distance, int* distance) {
+    symbols &= kSymbolMask;
+    int best = -1;
+    int best_distance = kSymbols + 1;
+    for (int card = 0; card < kCards; ++card) {
+        const int d = __builtin_popcountll(symbols ^ kCardMasks[card]);
+        if (d < best_distance) {
+            best = card;
+            best_distance = d;
+        }
+    }
+    if (distance != nullptr) {
+        *distance = best_distance;
+    }
+    return best_distance <= std::min(max_distance, kMaxUniqueDistance) ? best : -1;
+}
+
+} // namespace spotitml::deck
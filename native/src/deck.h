@@ -0,0 +1,92 @@
+#pragma once
+
+#include "spotitml_native.h"
+#include "deck_geometry.h"
+
+#include <array>
+#include <cstdint>
+
+namespace spotitml::deck {
+
+// The Dobble deck as the finite projective plane of order 7: 57 symbols
+// (points) and 57 cards (lines) of 8 symbols, any two cards sharing exactly
+// one symbol. The physical deck prints 55 of the cards.
+//
+// Symbol p is detector class p. The 49 affine points (x, y), x and y in
+// 0..6, are 7x + y; points 49 + m are the directions of slope m and 56 the
+// vertical direction. Cards 7m + c are the lines y = mx + c (mod 7) plus
+// direction m, cards 49 + c the verticals x = c, card 56 the line at infinity.
+// Each card is a 64-bit mask over its symbols, built at compile time.
+
+constexpr uint64_t kSymbolMask = (uint64_t{1} << kSymbols) - 1;
+// Two cards differ in 2 * (kSymbolsPerCard - 1) symbols, so a symbol set
+// within this distance of a card is closer to it than to any other.
+constexpr int kMaxUniqueDistance = kSymbolsPerCard - 2;
+
+static_assert(kSymbols == SPOTITML_DECK_SYMBOLS, "deck size out of sync with the C API");
+
+constexpr std::array<uint64_t, kCards> build_cards() {
+    std::array<uint64_t, kCards> cards{};
+    const auto bit = [](int symbol) { return uint64_t{1} << symbol; };
+    for (int m = 0; m < kOrder; ++m) {
+        for (int c = 0; c < kOrder; ++c) {
+            uint64_t card = bit(kOrder * kOrder + m);
+            for (int x = 0; x < kOrder; ++x) {
+                card |= bit(kOrder * x + (m * x + c) % kOrder);
+            }
+            cards[kOrder * m + c] = card;
+        }
+    }
+    for (int c = 0; c < kOrder; ++c) {
+        uint64_t card = bit(kSymbols - 1);
+        for (int y = 0; y < kOrder; ++y) {
+            card |= bit(kOrder * c + y);
+        }
+        cards[kOrder * kOrder + c] = card;
+    }
+    uint64_t infinity = 0;
+    for (int symbol = kOrder * kOrder; symbol < kSymbols; ++symbol) {
+        infinity |= bit(symbol);
+    }
+    cards[kCards - 1] = infinity;
+    return cards;
+}
+
+inline constexpr std::array<uint64_t, kCards> kCardMasks = build_cards();
+
+constexpr int popcount(uint64_t mask) {
+    int count = 0;
+    for (; mask != 0; mask &= mask - 1) {
+        ++count;
+    }
+    return count;
+}
+
+constexpr bool is_projective_plane() {
+    for (int a = 0; a < kCards; ++a) {
+        if (popcount(kCardMasks[a]) != kSymbolsPerCard) {
+            return false;
+        }
+        for (int b = a + 1; b < kCards; ++b) {
+            if (popcount(kCardMasks[a] & kCardMasks[b]) != 1) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static_assert(is_projective_plane(), "every card needs 8 symbols and every pair of cards exactly one in common");
+
+// Nearest card to a detected symbol mask by Hamming distance (missed plus
+// spurious symbols). Returns the card, or -1 if none is within max_distance
+// (clamped to kMaxUniqueDistance, which keeps the answer unique); distance,
+// if not nullptr, receives the distance to the nearest card either way.
+int snap(uint64_t symbols, int max_distance, int* distance = nullptr);
+
+// The one symbol cards a and b share, or -1 if they are the same card.
+inline int shared_symbol(int a, int b) {
+    return a == b ? -1 : __builtin_ctzll(kCardMasks[a] & kCardMasks[b]);
+}
+
+} // namespace spotitml::deck
@@ -0,0 +1,13 @@
+#pragma once
+
+namespace spotitml::deck {
+
+// Size of the Dobble deck, the finite projective plane of order 7 (see
+// deck.h). Kept apart from the deck model so geometry-only code such as the
+// decoder does not pull in the C API.
+constexpr int kOrder = 7;
+constexpr int kSymbols = kOrder * kOrder + kOrder + 1;
+constexpr int kCards = kSymbols;
+constexpr int kSymbolsPerCard = kOrder + 1;
+
+} // namespace spotitml::deck
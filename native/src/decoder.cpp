@@ -0,0 +1,172 @@
+#include "decoder.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace spotitml {
+
+namespace {
+
+// Anchors per tile: best score + class for a tile is 4 KB.
+constexpr int kTile = 512;
+
+// best[i], best_class[i] = max(best[i], row[i]) and its class, first max wins.
+void update_best(const float* row, int32_t class_id, float* best, int32_t* best_class, int n) {
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256i vc8 = _mm256_set1_epi32(class_id);
+    for (; i + 8 <= n; i += 8) {
+        const __m256 s = _mm256_loadu_ps(row + i);
+        const __m256 b = _mm256_loadu_ps(best + i);
+        const __m256i mask = _mm256_castps_si256(_mm256_cmp_ps(s, b, _CMP_GT_OQ));
+        const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(best_class + i));
+        _mm256_storeu_ps(best + i, _mm256_max_ps(b, s));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(best_class + i), _mm256_blendv_epi8(c, vc8, mask));
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i vc = _mm_set1_epi32(class_id);
+    for (; i + 4 <= n; i += 4) {
+        const __m128 s = _mm_loadu_ps(row + i);
+        const __m128 b = _mm_loadu_ps(best + i);
+        const __m128i mask = _mm_castps_si128(_mm_cmpgt_ps(s, b));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(best_class + i));
+        _mm_storeu_ps(best + i, _mm_max_ps(b, s));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(best_class + i),
+                         _mm_or_si128(_mm_and_si128(mask, vc), _mm_andnot_si128(mask, c)));
+    }
+#elif defined(__ARM_NEON)
+    const int32x4_t vc = vdupq_n_s32(class_id);
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t s = vld1q_f32(row + i);
+        const float32x4_t b = vld1q_f32(best + i);
+        const uint32x4_t mask = vcgtq_f32(s, b);
+        vst1q_f32(best + i, vmaxq_f32(b, s));
+        vst1q_s32(best_class + i, vbslq_s32(mask, vc, vld1q_s32(best_class + i)));
+    }
+#endif
+    for (; i < n; ++i) {
+        if (row[i] > best[i]) {
+            best[i] = row[i];
+            best_class[i] = class_id;
+        }
+    }
+}
+
+} // namespace
+
+Decoder::Decoder(int capacity)
+    : candidates_(static_cast<size_t>(std::max(capacity, 1))),
+      best_score_(kTile),
+      best_class_(kTile) {}
+
+void Decoder::set_classes(const int32_t* class_ids, int count, uint32_t generation) {
+    classes_.clear();
+    if (class_ids != nullptr) {
+        for (int i = 0; i < count; ++i) {
+            if (class_ids[i] >= 0) {
+                classes_.push_back(class_ids[i]);
+            }
+        }
+    }
+    std::sort(classes_.begin(), classes_.end());
+    classes_.erase(std::unique(classes_.begin(), classes_.end()), classes_.end());
+    classes_generation_ = generation;
+}
+
+int Decoder::decode(const float* output, int channels, int anchors, float score_threshold) {
+    if (output == nullptr || channels <= kBoxRows || anchors <= 0) {
+        throw std::invalid_argument("Invalid YOLOv8 output geometry");
+    }
+
+    const int classes = channels - kBoxRows;
+    if (classes_.empty()) {
+        if (classes == kYolov8nCoco.classes && anchors == kYolov8nCoco.anchors) {
+            return decode_geometry<kYolov8nCoco.classes, kYolov8nCoco.anchors>(output, classes, anchors,
+                                                                               score_threshold);
+        }
+        if (classes == kDobbleModel.classes && anchors == kDobbleModel.anchors) {
+            return decode_geometry<kDobbleModel.classes, kDobbleModel.anchors>(output, classes, anchors,
+                                                                               score_threshold);
+        }
+    } else if (anchors == kYolov8nCoco.anchors) {
+        // The allow-list decides the rows, but the anchor stride is still known.
+        static_assert(kDobbleModel.anchors == kYolov8nCoco.anchors, "shipped models share one anchor layout");
+        return decode_geometry<0, kYolov8nCoco.anchors>(output, classes, anchors, score_threshold);
+    }
+    return decode_geometry<0, 0>(output, classes, anchors, score_threshold);
+}
+
+template <int kClasses, int kAnchors>
+int Decoder::decode_geometry(const float* output, int classes, int anchors, float score_threshold) {
+    if constexpr (kClasses > 0) {
+        classes = kClasses;
+    }
+    if constexpr (kAnchors > 0) {
+        anchors = kAnchors;
+    }
+
+    const float* cx = output;
+    const float* cy = output + anchors;
+    const float* w = output + 2 * anchors;
+    const float* h = output + 3 * anchors;
+    const float* scores = output + kBoxRows * static_cast<size_t>(anchors);
+
+    const int capacity = static_cast<int>(candidates_.size());
+    count_ = 0;
+    overflow_ = 0;
+
+    // Wanted rows this model has; the list is sorted, so they are a prefix.
+    const int32_t* wanted = classes_.data();
+    const int wanted_count =
+        static_cast<int>(std::lower_bound(classes_.begin(), classes_.end(), classes) - classes_.begin());
+    if (!classes_.empty() && wanted_count == 0) {
+        return 0;
+    }
+
+    for (int begin = 0; begin < anchors; begin += kTile) {
+        const int n = std::min(kTile, anchors - begin);
+
+        if (wanted_count == 0) {
+            std::copy_n(scores + begin, n, best_score_.data());
+            std::fill_n(best_class_.data(), n, 0);
+            for (int c = 1; c < classes; ++c) {
+                update_best(scores + static_cast<size_t>(c) * anchors + begin, c,
+                            best_score_.data(), best_class_.data(), n);
+            }
+        } else {
+            std::copy_n(scores + static_cast<size_t>(wanted[0]) * anchors + begin, n, best_score_.data());
+            std::fill_n(best_class_.data(), n, wanted[0]);
+            for (int k = 1; k < wanted_count; ++k) {
+                update_best(scores + static_cast<size_t>(wanted[k]) * anchors + begin, wanted[k],
+                            best_score_.data(), best_class_.data(), n);
+            }
+        }
+
+        for (int i = 0; i < n; ++i) {
+            const float score = best_score_[i];
+            if (score < score_threshold) {
+                continue;
+            }
+            if (count_ == capacity) {
+                ++overflow_;
+                continue;
+            }
+            const int a = begin + i;
+            const float half_w = 0.5f * w[a];
+            const float half_h = 0.5f * h[a];
+            candidates_[count_++] = {cx[a] - half_w, cy[a] - half_h, cx[a] + half_w, cy[a] + half_h,
+                                     score, best_class_[i]};
+        }
+    }
+
+    return count_;
+}
+
+} // namespace spotitml
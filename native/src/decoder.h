@@ -0,0 +1,94 @@
+#pragma once
+
+#include "deck_geometry.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace spotitml {
+
+// Head geometry of a YOLOv8 detection model. Anchors follow from the input
+// size: one per cell of the stride 8, 16 and 32 grids.
+struct ModelGeometry {
+    int classes;
+    int input_size;
+    int anchors;
+};
+
+constexpr int yolov8_anchors(int input_size) {
+    return (input_size / 8) * (input_size / 8) + (input_size / 16) * (input_size / 16) +
+           (input_size / 32) * (input_size / 32);
+}
+
+// The models the app ships. An output with one of these shapes is decoded by
+// a specialization whose row count and anchor stride are compile-time
+// constants, so the class loop and tile walk are fully known to the compiler.
+inline constexpr ModelGeometry kYolov8nCoco{80, 640, yolov8_anchors(640)};
+inline constexpr ModelGeometry kDobbleModel{deck::kSymbols, 640, yolov8_anchors(640)};
+static_assert(kYolov8nCoco.anchors == 8400, "YOLOv8 at 640 has 8400 anchors");
+
+// A box that passed the score threshold, in model input pixel coordinates.
+struct Candidate {
+    float x1;
+    float y1;
+    float x2;
+    float y2;
+    float score;
+    int32_t class_id;
+};
+
+// Decodes the channel-major YOLOv8 head output [1, 4 + classes, anchors].
+//
+// Rows 0-3 hold cx, cy, w, h and the remaining rows one class score each.
+// Scores are reduced row by row over tiles of anchors, so every load is
+// contiguous and the running max/argmax for a tile stays in L1. Boxes are only
+// read for anchors whose best score clears the threshold.
+//
+// With a class allow-list only the listed class rows are read, so decode
+// work scales with the classes the caller wants rather than with the model.
+//
+// All buffers are sized once; decode() never allocates.
+class Decoder {
+public:
+    static constexpr int kBoxRows = 4;
+    static constexpr int kDefaultCapacity = 2048;
+
+    explicit Decoder(int capacity = kDefaultCapacity);
+
+    // Returns the number of candidates written to candidates().
+    int decode(const float* output, int channels, int anchors, float score_threshold);
+
+    // Restricts decode() to class_ids; nullptr / 0 scans every class. Ids the
+    // model does not have are ignored. generation tags the list so an owner
+    // can tell whether a decoder holds its latest one (classes_generation()).
+    void set_classes(const int32_t* class_ids, int count, uint32_t generation = 0);
+    const std::vector<int32_t>& classes() const { return classes_; }
+    uint32_t classes_generation() const { return classes_generation_; }
+
+    const Candidate* candidates() const { return candidates_.data(); }
+    int count() const { return count_; }
+    int capacity() const { return static_cast<int>(candidates_.size()); }
+
+    // Anchors above threshold that did not fit in the candidate array on the last decode.
+    int overflow() const { return overflow_; }
+
+private:
+    // decode() for one geometry; a zero template argument means the value is
+    // only known at run time and is taken from the matching argument.
+    template <int kClasses, int kAnchors>
+    int decode_geometry(const float* output, int classes, int anchors, float score_threshold);
+
+    std::vector<Candidate> candidates_;
+    int count_ = 0;
+    int overflow_ = 0;
+
+    // Per-tile running best score and class.
+    std::vector<float> best_score_;
+    std::vector<int32_t> best_class_;
+
+    // Sorted, unique allow-list; empty = every class.
+    std::vector<int32_t> classes_;
+    uint32_t classes_generation_ = 0;
+};
+
+} // namespace spotitml
@@ -0,0 +1,265 @@
+#include "embedding_index.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace spotitml {
+
+namespace {
+
+constexpr char kMagic[4] = {'S', 'P', 'E', 'M'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kFloat32 = 0;
+constexpr uint32_t kInt8 = 1;
+constexpr size_t kHeaderBytes = 24;
+
+uint32_t read_u32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16 |
+           static_cast<uint32_t>(p[3]) << 24;
+}
+
+float read_f32(const uint8_t* p) {
+    const uint32_t bits = read_u32(p);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+size_t round_up(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(__ARM_NEON)
+float horizontal_sum(const float* values, int n) {
+    float sum = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        sum += values[i];
+    }
+    return sum;
+}
+#endif
+
+} // namespace
+
+void EmbeddingIndex::AlignedDelete::operator()(void* p) const {
+    ::operator delete(p, std::align_val_t{kAlignment});
+}
+
+EmbeddingIndex::EmbeddingIndex(const char* path) {
+    const MappedFile file(path);
+    const uint8_t* data = file.data();
+    if (file.size() < kHeaderBytes || std::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not an embedding table");
+    }
+    const uint32_t version = read_u32(data + 4);
+    const uint32_t dim = read_u32(data + 8);
+    const uint32_t rows = read_u32(data + 12);
+    const uint32_t type = read_u32(data + 16);
+    if (version != kVersion || (type != kFloat32 && type != kInt8)) {
+        throw std::runtime_error("Unsupported embedding table version or element type");
+    }
+    if (dim == 0 || dim > kMaxDim || rows > kMaxRows) {
+        throw std::runtime_error("Invalid embedding table geometry");
+    }
+    quantized_ = type == kInt8;
+    const size_t element_bytes = quantized_ ? 1 : 4;
+    const size_t expected = kHeaderBytes + size_t{rows} * 4 + size_t{rows} * dim * element_bytes;
+    if (file.size() != expected) {
+        throw std::runtime_error("Embedding table size does not match its header");
+    }
+
+    dim_ = static_cast<int>(dim);
+    rows_ = static_cast<int>(rows);
+    stride_ = static_cast<int>(round_up(dim, kAlignment / element_bytes));
+    const size_t row_bytes = stride_ * element_bytes;
+    matrix_.reset(static_cast<uint8_t*>(::operator new(std::max<size_t>(rows * row_bytes, 1), std::align_val_t{kAlignment})));
+    query_.reset(static_cast<uint8_t*>(::operator new(row_bytes, std::align_val_t{kAlignment})));
+    std::memset(matrix_.get(), 0, rows * row_bytes);
+    std::memset(query_.get(), 0, row_bytes);
+
+    const uint8_t* cursor = data + kHeaderBytes;
+    class_ids_.resize(rows);
+    for (uint32_t i = 0; i < rows; ++i, cursor += 4) {
+        class_ids_[i] = static_cast<int32_t>(read_u32(cursor));
+    }
+    scales_.assign(quantized_ ? rows : 0, 0.0f);
+
+    for (uint32_t i = 0; i < rows; ++i) {
+        uint8_t* row = matrix_.get() + i * row_bytes;
+        double norm = 0.0;
+        if (quantized_) {
+            std::memcpy(row, cursor, dim);
+            const int8_t* values = reinterpret_cast<const int8_t*>(row);
+            for (uint32_t j = 0; j < dim; ++j) {
+                norm += static_cast<double>(values[j]) * values[j];
+            }
+            // The int8 values stay as stored; only their norm is kept.
+            scales_[i] = norm > 0.0 ? static_cast<float>(1.0 / std::sqrt(norm)) : 0.0f;
+        } else {
+            float* values = reinterpret_cast<float*>(row);
+            for (uint32_t j = 0; j < dim; ++j) {
+                values[j] = read_f32(cursor + 4 * j);
+                norm += static_cast<double>(values[j]) * values[j];
+            }
+            const float inverse = norm > 0.0 ? static_cast<float>(1.0 / std::sqrt(norm)) : 0.0f;
+            for (uint32_t j = 0; j < dim; ++j) {
+                values[j] *= inverse;
+            }
+        }
+        cursor += dim * element_bytes;
+    }
+}
+
+float EmbeddingIndex::dot_float(int row) const {
+    const float* a = reinterpret_cast<const float*>(matrix_.get()) + static_cast<size_t>(row) * stride_;
+    const float* b = reinterpret_cast<const float*>(query_.get());
+    float lanes[8];
+    int i = 0;
+    // The stride is a multiple of 16 floats, so there is never a tail.
+#if defined(__AVX2__)
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; i < stride_; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_load_ps(a + i), _mm256_load_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_load_ps(a + i + 8), _mm256_load_ps(b + i + 8), acc1);
+    }
+    _mm256_storeu_ps(lanes, _mm256_add_ps(acc0, acc1));
+    return horizontal_sum(lanes, 8);
+#elif defined(__SSE2__)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i < stride_; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_load_ps(a + i), _mm_load_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_load_ps(a + i + 4), _mm_load_ps(b + i + 4)));
+    }
+    _mm_storeu_ps(lanes, _mm_add_ps(acc0, acc1));
+    return horizontal_sum(lanes, 4);
+#elif defined(__ARM_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i < stride_; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    vst1q_f32(lanes, vaddq_f32(acc0, acc1));
+    return horizontal_sum(lanes, 4);
+#else
+    float sum = 0.0f;
+    for (; i < stride_; ++i) {
+        sum += a[i] * b[i];
+    }
+    (void)lanes;
+    return sum;
+#endif
+}
+
+int32_t EmbeddingIndex::dot_int8(int row) const {
+    const int8_t* a = reinterpret_cast<const int8_t*>(matrix_.get()) + static_cast<size_t>(row) * stride_;
+    const int8_t* b = reinterpret_cast<const int8_t*>(query_.get());
+    int32_t lanes[8];
+    int i = 0;
+    // Products are widened to 16 bits and summed pairwise into 32-bit lanes,
+    // which cannot overflow for kMaxDim elements. The stride is a multiple of
+    // 64 bytes.
+#if defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    for (; i < stride_; i += 16) {
+        const __m256i va = _mm256_cvtepi8_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(a + i)));
+        const __m256i vb = _mm256_cvtepi8_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(b + i)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+#elif defined(__SSE2__)
+    __m128i acc = _mm_setzero_si128();
+    for (; i < stride_; i += 16) {
+        const __m128i va = _mm_load_si128(reinterpret_cast<const __m128i*>(a + i));
+        const __m128i vb = _mm_load_si128(reinterpret_cast<const __m128i*>(b + i));
+        // Sign-extend by placing each byte in the high half and shifting down.
+        const __m128i a_lo = _mm_srai_epi16(_mm_unpacklo_epi8(va, va), 8);
+        const __m128i a_hi = _mm_srai_epi16(_mm_unpackhi_epi8(va, va), 8);
+        const __m128i b_lo = _mm_srai_epi16(_mm_unpacklo_epi8(vb, vb), 8);
+        const __m128i b_hi = _mm_srai_epi16(_mm_unpackhi_epi8(vb, vb), 8);
+        acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_madd_epi16(a_lo, b_lo), _mm_madd_epi16(a_hi, b_hi)));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__ARM_NEON)
+    int32x4_t acc = vdupq_n_s32(0);
+    for (; i < stride_; i += 16) {
+        const int8x16_t va = vld1q_s8(a + i);
+        const int8x16_t vb = vld1q_s8(b + i);
+        acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(va), vget_low_s8(vb)));
+        acc = vpadalq_s16(acc, vmull_s8(vget_high_s8(va), vget_high_s8(vb)));
+    }
+    vst1q_s32(lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#else
+    int32_t sum = 0;
+    for (; i < stride_; ++i) {
+        sum += static_cast<int32_t>(a[i]) * b[i];
+    }
+    (void)lanes;
+    return sum;
+#endif
+}
+
+int EmbeddingIndex::nearest(const float* query, float* similarity) {
+    if (rows_ == 0) {
+        *similarity = 0.0f;
+        return -1;
+    }
+    double norm = 0.0;
+    float peak = 0.0f;
+    for (int j = 0; j < dim_; ++j) {
+        norm += static_cast<double>(query[j]) * query[j];
+        peak = std::max(peak, std::fabs(query[j]));
+    }
+    const float inverse = norm > 0.0 ? static_cast<float>(1.0 / std::sqrt(norm)) : 0.0f;
+
+    int best = 0;
+    float best_similarity = -2.0f;
+    if (quantized_) {
+        // Symmetric int8 quantization of the query; its scale and norm are
+        // common to every row, so they are applied once at the end.
+        int8_t* q = reinterpret_cast<int8_t*>(query_.get());
+        const float to_int8 = peak > 0.0f ? 127.0f / peak : 0.0f;
+        for (int j = 0; j < dim_; ++j) {
+            q[j] = static_cast<int8_t>(std::lround(query[j] * to_int8));
+        }
+        for (int row = 0; row < rows_; ++row) {
+            const float s = static_cast<float>(dot_int8(row)) * scales_[row];
+            if (s > best_similarity) {
+                best_similarity = s;
+                best = row;
+            }
+        }
+        best_similarity *= peak > 0.0f ? inverse / to_int8 : 0.0f;
+    } else {
+        float* q = reinterpret_cast<float*>(query_.get());
+        for (int j = 0; j < dim_; ++j) {
+            q[j] = query[j] * inverse;
+        }
+        for (int row = 0; row < rows_; ++row) {
+            const float s = dot_float(row);
+            if (s > best_similarity) {
+                best_similarity = s;
+                best = row;
+            }
+        }
+    }
+    *similarity = best_similarity;
+    return class_ids_[best];
+}
+
+} // namespace spotitml
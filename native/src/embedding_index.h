@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace spotitml {
+
+// Nearest-neighbor lookup of symbol embeddings by cosine similarity.
+//
+// The table is a compact binary file, so a new deck is a new file rather
+// than a retrained detector. Little endian:
+//
+//   char     magic[4]           "SPEM"
+//   uint32   version            1
+//   uint32   dim                embedding length
+//   uint32   count              rows
+//   uint32   element_type       0 = float32, 1 = int8
+//   uint32   reserved           0
+//   int32    class_ids[count]   detector class reported for each row
+//   ...      rows[count][dim]   float32 or int8, row-major
+//
+// Several rows may share a class (e.g. one per symbol rendering). Only the
+// direction of a row matters, so int8 rows need no scale. Rows are
+// normalized to unit length on load and copied into one 64-byte aligned
+// matrix whose row stride is padded with zeros to whole SIMD vectors, so a
+// query is a straight sweep of dot products with no row tails. int8 tables
+// are searched with an int8 copy of the query and integer multiply-adds,
+// which quarters the bytes streamed per row.
+class EmbeddingIndex {
+public:
+    static constexpr size_t kAlignment = 64;
+    static constexpr int kMaxDim = 4096;
+    static constexpr int kMaxRows = 65536;
+
+    EmbeddingIndex() = default;
+    // Throws std::runtime_error on a missing or malformed table.
+    explicit EmbeddingIndex(const char* path);
+
+    EmbeddingIndex(EmbeddingIndex&&) noexcept = default;
+    EmbeddingIndex& operator=(EmbeddingIndex&&) noexcept = default;
+
+    // Row most similar to query (dim floats, any length; it is normalized
+    // here). Writes its cosine similarity to similarity and returns its class
+    // id, or -1 for an empty index.
+    int nearest(const float* query, float* similarity);
+
+    int dim() const { return dim_; }
+    int rows() const { return rows_; }
+    bool quantized() const { return quantized_; }
+    bool empty() const { return rows_ == 0; }
+
+private:
+    struct AlignedDelete {
+        void operator()(void* p) const;
+    };
+
+    float dot_float(int row) const;
+    int32_t dot_int8(int row) const;
+
+    int dim_ = 0;
+    int rows_ = 0;
+    int stride_ = 0;  // elements per padded row
+    bool quantized_ = false;
+    std::unique_ptr<uint8_t, AlignedDelete> matrix_;
+    std::vector<int32_t> class_ids_;
+    std::vector<float> scales_;  // int8: inverse norm of each row
+
+    // Padded, normalized (and for int8 quantized) copy of the current query.
+    std::unique_ptr<uint8_t, AlignedDelete> query_;
+};
+
+} // namespace spotitml
@@ -0,0 +1,639 @@
+#include "engine.h"
+#include "instrumentation.h"
+#include "log.h"
+#include "mapped_file.h"
+#include "model_cache.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#if defined(__ANDROID__) && __has_include("nnapi_provider_factory.h")
+#include "nnapi_provider_factory.h"
+#define SPOTITML_HAS_NNAPI 1
+#else
+#define SPOTITML_HAS_NNAPI 0
+#endif
+
+namespace spotitml {
+
+namespace {
+
+GraphOptimizationLevel to_ort_optimization(int32_t level) {
+    switch (level) {
+    case SPOTITML_OPTIMIZE_DISABLED:
+        return ORT_DISABLE_ALL;
+    case SPOTITML_OPTIMIZE_BASIC:
+        return ORT_ENABLE_BASIC;
+    case SPOTITML_OPTIMIZE_EXTENDED:
+        return ORT_ENABLE_EXTENDED;
+    default:
+        return ORT_ENABLE_ALL;
+    }
+}
+
+// Name ONNX Runtime lists the provider under in GetAvailableProviders().
+const char* provider_name(int32_t provider) {
+    switch (provider) {
+    case SPOTITML_PROVIDER_XNNPACK:
+        return "XnnpackExecutionProvider";
+    case SPOTITML_PROVIDER_NNAPI:
+        return "NnapiExecutionProvider";
+    case SPOTITML_PROVIDER_COREML:
+        return "CoreMLExecutionProvider";
+    default:
+        return "CPUExecutionProvider";
+    }
+}
+
+// Registers one provider; throws Ort::Exception if the runtime rejects it.
+// Returns false when this build has no way to register it at all.
+bool append_provider(Ort::SessionOptions& session_options, int32_t provider,
+                     const spotitml_engine_options& options) {
+    switch (provider) {
+    case SPOTITML_PROVIDER_XNNPACK: {
+        std::unordered_map<std::string, std::string> provider_options;
+        if (options.intra_op_threads > 0) {
+            provider_options["intra_op_num_threads"] = std::to_string(options.intra_op_threads);
+        }
+        session_options.AppendExecutionProvider("XNNPACK", provider_options);
+        return true;
+    }
+    case SPOTITML_PROVIDER_NNAPI:
+#if SPOTITML_HAS_NNAPI
+        Ort::ThrowOnError(OrtSessionOptionsAppendExecutionProvider_Nnapi(session_options, 0));
+        return true;
+#else
+        return false;
+#endif
+    case SPOTITML_PROVIDER_COREML:
+#if defined(__APPLE__)
+        session_options.AppendExecutionProvider("CoreML", {{"ModelFormat", "MLProgram"}});
+        return true;
+#else
+        return false;
+#endif
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+Ort::SessionOptions make_session_options(const spotitml_engine_options& options,
+                                         std::vector<int32_t>& active_providers) {
+    Ort::SessionOptions session_options;
+    if (options.intra_op_threads > 0) {
+        session_options.SetIntraOpNumThreads(options.intra_op_threads);
+    }
+    if (options.inter_op_threads > 0) {
+        session_options.SetInterOpNumThreads(options.inter_op_threads);
+    }
+    session_options.SetGraphOptimizationLevel(to_ort_optimization(options.graph_optimization));
+    session_options.SetExecutionMode(options.execution_mode == SPOTITML_EXECUTION_PARALLEL ? ORT_PARALLEL
+                                                                                         : ORT_SEQUENTIAL);
+    if (options.enable_cpu_mem_arena != 0) {
+        session_options.EnableCpuMemArena();
+    } else {
+        session_options.DisableCpuMemArena();
+    }
+    if (options.enable_mem_pattern != 0) {
+        session_options.EnableMemPattern();
+    } else {
+        session_options.DisableMemPattern();
+    }
+
+    const std::vector<std::string> available = Ort::GetAvailableProviders();
+    const int count = std::clamp(options.provider_count, 0, SPOTITML_MAX_PROVIDERS);
+    active_providers.clear();
+    for (int i = 0; i < count; ++i) {
+        const int32_t provider = options.providers[i];
+        if (provider == SPOTITML_PROVIDER_CPU ||
+            std::find(active_providers.begin(), active_providers.end(), provider) != active_providers.end() ||
+            std::find(available.begin(), available.end(), provider_name(provider)) == available.end()) {
+            continue;
+        }
+        try {
+            if (append_provider(session_options, provider, options)) {
+                active_providers.push_back(provider);
+            }
+        } catch (const Ort::Exception&) {
+            // Listed by the runtime but refused on this device; fall through.
+        }
+    }
+    // The CPU provider is implicit and always takes whatever is left.
+    active_providers.push_back(SPOTITML_PROVIDER_CPU);
+    return session_options;
+}
+
+OrtLoggingLevel to_ort_logging(int32_t severity) {
+    return static_cast<OrtLoggingLevel>(std::clamp(severity, 0, 4));
+}
+
+namespace {
+
+// Square input size used for dynamic spatial dimensions (YOLOv8's default).
+constexpr int64_t kDefaultInputSize = 640;
+
+// Dynamic dimensions are pinned so the tensors can be allocated once up
+// front: batch to 1, and an input's height and width to kDefaultInputSize.
+std::vector<int64_t> resolve_input_shape(std::vector<int64_t> shape) {
+    for (size_t i = 0; i < shape.size(); ++i) {
+        if (shape[i] <= 0) {
+            shape[i] = i >= 2 ? kDefaultInputSize : 1;
+        }
+    }
+    return shape;
+}
+
+size_t element_count(const std::vector<int64_t>& shape) {
+    return std::accumulate(shape.begin(), shape.end(), size_t{1},
+                           [](size_t acc, int64_t dim) { return acc * static_cast<size_t>(dim); });
+}
+
+// Upper bounds for detect_json() text: one detection object, and the
+// brackets plus the trailing size and timing fields.
+constexpr size_t kResultEntryChars = 160;
+constexpr size_t kResultHeaderChars = 192;
+
+// Everything detect_json() carves from the frame arena for a full result.
+size_t result_arena_bytes() {
+    const size_t detections = Nms::kDefaultMaxDetections * sizeof(spotitml_detection);
+    const size_t text = kResultHeaderChars + Nms::kDefaultMaxDetections * kResultEntryChars;
+    return detections + ScratchArena::kAlignment + text;
+}
+
+} // namespace
+
+Engine::Engine(const char* model_path, const spotitml_engine_options& options)
+    : options_(options),
+      env_(to_ort_logging(options.log_severity), "YOLOv8"),
+      session_(open_session(model_path)),
+      memory_info_(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)),
+      run_options_(nullptr),
+      frame_arena_(result_arena_bytes()) {
+    if (session_.GetInputCount() != 1 || session_.GetOutputCount() != 1) {
+        throw std::runtime_error("Expected a model with exactly one input and one output");
+    }
+
+    Ort::AllocatorWithDefaultOptions allocator;
+    input_name_ = session_.GetInputNameAllocated(0, allocator).get();
+    output_name_ = session_.GetOutputNameAllocated(0, allocator).get();
+
+    const std::vector<int64_t> declared_input = session_.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+    dynamic_batch_ = !declared_input.empty() && declared_input[0] <= 0;
+    input_shape_ = resolve_input_shape(declared_input);
+    if (input_shape_.size() != 4 || input_shape_[1] != 3) {
+        throw std::runtime_error("Expected an NCHW input with 3 channels");
+    }
+    output_shape_ = session_.GetOutputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+    if (std::any_of(output_shape_.begin() + std::min<size_t>(output_shape_.size(), 1), output_shape_.end(),
+                    [](int64_t dim) { return dim <= 0; })) {
+        // Anchor count follows the input size; only a run can tell.
+        output_shape_ = probe_output_shape();
+    }
+    if (output_shape_.size() != 3) {
+        throw std::runtime_error("Expected a [1, 4 + classes, anchors] output");
+    }
+    output_shape_[0] = 1;
+    // Reduced-precision variants convert internally; the tensors bound here
+    // are always float32.
+    if (session_.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetElementType() !=
+            ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT ||
+        session_.GetOutputTypeInfo(0).GetTensorTypeAndShapeInfo().GetElementType() !=
+            ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+        throw std::runtime_error("Expected float32 input and output (export FP16 models with keep_io_types)");
+    }
+
+    buffers_ = create_buffers();
+
+    spotitml_variant_report report{};
+    report.precision = SPOTITML_PRECISION_FP32;
+    report.status = SPOTITML_VARIANT_CHOSEN;
+    report.load_ms = load_stats_.load_ms;
+    variant_reports_.push_back(report);
+    instrumentation::record_load(load_stats_);
+}
+
+void Engine::set_variant(int32_t precision, std::vector<spotitml_variant_report> reports) {
+    precision_ = precision;
+    variant_reports_ = std::move(reports);
+}
+
+double Engine::time_inference(int runs) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; ++i) {
+        run_session(buffers_);
+    }
+    const double total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return runs > 0 ? total / runs : 0.0;
+}
+
+std::vector<int64_t> Engine::probe_output_shape() {
+    std::vector<float> input(element_count(input_shape_), 0.0f);
+    Ort::Value input_tensor =
+        Ort::Value::CreateTensor<float>(memory_info_, input.data(), input.size(), input_shape_.data(), input_shape_.size());
+    const char* input_names[] = {input_name_.c_str()};
+    const char* output_names[] = {output_name_.c_str()};
+    std::vector<Ort::Value> outputs = session_.Run(run_options_, input_names, &input_tensor, 1, output_names, 1);
+    return outputs.at(0).GetTensorTypeAndShapeInfo().GetShape();
+}
+
+Ort::Session Engine::open_session(const char* model_path) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const auto finish = [this, start](int32_t cache_state) {
+        load_stats_.load_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        load_stats_.cache_state = cache_state;
+    };
+
+    // The .onnx is parsed once into ONNX Runtime's own graph, so its mapping
+    // only lives for the duration of this call; nothing is read into a heap
+    // buffer first.
+    MappedFile model(model_path);
+    model.advise_sequential();
+    const auto load_onnx = [this, &model](const Ort::SessionOptions& session_options) {
+        return Ort::Session(env_, model.data(), model.size(), session_options);
+    };
+
+    Ort::SessionOptions session_options = make_session_options(options_, active_providers_);
+    if (options_.cache_dir == nullptr || options_.cache_dir[0] == '\0') {
+        Ort::Session session = load_onnx(session_options);
+        finish(SPOTITML_CACHE_DISABLED);
+        return session;
+    }
+    // NNAPI and CoreML compile their partitions into opaque nodes, which
+    // ONNX Runtime cannot write back out.
+    for (int32_t provider : active_providers_) {
+        if (provider == SPOTITML_PROVIDER_NNAPI || provider == SPOTITML_PROVIDER_COREML) {
+            Ort::Session session = load_onnx(session_options);
+            finish(SPOTITML_CACHE_BYPASSED);
+            return session;
+        }
+    }
+
+    const ModelCache cache(options_.cache_dir, model_path, model, options_, active_providers_);
+    if (cache.has_entry()) {
+        // Already optimized for these options; running the optimizer again
+        // would only cost time. ORT-format models can be used in place, so
+        // the session reads graph and initializers straight from the mapping,
+        // which therefore stays alive as long as the engine.
+        Ort::SessionOptions warm_options = make_session_options(options_, active_providers_);
+        warm_options.SetGraphOptimizationLevel(ORT_DISABLE_ALL);
+        warm_options.AddConfigEntry("session.load_model_format", "ORT");
+        warm_options.AddConfigEntry("session.use_ort_model_bytes_directly", "1");
+        warm_options.AddConfigEntry("session.use_ort_model_bytes_for_initializers", "1");
+        try {
+            MappedFile cached(cache.entry_path().c_str());
+            Ort::Session session(env_, cached.data(), cached.size(), warm_options);
+            model_mapping_ = std::move(cached);
+            finish(SPOTITML_CACHE_HIT);
+            return session;
+        } catch (const std::exception& e) {
+            // Corrupt or unreadable entry: rebuild it below.
+            SPOTITML_LOG(log::kWarn, "Discarding cached model %s: %s", cache.entry_path().c_str(), e.what());
+            cache.invalidate();
+        }
+    }
+
+    session_options.SetOptimizedModelFilePath(cache.staging_path().c_str());
+    session_options.AddConfigEntry("session.save_model_format", "ORT");
+    try {
+        Ort::Session session = load_onnx(session_options);
+        cache.commit();
+        finish(SPOTITML_CACHE_MISS);
+        return session;
+    } catch (const Ort::Exception& e) {
+        // Saving failed (e.g. a provider produced nodes that cannot be
+        // serialized); load without the cache rather than not at all.
+        SPOTITML_LOG(log::kWarn, "Model cache bypassed: %s", e.what());
+    }
+    Ort::Session session = load_onnx(make_session_options(options_, active_providers_));
+    finish(SPOTITML_CACHE_BYPASSED);
+    return session;
+}
+
+void Engine::warm_up(int runs) {
+    const auto start = std::chrono::steady_clock::now();
+    std::fill(buffers_.input.begin(), buffers_.input.end(), 0.0f);
+    for (int i = 0; i < runs; ++i) {
+        run_session(buffers_);
+    }
+    load_stats_.warmup_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    instrumentation::record_load(load_stats_);
+}
+
+InferenceBuffers Engine::create_buffers() const {
+    InferenceBuffers buffers;
+    buffers.input.assign(element_count(input_shape_), 0.0f);
+    buffers.output.assign(element_count(output_shape_), 0.0f);
+    buffers.input_tensor = Ort::Value::CreateTensor<float>(memory_info_, buffers.input.data(), buffers.input.size(),
+                                                           input_shape_.data(), input_shape_.size());
+    buffers.output_tensor = Ort::Value::CreateTensor<float>(memory_info_, buffers.output.data(), buffers.output.size(),
+                                                            output_shape_.data(), output_shape_.size());
+    return buffers;
+}
+
+Letterbox Engine::preprocess(const spotitml_frame& frame) {
+    preprocess(frame, preprocessor_, buffers_);
+    return buffers_.letterbox;
+}
+
+void Engine::preprocess(const spotitml_frame& frame, Preprocessor& preprocessor, InferenceBuffers& buffers) const {
+    SPOTITML_TIME_STAGE(instrumentation::kPreprocess);
+    buffers.letterbox = preprocessor.letterbox(frame, buffers.input.data(), input_width(), input_height());
+    buffers.source_width = frame.width;
+    buffers.source_height = frame.height;
+}
+
+void Engine::set_class_filter(const int32_t* class_ids, int count) {
+    std::lock_guard<std::mutex> lock(class_filter_mutex_);
+    class_filter_.assign(class_ids, class_ids + (class_ids != nullptr ? std::max(count, 0) : 0));
+    class_filter_generation_.fetch_add(1, std::memory_order_release);
+}
+
+std::vector<int32_t> Engine::class_filter() const {
+    std::lock_guard<std::mutex> lock(class_filter_mutex_);
+    return class_filter_;
+}
+
+void Engine::sync_class_filter(Decoder& decoder) const {
+    if (decoder.classes_generation() == class_filter_generation_.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(class_filter_mutex_);
+    decoder.set_classes(class_filter_.data(), static_cast<int>(class_filter_.size()),
+                        class_filter_generation_.load(std::memory_order_relaxed));
+}
+
+int Engine::decode(float score_threshold) {
+    sync_class_filter(decoder_);
+    return decoder_.decode(buffers_.output.data(), static_cast<int>(output_shape_[1]),
+                           static_cast<int>(output_shape_[2]), score_threshold);
+}
+
+int Engine::suppress(float iou_threshold) {
+    return nms_.run(decoder_.candidates(), decoder_.count(), iou_threshold);
+}
+
+int Engine::detect_rgb(const uint8_t* rgb, int width, int height, int row_stride,
+                       spotitml_detection* detections, int max_detections) {
+    spotitml_frame frame{};
+    frame.format = SPOTITML_FORMAT_RGB;
+    frame.width = width;
+    frame.height = height;
+    frame.planes[0] = rgb;
+    frame.row_strides[0] = row_stride;
+    return detect(frame, detections, max_detections);
+}
+
+const char* Engine::detect_json(const uint8_t* rgb, int width, int height) {
+    frame_arena_.reset();
+    auto* detections = frame_arena_.allocate<spotitml_detection>(Nms::kDefaultMaxDetections);
+    const int count = detect_rgb(rgb, width, height, width * 3, detections, Nms::kDefaultMaxDetections);
+
+    const size_t capacity = kResultHeaderChars + static_cast<size_t>(count) * kResultEntryChars;
+    char* text = frame_arena_.allocate<char>(capacity);
+    size_t length = std::snprintf(text, capacity, "{\"detections\":[");
+    for (int i = 0; i < count; ++i) {
+        const spotitml_detection& d = detections[i];
+        length += std::snprintf(text + length, capacity - length,
+                                "%s{\"class_id\":%d,\"score\":%.3f,\"box\":[%.1f,%.1f,%.1f,%.1f]}",
+                                i > 0 ? "," : "", d.class_id, d.score, d.x1, d.y1, d.x2, d.y2);
+        length = std::min(length, capacity - 1);
+    }
+    std::snprintf(text + length, capacity - length,
+                  "],\"width\":%d,\"height\":%d,\"preprocess_ms\":%.2f,\"inference_ms\":%.2f,"
+                  "\"postprocess_ms\":%.2f}",
+                  width, height, timings_.preprocess_ms, timings_.inference_ms, timings_.postprocess_ms);
+    return text;
+}
+
+int Engine::detect_cards(const spotitml_frame& frame, spotitml_card_result* cards, int max_cards) {
+    CardRegion regions[CardLocator::kMaxCards];
+    int count = 0;
+    {
+        SPOTITML_TIME_STAGE(instrumentation::kLocate);
+        count = card_locator_.locate(frame, regions, std::min(max_cards, CardLocator::kMaxCards));
+    }
+    if (count == 0 && max_cards > 0) {
+        regions[0] = CardRegion{0, 0, frame.width, frame.height, 0.0f};
+        count = 1;
+    }
+
+    // All crops go through the model together when it takes a batch.
+    spotitml_frame crops[CardLocator::kMaxCards];
+    spotitml_detection found[CardLocator::kMaxCards][SPOTITML_MAX_CARD_DETECTIONS];
+    int32_t found_counts[CardLocator::kMaxCards];
+    for (int i = 0; i < count; ++i) {
+        crops[i] = crop_frame(frame, regions[i].x, regions[i].y, regions[i].width, regions[i].height);
+    }
+    detect_batch(crops, count, found[0], SPOTITML_MAX_CARD_DETECTIONS, found_counts);
+
+    for (int i = 0; i < count; ++i) {
+        const CardRegion& region = regions[i];
+        spotitml_card_result& card = cards[i];
+        card.x1 = static_cast<float>(region.x);
+        card.y1 = static_cast<float>(region.y);
+        card.x2 = static_cast<float>(region.x + region.width);
+        card.y2 = static_cast<float>(region.y + region.height);
+        card.score = region.score;
+        card.detection_count = found_counts[i];
+        for (int j = 0; j < card.detection_count; ++j) {
+            spotitml_detection& d = card.detections[j];
+            d = found[i][j];
+            d.x1 += card.x1;
+            d.y1 += card.y1;
+            d.x2 += card.x1;
+            d.y2 += card.y1;
+        }
+    }
+    return count;
+}
+
+int Engine::detect_match(const spotitml_frame& frame, int deck_distance, spotitml_card_result* cards,
+                         spotitml_match* match) {
+    spotitml_card_result located[CardLocator::kMaxCards];
+    spotitml_card_result* results = cards != nullptr ? cards : located;
+    const int count = detect_cards(frame, results, CardLocator::kMaxCards);
+
+    // The crops already split the detections by card; a missing card stays empty.
+    SymbolSet symbols[2];
+    for (int i = 0; i < std::min(count, 2); ++i) {
+        for (int j = 0; j < results[i].detection_count; ++j) {
+            symbols[i].add(results[i].detections[j]);
+        }
+    }
+    const int found = deck_distance >= 0 ? solve_deck_match(symbols[0], symbols[1], deck_distance, match)
+                                         : solve_match(symbols[0], symbols[1], match);
+    match->card_count = count;
+    return found;
+}
+
+int Engine::detect(const spotitml_frame& frame, spotitml_detection* detections, int max_detections) {
+    using Clock = std::chrono::steady_clock;
+    const auto ms = [](Clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+
+    SPOTITML_FRAME_SCOPE(frames_detected_++);
+    SPOTITML_TIME_STAGE(instrumentation::kFrame);
+    const auto start = Clock::now();
+    preprocess(frame, preprocessor_, buffers_);
+    const auto preprocessed = Clock::now();
+    infer(buffers_);
+    const auto inferred = Clock::now();
+    const int count = postprocess(buffers_, decoder_, nms_, detections, max_detections);
+
+    timings_.preprocess_ms = ms(preprocessed - start);
+    timings_.inference_ms = ms(inferred - preprocessed);
+    timings_.postprocess_ms = ms(Clock::now() - inferred);
+    SPOTITML_COUNT(instrumentation::kFramesProcessed, 1);
+    return count;
+}
+
+int Engine::prepare_batch(int size) {
+    const int index = size - 1;
+    if (batch_.input_tensors.empty()) {
+        for (int i = 0; i < kMaxBatch; ++i) {
+            batch_.input_tensors.emplace_back(nullptr);
+            batch_.output_tensors.emplace_back(nullptr);
+        }
+    }
+    // Both shapes have batch 1, so one image's counts are the strides.
+    const size_t input_count = static_cast<size_t>(size) * element_count(input_shape_);
+    const size_t output_count = static_cast<size_t>(size) * element_count(output_shape_);
+    if (batch_.input.size() < input_count || batch_.output.size() < output_count) {
+        batch_.input.resize(std::max(batch_.input.size(), input_count));
+        batch_.output.resize(std::max(batch_.output.size(), output_count));
+        // The storage may have moved; every tensor over it is stale.
+        for (int i = 0; i < kMaxBatch; ++i) {
+            batch_.input_tensors[i] = Ort::Value(nullptr);
+            batch_.output_tensors[i] = Ort::Value(nullptr);
+        }
+    }
+    if (!batch_.input_tensors[index]) {
+        // Ranks were checked at load: NCHW input, [N, channels, anchors] output.
+        const std::array<int64_t, 4> input_shape = {size, input_shape_[1], input_shape_[2], input_shape_[3]};
+        const std::array<int64_t, 3> output_shape = {size, output_shape_[1], output_shape_[2]};
+        batch_.input_tensors[index] = Ort::Value::CreateTensor<float>(
+            memory_info_, batch_.input.data(), input_count, input_shape.data(), input_shape.size());
+        batch_.output_tensors[index] = Ort::Value::CreateTensor<float>(
+            memory_info_, batch_.output.data(), output_count, output_shape.data(), output_shape.size());
+    }
+    return index;
+}
+
+void Engine::detect_batch(const spotitml_frame* frames, int count, spotitml_detection* detections,
+                          int max_detections, int32_t* counts) {
+    if (!dynamic_batch_) {
+        for (int i = 0; i < count; ++i) {
+            counts[i] = detect(frames[i], detections + static_cast<size_t>(i) * max_detections, max_detections);
+        }
+        return;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto ms = [](Clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+    const size_t input_stride = element_count(input_shape_);
+    const size_t output_stride = element_count(output_shape_);
+    timings_ = StageTimings{};
+
+    for (int first = 0; first < count; first += kMaxBatch) {
+        const int size = std::min(count - first, kMaxBatch);
+        SPOTITML_FRAME_SCOPE(frames_detected_);
+        frames_detected_ += size;
+        SPOTITML_TIME_STAGE(instrumentation::kFrame);
+        const int tensors = prepare_batch(size);
+
+        const auto start = Clock::now();
+        for (int i = 0; i < size; ++i) {
+            SPOTITML_TIME_STAGE(instrumentation::kPreprocess);
+            batch_.letterboxes[i] = preprocessor_.letterbox(frames[first + i], batch_.input.data() + i * input_stride,
+                                                            input_width(), input_height());
+        }
+        const auto preprocessed = Clock::now();
+        {
+            SPOTITML_TIME_STAGE(instrumentation::kInference);
+            const char* input_names[] = {input_name_.c_str()};
+            const char* output_names[] = {output_name_.c_str()};
+            session_.Run(run_options_, input_names, &batch_.input_tensors[tensors], 1, output_names,
+                         &batch_.output_tensors[tensors], 1);
+        }
+        const auto inferred = Clock::now();
+        for (int i = 0; i < size; ++i) {
+            const spotitml_frame& frame = frames[first + i];
+            counts[first + i] = postprocess(batch_.output.data() + i * output_stride, batch_.letterboxes[i],
+                                            frame.width, frame.height, decoder_, nms_,
+                                            detections + static_cast<size_t>(first + i) * max_detections,
+                                            max_detections);
+        }
+
+        timings_.preprocess_ms += ms(preprocessed - start);
+        timings_.inference_ms += ms(inferred - preprocessed);
+        timings_.postprocess_ms += ms(Clock::now() - inferred);
+        SPOTITML_COUNT(instrumentation::kFramesProcessed, size);
+    }
+}
+
+int Engine::postprocess(const InferenceBuffers& buffers, Decoder& decoder, Nms& nms,
+                        spotitml_detection* detections, int max_detections) const {
+    return postprocess(buffers.output.data(), buffers.letterbox, buffers.source_width, buffers.source_height, decoder,
+                       nms, detections, max_detections);
+}
+
+int Engine::postprocess(const float* output, const Letterbox& letterbox, int source_width, int source_height,
+                        Decoder& decoder, Nms& nms, spotitml_detection* detections, int max_detections) const {
+    {
+        SPOTITML_TIME_STAGE(instrumentation::kDecode);
+        sync_class_filter(decoder);
+        decoder.decode(output, static_cast<int>(output_shape_[1]),
+                       static_cast<int>(output_shape_[2]), options_.score_threshold);
+    }
+    int count = 0;
+    {
+        SPOTITML_TIME_STAGE(instrumentation::kNms);
+        count = std::min(nms.run(decoder.candidates(), decoder.count(), options_.iou_threshold), max_detections);
+    }
+    SPOTITML_COUNT(instrumentation::kCandidates, decoder.count());
+    SPOTITML_COUNT(instrumentation::kCandidateOverflow, decoder.overflow());
+    SPOTITML_COUNT(instrumentation::kDetections, count);
+
+    for (int i = 0; i < count; ++i) {
+        const Candidate& c = nms.detections()[i];
+        spotitml_detection& d = detections[i];
+        d.x1 = c.x1;
+        d.y1 = c.y1;
+        d.x2 = c.x2;
+        d.y2 = c.y2;
+        unletterbox_box(letterbox, source_width, source_height, d.x1, d.y1, d.x2, d.y2);
+        d.score = c.score;
+        d.class_id = c.class_id;
+    }
+    return count;
+}
+
+void Engine::run() {
+    infer(buffers_);
+}
+
+void Engine::infer(InferenceBuffers& buffers) {
+    SPOTITML_TIME_STAGE(instrumentation::kInference);
+    run_session(buffers);
+}
+
+void Engine::run_session(InferenceBuffers& buffers) {
+    const char* input_names[] = {input_name_.c_str()};
+    const char* output_names[] = {output_name_.c_str()};
+    session_.Run(run_options_, input_names, &buffers.input_tensor, 1, output_names, &buffers.output_tensor, 1);
+}
+
+} // namespace spotitml
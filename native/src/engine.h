@@ -0,0 +1,243 @@
+#pragma once
+
+#include "spotitml_native.h"
+#include "arena.h"
+#include "card_locator.h"
+#include "decoder.h"
+#include "mapped_file.h"
+#include "match_solver.h"
+#include "nms.h"
+#include "preprocess.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "onnxruntime_cxx_api.h"
+
+namespace spotitml {
+
+// Wall-clock time spent in each stage of the last detect call.
+struct StageTimings {
+    double preprocess_ms = 0.0;
+    double inference_ms = 0.0;
+    double postprocess_ms = 0.0;
+};
+
+// Builds the session options and the list of providers that were actually
+// registered. Providers missing from this runtime or platform are skipped, so
+// the session always comes up, at worst on the CPU provider alone. Shared by
+// every session the library creates.
+Ort::SessionOptions make_session_options(const spotitml_engine_options& options,
+                                         std::vector<int32_t>& active_providers);
+
+// spotitml_engine_options::log_severity as an ONNX Runtime logging level.
+OrtLoggingLevel to_ort_logging(int32_t severity);
+
+// Input/output tensors for one frame in flight, bound to buffers that are
+// allocated once. The engine owns one set for detect(); a pipelined worker
+// owns one per in-flight frame so stages can work on different frames.
+struct InferenceBuffers {
+    std::vector<float> input;
+    std::vector<float> output;
+    Ort::Value input_tensor{nullptr};
+    Ort::Value output_tensor{nullptr};
+
+    // Where the source frame landed in the input tensor.
+    Letterbox letterbox;
+    int source_width = 0;
+    int source_height = 0;
+};
+
+// Owns everything needed to run one model repeatedly: a single Ort::Env, the
+// prepared Ort::Session, cached input/output names and tensors bound to
+// buffers that are allocated once at construction.
+class Engine {
+public:
+    Engine(const char* model_path, const spotitml_engine_options& options);
+
+    Engine(const Engine&) = delete;
+    Engine& operator=(const Engine&) = delete;
+
+    // Runs the session on input_data(), writing into output_data().
+    void run();
+
+    float* input_data() { return buffers_.input.data(); }
+    const float* output_data() const { return buffers_.output.data(); }
+    size_t input_size() const { return buffers_.input.size(); }
+    size_t output_size() const { return buffers_.output.size(); }
+
+    const std::vector<int64_t>& input_shape() const { return input_shape_; }
+    const std::vector<int64_t>& output_shape() const { return output_shape_; }
+
+    // NCHW input geometry.
+    int input_width() const { return static_cast<int>(input_shape_[3]); }
+    int input_height() const { return static_cast<int>(input_shape_[2]); }
+
+    // Letterboxes a camera frame straight into the input tensor.
+    Letterbox preprocess(const spotitml_frame& frame);
+
+    // Decodes the last run's output into decoder().candidates().
+    int decode(float score_threshold);
+    const Decoder& decoder() const { return decoder_; }
+
+    // Restricts decoding to class_ids (nullptr / 0 for every class), so only
+    // those class rows of the output are scanned. May be called while other
+    // threads postprocess; each decoder picks the list up on its next frame.
+    void set_class_filter(const int32_t* class_ids, int count);
+    std::vector<int32_t> class_filter() const;
+
+    // Runs NMS over the decoded candidates into nms().detections().
+    int suppress(float iou_threshold);
+    const Nms& nms() const { return nms_; }
+
+    // The three stages of detect() on caller-owned state, so they can run on
+    // different threads for different frames. Each Preprocessor / Decoder /
+    // Nms must only be used by one thread at a time; infer() may run while
+    // other buffers are being pre- or postprocessed.
+    InferenceBuffers create_buffers() const;
+    void preprocess(const spotitml_frame& frame, Preprocessor& preprocessor, InferenceBuffers& buffers) const;
+    void infer(InferenceBuffers& buffers);
+    int postprocess(const InferenceBuffers& buffers, Decoder& decoder, Nms& nms,
+                    spotitml_detection* detections, int max_detections) const;
+
+    // Whole pipeline on one frame. Detections are written in source image
+    // coordinates; returns how many were written.
+    int detect(const spotitml_frame& frame, spotitml_detection* detections, int max_detections);
+    int detect_rgb(const uint8_t* rgb, int width, int height, int row_stride,
+                   spotitml_detection* detections, int max_detections);
+    const StageTimings& last_timings() const { return timings_; }
+
+    // Largest batch detect_batch() sends through one session run; bigger
+    // batches are split.
+    static constexpr int kMaxBatch = 8;
+
+    // True if the model's batch axis is dynamic (e.g. exported with
+    // dynamic=True), so detect_batch() can run several frames at once.
+    bool dynamic_batch() const { return dynamic_batch_; }
+
+    // Detects on count frames. With a dynamic batch axis they are letterboxed
+    // back to back into one [count, 3, H, W] tensor and run in one session
+    // run, which amortizes the per-run overhead and gives the intra-op
+    // threads larger kernels; otherwise they run one by one. Frame i writes
+    // at most max_detections results to detections + i * max_detections and
+    // their number to counts[i].
+    void detect_batch(const spotitml_frame* frames, int count, spotitml_detection* detections, int max_detections,
+                      int32_t* counts);
+
+    // Localizes up to max_cards cards and runs detect_batch() on their crops;
+    // falls back to the whole frame when none is found. Returns the number
+    // of results written.
+    int detect_cards(const spotitml_frame& frame, spotitml_card_result* cards, int max_cards);
+
+    // detect_cards() and solve_match() on the two largest cards, or
+    // solve_deck_match() if deck_distance >= 0. cards, if not nullptr,
+    // receives the CardLocator::kMaxCards card results. Returns 1 if the
+    // cards share a symbol, else 0.
+    int detect_match(const spotitml_frame& frame, int deck_distance, spotitml_card_result* cards,
+                     spotitml_match* match);
+
+    // detect_rgb() with the result rendered as the JSON document returned by
+    // detect_objects(). Detections and text live in a per-engine frame arena,
+    // so the pointer stays valid until the next detect_json() on this engine.
+    const char* detect_json(const uint8_t* rgb, int width, int height);
+
+    // spotitml_execution_provider values the session was created with,
+    // highest priority first; always ends with CPU.
+    const std::vector<int32_t>& active_providers() const { return active_providers_; }
+
+    const spotitml_load_stats& load_stats() const { return load_stats_; }
+
+    // Precision of the loaded variant and how every candidate fared when it
+    // was picked by an EngineSpec. A plain engine reports its one model as
+    // the chosen FP32 variant.
+    int32_t precision() const { return precision_; }
+    const std::vector<spotitml_variant_report>& variant_reports() const { return variant_reports_; }
+    void set_variant(int32_t precision, std::vector<spotitml_variant_report> reports);
+
+    // Mean wall-clock time of one session run over runs runs.
+    double time_inference(int runs);
+
+    // Runs the session on an all-zero input so weights are faulted in, kernels
+    // are selected and the arenas reach their steady-state size before the
+    // first real frame. Records the time in load_stats().warmup_ms.
+    void warm_up(int runs);
+
+private:
+    // Creates the session, going through the optimized-model cache when
+    // options_.cache_dir is set; fills active_providers_ and load_stats_.
+    Ort::Session open_session(const char* model_path);
+
+    // infer() without the stage timer, for warm-up and benchmarking runs.
+    void run_session(InferenceBuffers& buffers);
+
+    // Output shape of a run on input_shape_, for models whose output
+    // dimensions are dynamic.
+    std::vector<int64_t> probe_output_shape();
+
+    int postprocess(const float* output, const Letterbox& letterbox, int source_width, int source_height,
+                    Decoder& decoder, Nms& nms, spotitml_detection* detections, int max_detections) const;
+
+    // Hands decoder the current class filter if it holds an older one.
+    void sync_class_filter(Decoder& decoder) const;
+
+    // Contiguous tensors for detect_batch(). The vectors only grow, and each
+    // batch size keeps its own tensor pair over them, so alternating batch
+    // sizes (one card, then two) reuse tensors instead of re-creating them.
+    // Tensors are rebuilt only when the vectors grow.
+    struct BatchBuffers {
+        std::vector<float> input;
+        std::vector<float> output;
+        // Index size - 1 views the first size frames.
+        std::vector<Ort::Value> input_tensors;
+        std::vector<Ort::Value> output_tensors;
+        Letterbox letterboxes[kMaxBatch];
+    };
+    // Returns the index of the tensor pair for size frames.
+    int prepare_batch(int size);
+
+    spotitml_engine_options options_;
+    StageTimings timings_;
+    // Frame ids for spans recorded by detect(); worker frames use their own.
+    int64_t frames_detected_ = 0;
+    std::vector<int32_t> active_providers_;
+    spotitml_load_stats load_stats_{};
+    int32_t precision_ = SPOTITML_PRECISION_FP32;
+    std::vector<spotitml_variant_report> variant_reports_;
+    // Backs the session when it uses a cached ORT-format model in place; must
+    // outlive session_ (declared before it, so destroyed after it).
+    MappedFile model_mapping_;
+
+    Ort::Env env_;
+    Ort::Session session_;
+    Ort::MemoryInfo memory_info_;
+    Ort::RunOptions run_options_;
+
+    std::string input_name_;
+    std::string output_name_;
+    std::vector<int64_t> input_shape_;
+    std::vector<int64_t> output_shape_;
+
+    InferenceBuffers buffers_;
+    bool dynamic_batch_ = false;
+    BatchBuffers batch_;
+
+    // Bumped by every set_class_filter(); decoders compare it with their
+    // classes_generation(), so the lock is only taken when the list changed.
+    mutable std::mutex class_filter_mutex_;
+    std::vector<int32_t> class_filter_;
+    std::atomic<uint32_t> class_filter_generation_{0};
+
+    Preprocessor preprocessor_;
+    Decoder decoder_;
+    Nms nms_;
+    CardLocator card_locator_;
+
+    // Reset at the start of each detect_json(); sized up front so steady
+    // state never reaches the heap.
+    ScratchArena frame_arena_;
+};
+
+} // namespace spotitml
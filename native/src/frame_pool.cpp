@@ -0,0 +1,74 @@
+#include "frame_pool.h"
+
+#include <new>
+#include <stdexcept>
+
+namespace spotitml {
+
+namespace {
+
+int lowest_set_bit(uint32_t mask) {
+    int index = 0;
+    while ((mask & 1u) == 0) {
+        mask >>= 1;
+        ++index;
+    }
+    return index;
+}
+
+} // namespace
+
+FramePool::FramePool(int buffer_count, size_t buffer_size)
+    : buffer_size_(buffer_size),
+      free_mask_(0) {
+    if (buffer_count <= 0 || buffer_count > kMaxBuffers || buffer_size == 0) {
+        throw std::invalid_argument("Invalid frame pool geometry");
+    }
+    // Round up so every buffer can be read in whole SIMD vectors.
+    const size_t padded = (buffer_size + kAlignment - 1) / kAlignment * kAlignment;
+    buffers_.reserve(buffer_count);
+    try {
+        for (int i = 0; i < buffer_count; ++i) {
+            buffers_.push_back(static_cast<uint8_t*>(::operator new(padded, std::align_val_t{kAlignment})));
+        }
+    } catch (...) {
+        for (uint8_t* buffer : buffers_) {
+            ::operator delete(buffer, std::align_val_t{kAlignment});
+        }
+        throw;
+    }
+    free_mask_.store(buffer_count == 32 ? ~0u : (1u << buffer_count) - 1, std::memory_order_release);
+}
+
+FramePool::~FramePool() {
+    for (uint8_t* buffer : buffers_) {
+        ::operator delete(buffer, std::align_val_t{kAlignment});
+    }
+}
+
+int FramePool::acquire() {
+    uint32_t mask = free_mask_.load(std::memory_order_acquire);
+    while (mask != 0) {
+        const int index = lowest_set_bit(mask);
+        if (free_mask_.compare_exchange_weak(mask, mask & ~(1u << index), std::memory_order_acq_rel)) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+void FramePool::release(int index) {
+    if (index >= 0 && index < buffer_count()) {
+        free_mask_.fetch_or(1u << index, std::memory_order_release);
+    }
+}
+
+bool FramePool::contains(int index, const uint8_t* data, size_t size) const {
+    if (index < 0 || index >= buffer_count() || data == nullptr) {
+        return false;
+    }
+    const uint8_t* begin = buffers_[index];
+    return data >= begin && size <= buffer_size_ && static_cast<size_t>(data - begin) <= buffer_size_ - size;
+}
+
+} // namespace spotitml
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace spotitml {
+
+// A small set of pre-allocated, cache-line aligned frame buffers shared with
+// the caller. The caller acquires a buffer, writes camera planes straight into
+// it and hands it to the engine or a worker, which reads it in place and
+// releases it when done. Acquire and release are lock-free.
+class FramePool {
+public:
+    static constexpr size_t kAlignment = 64;
+    static constexpr int kMaxBuffers = 32;
+
+    FramePool(int buffer_count, size_t buffer_size);
+    ~FramePool();
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    // Index of a free buffer, or -1 if all are in use.
+    int acquire();
+    void release(int index);
+
+    uint8_t* buffer(int index) const { return buffers_[index]; }
+    size_t buffer_size() const { return buffer_size_; }
+    int buffer_count() const { return static_cast<int>(buffers_.size()); }
+
+    // True if [data, data + size) lies inside buffer index.
+    bool contains(int index, const uint8_t* data, size_t size) const;
+
+private:
+    std::vector<uint8_t*> buffers_;
+    size_t buffer_size_;
+    // Bit i set = buffer i is free.
+    std::atomic<uint32_t> free_mask_;
+};
+
+} // namespace spotitml
@@ -0,0 +1,260 @@
+#include "instrumentation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace spotitml::instrumentation {
+
+namespace {
+
+// Log-linear microsecond buckets: exact below 16 us, then eight buckets per
+// power of two (at most 12.5% error) up to 2^32 us.
+constexpr int kLinearBuckets = 16;
+constexpr int kSubBucketBits = 3;
+constexpr int kSubBuckets = 1 << kSubBucketBits;
+constexpr int kMinExponent = 4;
+constexpr int kMaxExponent = 31;
+constexpr int kBucketCount = kLinearBuckets + (kMaxExponent - kMinExponent + 1) * kSubBuckets;
+
+int highest_bit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+int bucket_of(uint64_t us) {
+    if (us < kLinearBuckets) {
+        return static_cast<int>(us);
+    }
+    const int exponent = highest_bit(us);
+    if (exponent > kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    const int sub = static_cast<int>(us >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+    return kLinearBuckets + (exponent - kMinExponent) * kSubBuckets + sub;
+}
+
+// Midpoint of a bucket, in microseconds.
+double bucket_value(int bucket) {
+    if (bucket < kLinearBuckets) {
+        return bucket + 0.5;
+    }
+    const int exponent = kMinExponent + (bucket - kLinearBuckets) / kSubBuckets;
+    const int sub = (bucket - kLinearBuckets) % kSubBuckets;
+    const double width = std::ldexp(1.0, exponent - kSubBucketBits);
+    return (kSubBuckets + sub + 0.5) * width;
+}
+
+// Written by exactly one thread, so updates are plain relaxed load + store
+// rather than read-modify-writes; atomics only make concurrent snapshots
+// well-defined.
+template <typename T>
+void bump(std::atomic<T>& value, T amount) {
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+struct StageHistogram {
+    std::atomic<uint64_t> buckets[kBucketCount];
+    std::atomic<uint64_t> sum_ns;
+    std::atomic<uint64_t> max_ns;
+};
+
+struct ThreadBlock {
+    // Generation the data belongs to; stale blocks are cleared by their
+    // owner on its next write and skipped by snapshots.
+    std::atomic<uint64_t> epoch{0};
+    std::atomic<bool> in_use{false};
+    StageHistogram stages[kStageCount];
+    std::atomic<int64_t> counters[kCounterCount];
+
+    ThreadBlock() { clear(); }
+
+    void clear() {
+        for (StageHistogram& stage : stages) {
+            for (auto& bucket : stage.buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            stage.sum_ns.store(0, std::memory_order_relaxed);
+            stage.max_ns.store(0, std::memory_order_relaxed);
+        }
+        for (auto& counter : counters) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+// Blocks are never freed: a thread that exits hands its block (and the data
+// in it) to the next thread that starts recording.
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBlock>> blocks;
+    std::atomic<uint64_t> epoch{1};
+    spotitml_load_stats last_load{};
+};
+
+Registry& registry() {
+    // Leaked so thread_local leases can still return blocks during exit.
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+struct BlockLease {
+    ThreadBlock* block = nullptr;
+
+    ~BlockLease() {
+        if (block != nullptr) {
+            block->in_use.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local BlockLease t_lease;
+
+ThreadBlock& acquire_block() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (auto& block : r.blocks) {
+        bool expected = false;
+        if (block->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return *block;
+        }
+    }
+    r.blocks.push_back(std::make_unique<ThreadBlock>());
+    r.blocks.back()->in_use.store(true, std::memory_order_relaxed);
+    return *r.blocks.back();
+}
+
+// The calling thread's block, cleared first if a reset happened since its
+// last write.
+ThreadBlock& local_block() {
+    if (t_lease.block == nullptr) {
+        t_lease.block = &acquire_block();
+    }
+    ThreadBlock& block = *t_lease.block;
+    const uint64_t epoch = registry().epoch.load(std::memory_order_acquire);
+    if (block.epoch.load(std::memory_order_relaxed) != epoch) {
+        block.clear();
+        block.epoch.store(epoch, std::memory_order_release);
+    }
+    return block;
+}
+
+} // namespace
+
+const char* stage_name(Stage stage) {
+    static const char* const names[kStageCount] = {"preprocess", "inference", "decode", "nms", "frame", "locate"};
+    return names[stage];
+}
+
+void record(Stage stage, Clock::duration elapsed) {
+    const uint64_t ns = static_cast<uint64_t>(
+        std::max<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), 0));
+    StageHistogram& histogram = local_block().stages[stage];
+    bump<uint64_t>(histogram.buckets[bucket_of(ns / 1000)], 1);
+    bump<uint64_t>(histogram.sum_ns, ns);
+    if (ns > histogram.max_ns.load(std::memory_order_relaxed)) {
+        histogram.max_ns.store(ns, std::memory_order_relaxed);
+    }
+}
+
+void record_frame(int64_t frame_id, Clock::time_point submitted) {
+    const Clock::time_point now = Clock::now();
+    record(kFrame, now - submitted);
+    if (trace::capturing()) {
+        trace::frame_span(frame_id, submitted, now);
+    }
+}
+
+void add(Counter counter, int64_t amount) {
+    bump<int64_t>(local_block().counters[counter], amount);
+}
+
+void record_load(const spotitml_load_stats& stats) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.last_load = stats;
+}
+
+void snapshot(spotitml_stats* stats) {
+    *stats = spotitml_stats{};
+    stats->enabled = kEnabled ? 1 : 0;
+
+    std::vector<uint64_t> buckets(static_cast<size_t>(kStageCount) * kBucketCount, 0);
+    uint64_t sum_ns[kStageCount] = {};
+    uint64_t max_ns[kStageCount] = {};
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    stats->last_load = r.last_load;
+    const uint64_t epoch = r.epoch.load(std::memory_order_acquire);
+    for (const auto& block : r.blocks) {
+        if (block->epoch.load(std::memory_order_acquire) != epoch) {
+            continue;
+        }
+        ++stats->threads;
+        for (int s = 0; s < kStageCount; ++s) {
+            const StageHistogram& histogram = block->stages[s];
+            for (int b = 0; b < kBucketCount; ++b) {
+                buckets[static_cast<size_t>(s) * kBucketCount + b] +=
+                    histogram.buckets[b].load(std::memory_order_relaxed);
+            }
+            sum_ns[s] += histogram.sum_ns.load(std::memory_order_relaxed);
+            max_ns[s] = std::max(max_ns[s], histogram.max_ns.load(std::memory_order_relaxed));
+        }
+        stats->frames_submitted += block->counters[kFramesSubmitted].load(std::memory_order_relaxed);
+        stats->frames_dropped += block->counters[kFramesDropped].load(std::memory_order_relaxed);
+        stats->frames_processed += block->counters[kFramesProcessed].load(std::memory_order_relaxed);
+        stats->frames_failed += block->counters[kFramesFailed].load(std::memory_order_relaxed);
+        stats->frames_tracked += block->counters[kFramesTracked].load(std::memory_order_relaxed);
+        stats->candidates += block->counters[kCandidates].load(std::memory_order_relaxed);
+        stats->candidate_overflow += block->counters[kCandidateOverflow].load(std::memory_order_relaxed);
+        stats->detections += block->counters[kDetections].load(std::memory_order_relaxed);
+    }
+
+    for (int s = 0; s < kStageCount; ++s) {
+        const uint64_t* stage_buckets = &buckets[static_cast<size_t>(s) * kBucketCount];
+        // Counted from the buckets so percentiles stay consistent even if a
+        // writer was mid-update.
+        uint64_t count = 0;
+        for (int b = 0; b < kBucketCount; ++b) {
+            count += stage_buckets[b];
+        }
+        spotitml_stage_stats& out = stats->stages[s];
+        out.count = static_cast<int64_t>(count);
+        if (count == 0) {
+            continue;
+        }
+        out.mean_ms = static_cast<double>(sum_ns[s]) / count / 1e6;
+        out.max_ms = static_cast<double>(max_ns[s]) / 1e6;
+        const auto percentile = [&](double p) {
+            const uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(p * count)), 1);
+            uint64_t seen = 0;
+            for (int b = 0; b < kBucketCount; ++b) {
+                seen += stage_buckets[b];
+                if (seen >= rank) {
+                    return std::min(bucket_value(b) / 1e3, out.max_ms);
+                }
+            }
+            return out.max_ms;
+        };
+        out.p50_ms = percentile(0.50);
+        out.p95_ms = percentile(0.95);
+        out.p99_ms = percentile(0.99);
+    }
+}
+
+void reset() {
+    registry().epoch.fetch_add(1, std::memory_order_acq_rel);
+}
+
+} // namespace spotitml::instrumentation
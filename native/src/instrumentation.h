@@ -0,0 +1,112 @@
+#pragma once
+
+#include "spotitml_native.h"
+#include "trace.h"
+
+#include <chrono>
+#include <cstdint>
+
+// Hot-path instrumentation: per-stage latency histograms and event counters.
+//
+// Every thread records into its own block of histograms and counters, so the
+// hot path is a clock read plus a few uncontended relaxed stores; snapshot()
+// merges all blocks. While a trace capture runs (trace.h), stage timers also
+// record spans. Builds with SPOTITML_INSTRUMENTATION=0 compile the recording
+// macros to nothing, snapshots report enabled = 0 and traces stay empty.
+#ifndef SPOTITML_INSTRUMENTATION
+#define SPOTITML_INSTRUMENTATION 1
+#endif
+
+namespace spotitml::instrumentation {
+
+constexpr bool kEnabled = SPOTITML_INSTRUMENTATION != 0;
+
+enum Stage : int {
+    kPreprocess = SPOTITML_STAGE_PREPROCESS,
+    kInference = SPOTITML_STAGE_INFERENCE,
+    kDecode = SPOTITML_STAGE_DECODE,
+    kNms = SPOTITML_STAGE_NMS,
+    kFrame = SPOTITML_STAGE_FRAME,
+    kLocate = SPOTITML_STAGE_LOCATE,
+    kStageCount = SPOTITML_STAGE_COUNT,
+};
+
+enum Counter : int {
+    kFramesSubmitted,
+    kFramesDropped,
+    kFramesProcessed,
+    kFramesFailed,
+    kFramesTracked,
+    kCandidates,
+    kCandidateOverflow,
+    kDetections,
+    kCounterCount,
+};
+
+using Clock = std::chrono::steady_clock;
+
+const char* stage_name(Stage stage);
+
+void record(Stage stage, Clock::duration elapsed);
+// Submit-to-result latency of a worker frame, which spans threads.
+void record_frame(int64_t frame_id, Clock::time_point submitted);
+void add(Counter counter, int64_t amount);
+void record_load(const spotitml_load_stats& stats);
+
+// Merged view of every thread's data since the last reset().
+void snapshot(spotitml_stats* stats);
+// Takes effect on each thread at its next record()/add(), so it never races
+// with a writer.
+void reset();
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Stage stage) : stage_(stage), start_(Clock::now()) {}
+    ~ScopedTimer() {
+        const Clock::time_point end = Clock::now();
+        record(stage_, end - start_);
+        if (trace::capturing()) {
+            trace::complete(stage_name(stage_), start_, end);
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Stage stage_;
+    Clock::time_point start_;
+};
+
+// Timestamp for latencies that span threads (e.g. submit to result); a
+// constant when instrumentation is compiled out.
+inline Clock::time_point timestamp() {
+    if constexpr (kEnabled) {
+        return Clock::now();
+    } else {
+        return Clock::time_point{};
+    }
+}
+
+} // namespace spotitml::instrumentation
+
+#define SPOTITML_INSTR_CONCAT_(a, b) a##b
+#define SPOTITML_INSTR_CONCAT(a, b) SPOTITML_INSTR_CONCAT_(a, b)
+
+#if SPOTITML_INSTRUMENTATION
+// Times the rest of the enclosing scope into the given stage.
+#define SPOTITML_TIME_STAGE(stage) \
+    ::spotitml::instrumentation::ScopedTimer SPOTITML_INSTR_CONCAT(spotitml_timer_, __LINE__)(stage)
+#define SPOTITML_RECORD_FRAME(frame_id, submitted) ::spotitml::instrumentation::record_frame(frame_id, submitted)
+// Tags spans recorded in the rest of the enclosing scope with a frame id.
+#define SPOTITML_FRAME_SCOPE(frame_id) \
+    ::spotitml::trace::FrameScope SPOTITML_INSTR_CONCAT(spotitml_frame_, __LINE__)(frame_id)
+#define SPOTITML_THREAD_NAME(name) ::spotitml::trace::set_thread_name(name)
+#define SPOTITML_COUNT(counter, amount) ::spotitml::instrumentation::add(counter, amount)
+#else
+#define SPOTITML_TIME_STAGE(stage) ((void)0)
+#define SPOTITML_RECORD_FRAME(frame_id, submitted) ((void)0)
+#define SPOTITML_FRAME_SCOPE(frame_id) ((void)0)
+#define SPOTITML_THREAD_NAME(name) ((void)0)
+#define SPOTITML_COUNT(counter, amount) ((void)0)
+#endif
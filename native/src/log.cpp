@@ -0,0 +1,141 @@
+#include "log.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#endif
+
+namespace spotitml::log {
+
+std::atomic<int32_t> g_level{kInfo};
+
+namespace {
+
+constexpr size_t kLineSize = 256;
+constexpr size_t kQueueSize = 64;
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+struct Line {
+    Level level;
+    char text[kLineSize];
+};
+
+// Bounded queue drained by one logging thread that is started on the first
+// message. Leaked on purpose: the thread may still be writing while static
+// destructors run at exit.
+class Sink {
+public:
+    static Sink& instance() {
+        static Sink* sink = new Sink();
+        return *sink;
+    }
+
+    void push(const Line& line) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (count_ == kQueueSize) {
+                ++dropped_;
+                return;
+            }
+            lines_[(head_ + count_) % kQueueSize] = line;
+            ++count_;
+        }
+        wake_.notify_one();
+    }
+
+private:
+    Sink() {
+        std::thread(&Sink::drain, this).detach();
+    }
+
+    void drain() {
+        for (;;) {
+            Line line;
+            uint64_t dropped = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [this] { return count_ > 0; });
+                line = lines_[head_];
+                head_ = (head_ + 1) % kQueueSize;
+                --count_;
+                std::swap(dropped, dropped_);
+            }
+            if (dropped > 0) {
+                Line note{kWarn, {}};
+                std::snprintf(note.text, sizeof(note.text), "log queue full, %llu lines dropped",
+                              static_cast<unsigned long long>(dropped));
+                emit(note);
+            }
+            emit(line);
+        }
+    }
+
+    static void emit(const Line& line) {
+#ifdef __ANDROID__
+        static const int priorities[] = {ANDROID_LOG_DEBUG, ANDROID_LOG_INFO, ANDROID_LOG_WARN, ANDROID_LOG_ERROR};
+        __android_log_write(priorities[line.level], "spotitml", line.text);
+#else
+        static const char* const names[] = {"D", "I", "W", "E"};
+        std::fprintf(stderr, "spotitml %s: %s\n", names[line.level], line.text);
+#endif
+    }
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    Line lines_[kQueueSize];
+    size_t head_ = 0;
+    size_t count_ = 0;
+    uint64_t dropped_ = 0;
+};
+
+} // namespace
+
+void set_level(int32_t level) {
+    g_level.store(level < kDebug ? kDebug : level > kOff ? kOff : level, std::memory_order_relaxed);
+}
+
+bool RateLimit::allow(int64_t* suppressed) {
+    const int64_t now = now_ms();
+    int64_t start = window_start_ms_.load(std::memory_order_relaxed);
+    if (now - start >= kWindowMs && window_start_ms_.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+        in_window_.store(0, std::memory_order_relaxed);
+    }
+    if (in_window_.fetch_add(1, std::memory_order_relaxed) < kBurst) {
+        *suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void write(Level level, RateLimit& limit, const char* format, ...) {
+    int64_t suppressed = 0;
+    if (level >= kOff || !limit.allow(&suppressed)) {
+        return;
+    }
+
+    Line line{level, {}};
+    va_list args;
+    va_start(args, format);
+    int length = std::vsnprintf(line.text, sizeof(line.text), format, args);
+    va_end(args);
+    if (suppressed > 0 && length >= 0 && static_cast<size_t>(length) < sizeof(line.text)) {
+        std::snprintf(line.text + length, sizeof(line.text) - length, " (%lld similar suppressed)",
+                      static_cast<long long>(suppressed));
+    }
+    Sink::instance().push(line);
+}
+
+} // namespace spotitml::log
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "spotitml_native.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace spotitml::log {
+
+enum Level : int32_t {
+    kDebug = SPOTITML_LOG_DEBUG,
+    kInfo = SPOTITML_LOG_INFO,
+    kWarn = SPOTITML_LOG_WARN,
+    kError = SPOTITML_LOG_ERROR,
+    kOff = SPOTITML_LOG_OFF,
+};
+
+extern std::atomic<int32_t> g_level;
+
+inline bool enabled(Level level) {
+    return level >= g_level.load(std::memory_order_relaxed);
+}
+
+void set_level(int32_t level);
+
+// Lets at most kBurst messages from one call site through per kWindowMs; the
+// ones held back are counted and reported with the next message that passes.
+class RateLimit {
+public:
+    static constexpr int kBurst = 5;
+    static constexpr int64_t kWindowMs = 1000;
+
+    // True if a message may be written now; *suppressed receives how many
+    // were held back since the last one that was.
+    bool allow(int64_t* suppressed);
+
+private:
+    std::atomic<int64_t> window_start_ms_{INT64_MIN / 2};
+    std::atomic<int32_t> in_window_{0};
+    std::atomic<int64_t> suppressed_{0};
+};
+
+// Formats on the calling thread and queues the line for the logging thread;
+// never blocks on I/O. Lines are dropped (and counted) if the queue is full.
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((format(printf, 3, 4)))
+#endif
+void write(Level level, RateLimit& limit, const char* format, ...);
+
+} // namespace spotitml::log
+
+// printf-style; the arguments are not evaluated when the level is disabled.
+#define SPOTITML_LOG(level, ...)                                                   \
+    do {                                                                           \
+        if (::spotitml::log::enabled(level)) {                                     \
+            static ::spotitml::log::RateLimit spotitml_log_limit_;                 \
+            ::spotitml::log::write(level, spotitml_log_limit_, __VA_ARGS__);       \
+        }                                                                          \
+    } while (0)
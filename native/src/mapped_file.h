@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace spotitml {
+
+// Read-only memory mapping of a whole file.
+//
+// Pages are faulted in from the page cache on demand and shared with every
+// other mapping of the same file, so a model that is mapped rather than read
+// into a heap buffer costs no private resident memory, and mapping it again
+// (a second engine, a re-created session) is nearly free.
+class MappedFile {
+public:
+    MappedFile() = default;
+    // Throws std::runtime_error if the file cannot be opened or mapped.
+    explicit MappedFile(const char* path);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return data_ == nullptr; }
+
+    // Hints that the mapping will be read front to back once (model parsing).
+    void advise_sequential() const;
+
+private:
+    void unmap();
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+#if defined(_WIN32)
+    void* mapping_ = nullptr;
+#endif
+};
+
+} // namespace spotitml
@@ -0,0 +1,129 @@
+#include "match_solver.h"
+#include "deck.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace spotitml {
+
+namespace {
+
+bool contains_point(const float* card, float x, float y) {
+    return x >= card[0] && x < card[2] && y >= card[1] && y < card[3];
+}
+
+float center_distance2(const float* card, float x, float y) {
+    const float dx = (card[0] + card[2]) * 0.5f - x;
+    const float dy = (card[1] + card[3]) * 0.5f - y;
+    return dx * dx + dy * dy;
+}
+
+} // namespace
+
+void SymbolSet::clear() {
+    std::fill(std::begin(words_), std::end(words_), 0);
+}
+
+void SymbolSet::add(const spotitml_detection& detection) {
+    const int class_id = detection.class_id;
+    if (class_id < 0 || class_id >= kMaxSymbols) {
+        return;
+    }
+    if (!contains(class_id)) {
+        words_[class_id >> 6] |= uint64_t{1} << (class_id & 63);
+        best_[class_id] = &detection;
+    } else if (detection.score > best_[class_id]->score) {
+        best_[class_id] = &detection;
+    }
+}
+
+int SymbolSet::count() const {
+    int total = 0;
+    for (uint64_t word : words_) {
+        total += __builtin_popcountll(word);
+    }
+    return total;
+}
+
+int assign_card(const spotitml_detection& detection, const float* card_a, const float* card_b) {
+    const float x = (detection.x1 + detection.x2) * 0.5f;
+    const float y = (detection.y1 + detection.y2) * 0.5f;
+    const bool in_a = contains_point(card_a, x, y);
+    const bool in_b = contains_point(card_b, x, y);
+    if (in_a && in_b) {
+        return center_distance2(card_b, x, y) < center_distance2(card_a, x, y) ? 1 : 0;
+    }
+    return in_a ? 0 : in_b ? 1 : -1;
+}
+
+void split_by_card(const spotitml_detection* detections, int count, const float* card_a, const float* card_b,
+                   SymbolSet symbols[2]) {
+    for (int i = 0; i < count; ++i) {
+        const int card = assign_card(detections[i], card_a, card_b);
+        if (card >= 0) {
+            symbols[card].add(detections[i]);
+        }
+    }
+}
+
+int solve_match(const SymbolSet& a, const SymbolSet& b, spotitml_match* match) {
+    match->class_id = -1;
+    match->score = 0.0f;
+    match->shared_count = 0;
+    match->card_count = 2;
+    match->deck_cards[0] = -1;
+    match->deck_cards[1] = -1;
+    match->card_counts[0] = a.count();
+    match->card_counts[1] = b.count();
+    match->boxes[0] = spotitml_detection{};
+    match->boxes[1] = spotitml_detection{};
+
+    for (int w = 0; w < SymbolSet::kWords; ++w) {
+        uint64_t shared = a.words()[w] & b.words()[w];
+        match->shared_count += __builtin_popcountll(shared);
+        while (shared != 0) {
+            const int class_id = w * 64 + __builtin_ctzll(shared);
+            shared &= shared - 1;
+            const float score = a.best(class_id).score * b.best(class_id).score;
+            if (score > match->score || match->class_id < 0) {
+                match->class_id = class_id;
+                match->score = score;
+            }
+        }
+    }
+    if (match->class_id < 0) {
+        return 0;
+    }
+    match->boxes[0] = a.best(match->class_id);
+    match->boxes[1] = b.best(match->class_id);
+    return 1;
+}
+
+int solve_deck_match(const SymbolSet& a, const SymbolSet& b, int max_distance, spotitml_match* match) {
+    const int found = solve_match(a, b, match);
+    const SymbolSet* sides[2] = {&a, &b};
+    for (int i = 0; i < 2; ++i) {
+        match->deck_cards[i] = deck::snap(sides[i]->words()[0], max_distance);
+    }
+    if (match->deck_cards[0] < 0 || match->deck_cards[1] < 0) {
+        return found;
+    }
+    const int symbol = deck::shared_symbol(match->deck_cards[0], match->deck_cards[1]);
+    if (symbol < 0) {
+        return found;  // both sides look like the same card
+    }
+
+    match->class_id = symbol;
+    for (int i = 0; i < 2; ++i) {
+        if (sides[i]->contains(symbol)) {
+            match->boxes[i] = sides[i]->best(symbol);
+        } else {
+            match->boxes[i] = spotitml_detection{};
+            match->boxes[i].class_id = symbol;
+        }
+    }
+    match->score = match->boxes[0].score * match->boxes[1].score;
+    return 1;
+}
+
+} // namespace spotitml
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "spotitml_native.h"
+
+#include <cstdint>
+
+namespace spotitml {
+
+// Symbols found on one card: a bitset over the class vocabulary plus the
+// best-scoring box of each class present. Class ids outside the vocabulary
+// are ignored. Plain data; clear() before reuse.
+class SymbolSet {
+public:
+    static constexpr int kMaxSymbols = SPOTITML_MAX_SYMBOLS;
+    static constexpr int kWords = (kMaxSymbols + 63) / 64;
+
+    void clear();
+    // Keeps detection if it is the best of its class so far; detection must
+    // outlive the set.
+    void add(const spotitml_detection& detection);
+
+    bool contains(int class_id) const { return (words_[class_id >> 6] >> (class_id & 63) & 1) != 0; }
+    const spotitml_detection& best(int class_id) const { return *best_[class_id]; }
+    // Distinct classes in the set.
+    int count() const;
+
+    const uint64_t* words() const { return words_; }
+
+private:
+    uint64_t words_[kWords] = {};
+    const spotitml_detection* best_[kMaxSymbols] = {};
+};
+
+// Which of two card regions ({x1, y1, x2, y2}) a detection belongs to by its
+// center: 0 or 1, the nearer center if it lies inside both, -1 if inside neither.
+int assign_card(const spotitml_detection& detection, const float* card_a, const float* card_b);
+
+// Adds each of count detections to symbols[assign_card()]; detections on
+// neither card are dropped. symbols must be empty or hold earlier results.
+void split_by_card(const spotitml_detection* detections, int count, const float* card_a, const float* card_b,
+                   SymbolSet symbols[2]);
+
+// Intersects the two cards' bitsets word by word. A real pair of Dobble
+// cards shares exactly one symbol, so more than one shared class means a
+// false positive on at least one card; the class whose best boxes have the
+// highest score product wins. Fills match (card_count = 2, no deck cards)
+// and returns 1, or 0 if the cards share nothing.
+int solve_match(const SymbolSet& a, const SymbolSet& b, spotitml_match* match);
+
+// solve_match() corrected by the deck model: each side snaps to its nearest
+// deck card within max_distance, and the two cards' shared symbol replaces
+// the intersection, so a symbol the detector missed or a spurious shared
+// class no longer decides the answer. Falls back to solve_match() when a
+// side does not snap.
+int solve_deck_match(const SymbolSet& a, const SymbolSet& b, int max_distance, spotitml_match* match);
+
+} // namespace spotitml
@@ -0,0 +1,125 @@
+#include "model_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+#include "onnxruntime_cxx_api.h"
+
+namespace spotitml {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr uint64_t kFnvOffset = 1469598103934665603ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+// FNV-1a over 8-byte words (bytes for the tail); plenty to tell models apart
+// and about eight times faster than the bytewise variant. Multiplication only
+// carries upwards, so each step folds the high half back down; otherwise the
+// upper bytes of a word would never reach the low bits of the hash.
+uint64_t hash_update(uint64_t hash, const unsigned char* data, size_t size) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * kFnvPrime;
+        hash ^= hash >> 32;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ data[i]) * kFnvPrime;
+    }
+    return hash;
+}
+
+// Final avalanche (splitmix64) so every input bit reaches every key bit.
+uint64_t finalize(uint64_t hash) {
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+    return hash ^ (hash >> 31);
+}
+
+uint64_t hash_string(uint64_t hash, const std::string& text) {
+    return hash_update(hash, reinterpret_cast<const unsigned char*>(text.data()), text.size());
+}
+
+constexpr size_t kKeyDigits = 16;
+
+// True for <stem>-<16 lowercase hex digits>.ort and its .ort.tmp staging
+// file, the only names a cache for stem ever writes. Another model whose
+// stem merely starts with "<stem>-" does not match.
+bool is_entry_name(const std::string& name, const std::string& stem) {
+    const size_t key = stem.size() + 1;
+    if (name.size() < key + kKeyDigits || name.compare(0, stem.size(), stem) != 0 || name[stem.size()] != '-') {
+        return false;
+    }
+    for (size_t i = key; i < key + kKeyDigits; ++i) {
+        const char c = name[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    const std::string suffix = name.substr(key + kKeyDigits);
+    return suffix == ".ort" || suffix == ".ort.tmp";
+}
+
+} // namespace
+
+uint64_t hash_bytes(const uint8_t* data, size_t size) {
+    return hash_update(kFnvOffset, data, size);
+}
+
+ModelCache::ModelCache(const char* directory, const char* model_path, const MappedFile& model,
+                       const spotitml_engine_options& options, const std::vector<int32_t>& providers)
+    : directory_(directory),
+      stem_(fs::path(model_path).stem().string()) {
+    uint64_t key = hash_bytes(model.data(), model.size());
+    key = hash_string(key, Ort::GetVersionString());
+    // Only what changes the saved graph: thread counts and thresholds do not.
+    key = hash_string(key, "opt=" + std::to_string(options.graph_optimization) +
+                           ";mode=" + std::to_string(options.execution_mode));
+    for (int32_t provider : providers) {
+        key = hash_string(key, ";ep=" + std::to_string(provider));
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "-%016llx.ort", static_cast<unsigned long long>(finalize(key)));
+    entry_path_ = (fs::path(directory_) / (stem_ + name)).string();
+    staging_path_ = entry_path_ + ".tmp";
+
+    std::error_code error;
+    fs::create_directories(directory_, error);
+}
+
+bool ModelCache::has_entry() const {
+    std::error_code error;
+    return fs::is_regular_file(entry_path_, error) && fs::file_size(entry_path_, error) > 0;
+}
+
+void ModelCache::commit() const {
+    std::error_code error;
+    fs::rename(staging_path_, entry_path_, error);
+    if (error) {
+        fs::remove(staging_path_, error);
+        return;
+    }
+
+    const fs::path entry = fs::path(entry_path_).filename();
+    for (fs::directory_iterator it(directory_, error), end; !error && it != end; it.increment(error)) {
+        const fs::path name = it->path().filename();
+        if (name != entry && is_entry_name(name.string(), stem_)) {
+            std::error_code ignored;
+            fs::remove(it->path(), ignored);
+        }
+    }
+}
+
+void ModelCache::invalidate() const {
+    std::error_code error;
+    fs::remove(entry_path_, error);
+}
+
+} // namespace spotitml
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "spotitml_native.h"
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace spotitml {
+
+// On-disk cache of models already optimized by ONNX Runtime for this device.
+//
+// The first session for a model saves its optimized graph in ORT format
+// (flatbuffer, no protobuf parsing and no optimizer pass on load); later
+// sessions load that file instead. Entries are named
+// <model stem>-<key>.ort, where the key hashes the model bytes, the ONNX
+// Runtime version and the options that shape the optimized graph, so a new
+// model, runtime or setting simply misses. Entries for the same model stem
+// with another key are stale and are removed when a new entry is written.
+class ModelCache {
+public:
+    // model holds the bytes of model_path; hashing the mapping avoids a
+    // second read of the file.
+    ModelCache(const char* directory, const char* model_path, const MappedFile& model,
+               const spotitml_engine_options& options, const std::vector<int32_t>& providers);
+
+    const std::string& entry_path() const { return entry_path_; }
+    // Where the optimized model is written before commit() publishes it.
+    const std::string& staging_path() const { return staging_path_; }
+
+    bool has_entry() const;
+
+    // Moves the staged model into place and removes stale entries. Cache
+    // maintenance is best effort: failures leave the cache cold, nothing more.
+    void commit() const;
+    // Drops an entry ONNX Runtime refused to load.
+    void invalidate() const;
+
+private:
+    std::string directory_;
+    std::string stem_;
+    std::string entry_path_;
+    std::string staging_path_;
+};
+
+// 64-bit content hash of a buffer.
+uint64_t hash_bytes(const uint8_t* data, size_t size);
+
+} // namespace spotitml
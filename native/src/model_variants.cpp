@@ -0,0 +1,160 @@
+#include "model_variants.h"
+#include "engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace spotitml {
+
+namespace {
+
+// Lower is better.
+int accuracy_rank(int32_t precision) {
+    switch (precision) {
+    case SPOTITML_PRECISION_FP32:
+        return 0;
+    case SPOTITML_PRECISION_FP16:
+        return 1;
+    default:
+        return 2;
+    }
+}
+
+// Expected speed without measuring. The CPU provider has few FP16 kernels and
+// runs most of an FP16 graph through casts, so there FP16 is the slowest;
+// NNAPI and CoreML run FP16 natively and usually beat QDQ INT8.
+int speed_rank(int32_t precision, bool accelerated) {
+    switch (precision) {
+    case SPOTITML_PRECISION_INT8:
+        return accelerated ? 1 : 0;
+    case SPOTITML_PRECISION_FP16:
+        return accelerated ? 0 : 2;
+    default:
+        return accelerated ? 2 : 1;
+    }
+}
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+EngineSpec::EngineSpec(std::vector<ModelVariant> variants, int32_t policy, int bench_runs,
+                       const spotitml_engine_options& options)
+    : variants_(std::move(variants)),
+      policy_(policy),
+      bench_runs_(bench_runs > 0 ? bench_runs : kDefaultBenchRuns),
+      options_(options),
+      cache_dir_(options.cache_dir != nullptr ? options.cache_dir : ""),
+      has_cache_dir_(options.cache_dir != nullptr) {
+    if (variants_.empty()) {
+        throw std::invalid_argument("No model variants given");
+    }
+}
+
+spotitml_engine_options EngineSpec::options() const {
+    spotitml_engine_options options = options_;
+    options.cache_dir = has_cache_dir_ ? cache_dir_.c_str() : nullptr;
+    return options;
+}
+
+std::vector<int> EngineSpec::ranking() const {
+    bool accelerated = false;
+    for (int i = 0; i < std::clamp(options_.provider_count, 0, SPOTITML_MAX_PROVIDERS); ++i) {
+        accelerated |= options_.providers[i] == SPOTITML_PROVIDER_NNAPI ||
+                       options_.providers[i] == SPOTITML_PROVIDER_COREML;
+    }
+
+    std::vector<int> order(variants_.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<int>(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        const int32_t pa = variants_[a].precision;
+        const int32_t pb = variants_[b].precision;
+        return policy_ == SPOTITML_VARIANT_FASTEST ? speed_rank(pa, accelerated) < speed_rank(pb, accelerated)
+                                                   : accuracy_rank(pa) < accuracy_rank(pb);
+    });
+    return order;
+}
+
+std::unique_ptr<Engine> EngineSpec::create() const {
+    const spotitml_engine_options engine_options = options();
+    std::vector<spotitml_variant_report> reports(variants_.size());
+    for (size_t i = 0; i < variants_.size(); ++i) {
+        reports[i].precision = variants_[i].precision;
+        reports[i].status = SPOTITML_VARIANT_SKIPPED;
+    }
+
+    std::string last_error;
+    const auto load = [&](int index) -> std::unique_ptr<Engine> {
+        const auto start = std::chrono::steady_clock::now();
+        try {
+            auto engine = std::make_unique<Engine>(variants_[index].path.c_str(), engine_options);
+            reports[index].load_ms = elapsed_ms(start);
+            reports[index].status = SPOTITML_VARIANT_LOADED;
+            return engine;
+        } catch (const std::exception& e) {
+            reports[index].load_ms = elapsed_ms(start);
+            reports[index].status = SPOTITML_VARIANT_FAILED;
+            last_error = variants_[index].path + ": " + e.what();
+            return nullptr;
+        }
+    };
+
+    std::unique_ptr<Engine> chosen;
+    int chosen_index = -1;
+    if (policy_ != SPOTITML_VARIANT_AUTO) {
+        for (int index : ranking()) {
+            chosen = load(index);
+            if (chosen != nullptr) {
+                chosen_index = index;
+                break;
+            }
+        }
+    } else {
+        // Ranked most accurate first, so the first variant within the slack
+        // of the fastest is the most accurate acceptable one.
+        std::vector<std::unique_ptr<Engine>> engines(variants_.size());
+        double fastest_ms = -1.0;
+        for (int index : ranking()) {
+            engines[index] = load(index);
+            if (engines[index] == nullptr) {
+                continue;
+            }
+            try {
+                // The first run pays one-off costs; keep it out of the figure.
+                engines[index]->warm_up(1);
+                reports[index].inference_ms = engines[index]->time_inference(bench_runs_);
+            } catch (const std::exception& e) {
+                reports[index].status = SPOTITML_VARIANT_FAILED;
+                last_error = variants_[index].path + ": " + e.what();
+                engines[index].reset();
+                continue;
+            }
+            if (fastest_ms < 0.0 || reports[index].inference_ms < fastest_ms) {
+                fastest_ms = reports[index].inference_ms;
+            }
+        }
+        for (int index : ranking()) {
+            if (engines[index] != nullptr && reports[index].inference_ms <= fastest_ms * kAutoSlack) {
+                chosen_index = index;
+                break;
+            }
+        }
+        if (chosen_index >= 0) {
+            chosen = std::move(engines[chosen_index]);
+        }
+    }
+
+    if (chosen == nullptr) {
+        throw std::runtime_error("No model variant could be loaded (" + last_error + ")");
+    }
+    reports[chosen_index].status = SPOTITML_VARIANT_CHOSEN;
+    chosen->set_variant(variants_[chosen_index].precision, std::move(reports));
+    return chosen;
+}
+
+} // namespace spotitml
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "spotitml_native.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace spotitml {
+
+class Engine;
+
+struct ModelVariant {
+    std::string path;
+    int32_t precision = SPOTITML_PRECISION_FP32;  // spotitml_precision
+};
+
+// Everything needed to create an engine later, on another thread: owned
+// copies of the candidate model paths and the options (including cache_dir),
+// plus the policy that picks among the variants.
+//
+// FASTEST and MOST_ACCURATE rank the variants statically and load the first
+// one that works. AUTO loads every variant, times bench_runs inferences on
+// each and keeps the most accurate one within kAutoSlack of the fastest, so a
+// variant that is only marginally quicker does not cost accuracy.
+class EngineSpec {
+public:
+    static constexpr double kAutoSlack = 1.10;
+    static constexpr int kDefaultBenchRuns = 5;
+
+    EngineSpec(std::vector<ModelVariant> variants, int32_t policy, int bench_runs,
+               const spotitml_engine_options& options);
+
+    // Throws if no variant could be loaded. The engine records the outcome
+    // for every variant (variant_reports()).
+    std::unique_ptr<Engine> create() const;
+
+private:
+    spotitml_engine_options options() const;
+    // Variant indices in the order the policy tries them.
+    std::vector<int> ranking() const;
+
+    std::vector<ModelVariant> variants_;
+    int32_t policy_;
+    int bench_runs_;
+    spotitml_engine_options options_;
+    std::string cache_dir_;
+    bool has_cache_dir_;
+};
+
+} // namespace spotitml
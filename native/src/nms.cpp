@@ -0,0 +1,157 @@
+#include "nms.h"
+
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace spotitml {
+
+namespace {
+
+struct BoxArrays {
+    const float* x1;
+    const float* y1;
+    const float* x2;
+    const float* y2;
+    const float* area;
+};
+
+// suppressed[j] |= IoU(box, j) > threshold for j in [begin, end).
+// IoU > t is tested as inter > t * union to keep the loop division free.
+void suppress_overlaps(const BoxArrays& boxes, int box, float threshold, int32_t* suppressed, int begin, int end) {
+    const float bx1 = boxes.x1[box];
+    const float by1 = boxes.y1[box];
+    const float bx2 = boxes.x2[box];
+    const float by2 = boxes.y2[box];
+    const float barea = boxes.area[box];
+
+    int j = begin;
+#if defined(__AVX2__)
+    {
+        const __m256 vx1 = _mm256_set1_ps(bx1), vy1 = _mm256_set1_ps(by1);
+        const __m256 vx2 = _mm256_set1_ps(bx2), vy2 = _mm256_set1_ps(by2);
+        const __m256 varea = _mm256_set1_ps(barea), vt = _mm256_set1_ps(threshold);
+        const __m256 zero = _mm256_setzero_ps();
+        for (; j + 8 <= end; j += 8) {
+            const __m256 w = _mm256_max_ps(zero, _mm256_sub_ps(_mm256_min_ps(vx2, _mm256_loadu_ps(boxes.x2 + j)),
+                                                               _mm256_max_ps(vx1, _mm256_loadu_ps(boxes.x1 + j))));
+            const __m256 h = _mm256_max_ps(zero, _mm256_sub_ps(_mm256_min_ps(vy2, _mm256_loadu_ps(boxes.y2 + j)),
+                                                               _mm256_max_ps(vy1, _mm256_loadu_ps(boxes.y1 + j))));
+            const __m256 inter = _mm256_mul_ps(w, h);
+            const __m256 uni = _mm256_sub_ps(_mm256_add_ps(varea, _mm256_loadu_ps(boxes.area + j)), inter);
+            const __m256i mask = _mm256_castps_si256(_mm256_cmp_ps(inter, _mm256_mul_ps(vt, uni), _CMP_GT_OQ));
+            __m256i* out = reinterpret_cast<__m256i*>(suppressed + j);
+            _mm256_storeu_si256(out, _mm256_or_si256(_mm256_loadu_si256(out), mask));
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    {
+        const __m128 vx1 = _mm_set1_ps(bx1), vy1 = _mm_set1_ps(by1);
+        const __m128 vx2 = _mm_set1_ps(bx2), vy2 = _mm_set1_ps(by2);
+        const __m128 varea = _mm_set1_ps(barea), vt = _mm_set1_ps(threshold);
+        const __m128 zero = _mm_setzero_ps();
+        for (; j + 4 <= end; j += 4) {
+            const __m128 w = _mm_max_ps(zero, _mm_sub_ps(_mm_min_ps(vx2, _mm_loadu_ps(boxes.x2 + j)),
+                                                         _mm_max_ps(vx1, _mm_loadu_ps(boxes.x1 + j))));
+            const __m128 h = _mm_max_ps(zero, _mm_sub_ps(_mm_min_ps(vy2, _mm_loadu_ps(boxes.y2 + j)),
+                                                         _mm_max_ps(vy1, _mm_loadu_ps(boxes.y1 + j))));
+            const __m128 inter = _mm_mul_ps(w, h);
+            const __m128 uni = _mm_sub_ps(_mm_add_ps(varea, _mm_loadu_ps(boxes.area + j)), inter);
+            const __m128i mask = _mm_castps_si128(_mm_cmpgt_ps(inter, _mm_mul_ps(vt, uni)));
+            __m128i* out = reinterpret_cast<__m128i*>(suppressed + j);
+            _mm_storeu_si128(out, _mm_or_si128(_mm_loadu_si128(out), mask));
+        }
+    }
+#elif defined(__ARM_NEON)
+    {
+        const float32x4_t vx1 = vdupq_n_f32(bx1), vy1 = vdupq_n_f32(by1);
+        const float32x4_t vx2 = vdupq_n_f32(bx2), vy2 = vdupq_n_f32(by2);
+        const float32x4_t varea = vdupq_n_f32(barea);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        for (; j + 4 <= end; j += 4) {
+            const float32x4_t w = vmaxq_f32(zero, vsubq_f32(vminq_f32(vx2, vld1q_f32(boxes.x2 + j)),
+                                                            vmaxq_f32(vx1, vld1q_f32(boxes.x1 + j))));
+            const float32x4_t h = vmaxq_f32(zero, vsubq_f32(vminq_f32(vy2, vld1q_f32(boxes.y2 + j)),
+                                                            vmaxq_f32(vy1, vld1q_f32(boxes.y1 + j))));
+            const float32x4_t inter = vmulq_f32(w, h);
+            const float32x4_t uni = vsubq_f32(vaddq_f32(varea, vld1q_f32(boxes.area + j)), inter);
+            const uint32x4_t mask = vcgtq_f32(inter, vmulq_n_f32(uni, threshold));
+            int32_t* out = suppressed + j;
+            vst1q_s32(out, vorrq_s32(vld1q_s32(out), vreinterpretq_s32_u32(mask)));
+        }
+    }
+#endif
+    for (; j < end; ++j) {
+        const float w = std::max(0.0f, std::min(bx2, boxes.x2[j]) - std::max(bx1, boxes.x1[j]));
+        const float h = std::max(0.0f, std::min(by2, boxes.y2[j]) - std::max(by1, boxes.y1[j]));
+        const float inter = w * h;
+        if (inter > threshold * (barea + boxes.area[j] - inter)) {
+            suppressed[j] = -1;
+        }
+    }
+}
+
+} // namespace
+
+Nms::Nms(int max_candidates, int max_detections)
+    : max_candidates_(std::max(max_candidates, 1)),
+      detections_(static_cast<size_t>(std::max(max_detections, 1))),
+      x1_(max_candidates_),
+      y1_(max_candidates_),
+      x2_(max_candidates_),
+      y2_(max_candidates_),
+      area_(max_candidates_),
+      suppressed_(max_candidates_) {
+    // Room for a full decoder buffer, so run() only grows it for decoders
+    // built with a larger capacity.
+    order_.reserve(Decoder::kDefaultCapacity);
+}
+
+int Nms::run(const Candidate* candidates, int count, float iou_threshold, bool class_agnostic) {
+    count_ = 0;
+    if (candidates == nullptr || count <= 0) {
+        return 0;
+    }
+
+    // Grows to the largest candidate count seen, then stays put.
+    if (order_.size() < static_cast<size_t>(count)) {
+        order_.resize(count);
+    }
+    for (int i = 0; i < count; ++i) {
+        order_[i] = i;
+    }
+
+    const int n = std::min(count, max_candidates_);
+    std::partial_sort(order_.begin(), order_.begin() + n, order_.begin() + count,
+                      [candidates](int32_t a, int32_t b) { return candidates[a].score > candidates[b].score; });
+
+    for (int i = 0; i < n; ++i) {
+        const Candidate& c = candidates[order_[i]];
+        const float offset = class_agnostic ? 0.0f : c.class_id * kClassOffset;
+        x1_[i] = c.x1 + offset;
+        y1_[i] = c.y1 + offset;
+        x2_[i] = c.x2 + offset;
+        y2_[i] = c.y2 + offset;
+        area_[i] = std::max(0.0f, c.x2 - c.x1) * std::max(0.0f, c.y2 - c.y1);
+    }
+    std::fill_n(suppressed_.data(), n, 0);
+
+    const BoxArrays boxes{x1_.data(), y1_.data(), x2_.data(), y2_.data(), area_.data()};
+    const int max_detections = static_cast<int>(detections_.size());
+    for (int i = 0; i < n && count_ < max_detections; ++i) {
+        if (suppressed_[i] != 0) {
+            continue;
+        }
+        detections_[count_++] = candidates[order_[i]];
+        suppress_overlaps(boxes, i, iou_threshold, suppressed_.data(), i + 1, n);
+    }
+
+    return count_;
+}
+
+} // namespace spotitml
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "decoder.h"
+
+namespace spotitml {
+
+// Greedy non-maximum suppression over decoder candidates.
+//
+// Only the max_candidates best-scoring candidates are considered (partial
+// sort), which bounds the quadratic IoU work no matter how cluttered a card
+// is. Classes are batched in one pass by offsetting every box by
+// class_id * kClassOffset, so boxes of different classes can never overlap.
+// Boxes are kept as separate x1/y1/x2/y2/area arrays so the suppression loop
+// against one kept box is a straight SIMD sweep.
+//
+// All buffers are sized once; run() never allocates.
+//
+// Unlike the decoder, NMS is not specialized on ModelGeometry: its work is
+// bounded by the candidate cap, not by the class or anchor count, and the
+// suppression sweep is already a SIMD loop over runtime-sized arrays. Only
+// kClassOffset depends on the model, and it is checked against the shipped
+// geometries below.
+class Nms {
+public:
+    static constexpr int kDefaultMaxCandidates = 512;
+    static constexpr int kDefaultMaxDetections = 100;
+    // Larger than any model-space coordinate.
+    static constexpr float kClassOffset = 4096.0f;
+
+    explicit Nms(int max_candidates = kDefaultMaxCandidates, int max_detections = kDefaultMaxDetections);
+
+    // Returns the number of detections written to detections(), best score first.
+    int run(const Candidate* candidates, int count, float iou_threshold, bool class_agnostic = false);
+
+    const Candidate* detections() const { return detections_.data(); }
+    int count() const { return count_; }
+
+private:
+    int max_candidates_;
+    std::vector<Candidate> detections_;
+    int count_ = 0;
+
+    std::vector<int32_t> order_;
+    std::vector<float> x1_;
+    std::vector<float> y1_;
+    std::vector<float> x2_;
+    std::vector<float> y2_;
+    std::vector<float> area_;
+    std::vector<int32_t> suppressed_;
+};
+
+static_assert(Nms::kClassOffset > kYolov8nCoco.input_size && Nms::kClassOffset > kDobbleModel.input_size,
+              "class offset must exceed every shipped model's coordinates");
+
+} // namespace spotitml
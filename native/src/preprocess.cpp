@@ -0,0 +1,450 @@
+#include "preprocess.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace spotitml {
+
+namespace {
+
+// out[i] = a[i] + (b[i] - a[i]) * w
+void blend_rows(const float* a, const float* b, float w, float* out, int n) {
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256 vw = _mm256_set1_ps(w);
+    for (; i + 8 <= n; i += 8) {
+        const __m256 va = _mm256_loadu_ps(a + i);
+        const __m256 vb = _mm256_loadu_ps(b + i);
+        _mm256_storeu_ps(out + i, _mm256_add_ps(va, _mm256_mul_ps(_mm256_sub_ps(vb, va), vw)));
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128 vw4 = _mm_set1_ps(w);
+    for (; i + 4 <= n; i += 4) {
+        const __m128 va = _mm_loadu_ps(a + i);
+        const __m128 vb = _mm_loadu_ps(b + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), vw4)));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t va = vld1q_f32(a + i);
+        const float32x4_t vb = vld1q_f32(b + i);
+        vst1q_f32(out + i, vmlaq_n_f32(va, vsubq_f32(vb, va), w));
+    }
+#endif
+    for (; i < n; ++i) {
+        out[i] = a[i] + (b[i] - a[i]) * w;
+    }
+}
+
+// Source tap for destination index i when n_src samples are stretched over n_dst.
+void source_taps(int i, int n_src, int n_dst, int& i0, int& i1, float& w1) {
+    const float f = std::max(0.0f, (static_cast<float>(i) + 0.5f) * n_src / n_dst - 0.5f);
+    i0 = std::min(static_cast<int>(f), n_src - 1);
+    i1 = std::min(i0 + 1, n_src - 1);
+    w1 = f - static_cast<float>(i0);
+}
+
+// Full-range BT.601 (JFIF) YUV -> RGB, in place on blended rows already
+// scaled to [0, 1]. Conversion is linear, so converting after the bilinear
+// blend matches converting every source tap, at one conversion per output
+// pixel instead of two per tap per source row.
+void yuv_rows_to_rgb(float* y_r, float* u_g, float* v_b, int n) {
+    constexpr float kBias = 128.0f / 255.0f;
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 bias = _mm_set1_ps(kBias), zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    const __m128 kr = _mm_set1_ps(1.402f), kgu = _mm_set1_ps(0.344136f), kgv = _mm_set1_ps(0.714136f);
+    const __m128 kb = _mm_set1_ps(1.772f);
+    for (; i + 4 <= n; i += 4) {
+        const __m128 y = _mm_loadu_ps(y_r + i);
+        const __m128 u = _mm_sub_ps(_mm_loadu_ps(u_g + i), bias);
+        const __m128 v = _mm_sub_ps(_mm_loadu_ps(v_b + i), bias);
+        const __m128 r = _mm_add_ps(y, _mm_mul_ps(kr, v));
+        const __m128 g = _mm_sub_ps(_mm_sub_ps(y, _mm_mul_ps(kgu, u)), _mm_mul_ps(kgv, v));
+        const __m128 b = _mm_add_ps(y, _mm_mul_ps(kb, u));
+        _mm_storeu_ps(y_r + i, _mm_min_ps(_mm_max_ps(r, zero), one));
+        _mm_storeu_ps(u_g + i, _mm_min_ps(_mm_max_ps(g, zero), one));
+        _mm_storeu_ps(v_b + i, _mm_min_ps(_mm_max_ps(b, zero), one));
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t bias = vdupq_n_f32(kBias), zero = vdupq_n_f32(0.0f), one = vdupq_n_f32(1.0f);
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t y = vld1q_f32(y_r + i);
+        const float32x4_t u = vsubq_f32(vld1q_f32(u_g + i), bias);
+        const float32x4_t v = vsubq_f32(vld1q_f32(v_b + i), bias);
+        const float32x4_t r = vmlaq_n_f32(y, v, 1.402f);
+        const float32x4_t g = vmlsq_n_f32(vmlsq_n_f32(y, u, 0.344136f), v, 0.714136f);
+        const float32x4_t b = vmlaq_n_f32(y, u, 1.772f);
+        vst1q_f32(y_r + i, vminq_f32(vmaxq_f32(r, zero), one));
+        vst1q_f32(u_g + i, vminq_f32(vmaxq_f32(g, zero), one));
+        vst1q_f32(v_b + i, vminq_f32(vmaxq_f32(b, zero), one));
+    }
+#endif
+    for (; i < n; ++i) {
+        const float y = y_r[i];
+        const float u = u_g[i] - kBias;
+        const float v = v_b[i] - kBias;
+        y_r[i] = std::clamp(y + 1.402f * v, 0.0f, 1.0f);
+        u_g[i] = std::clamp(y - 0.344136f * u - 0.714136f * v, 0.0f, 1.0f);
+        v_b[i] = std::clamp(y + 1.772f * u, 0.0f, 1.0f);
+    }
+}
+
+bool is_yuv(const spotitml_frame& frame) {
+    return frame.format == SPOTITML_FORMAT_NV21 || frame.format == SPOTITML_FORMAT_YUV420;
+}
+
+// Horizontal pass for one source row: sample(x, c0, c1, c2) reads the three
+// channels (RGB or YUV) of source pixel x, and the two taps per output column
+// are blended into planar rows.
+template <typename Sample>
+void resample_taps(int columns, const int32_t* x0, const int32_t* x1, const float* w0, const float* w1,
+                   float* planes, Sample sample) {
+    float* p0 = planes;
+    float* p1 = planes + columns;
+    float* p2 = planes + 2 * columns;
+    for (int i = 0; i < columns; ++i) {
+        float a0, a1, a2, b0, b1, b2;
+        sample(x0[i], a0, a1, a2);
+        sample(x1[i], b0, b1, b2);
+        p0[i] = a0 * w0[i] + b0 * w1[i];
+        p1[i] = a1 * w0[i] + b1 * w1[i];
+        p2[i] = a2 * w0[i] + b2 * w1[i];
+    }
+}
+
+// Chroma plane of an NV21 frame, which may be passed as one contiguous buffer.
+const uint8_t* nv21_vu_plane(const spotitml_frame& frame) {
+    return frame.planes[1] != nullptr ? frame.planes[1]
+                                      : frame.planes[0] + static_cast<size_t>(frame.row_strides[0]) * frame.height;
+}
+
+void validate_frame(const spotitml_frame& frame) {
+    if (frame.width <= 0 || frame.height <= 0 || frame.planes[0] == nullptr) {
+        throw std::invalid_argument("Invalid frame");
+    }
+    switch (frame.format) {
+    case SPOTITML_FORMAT_RGB:
+        if (frame.row_strides[0] < frame.width * 3) {
+            throw std::invalid_argument("RGB row stride too small");
+        }
+        break;
+    case SPOTITML_FORMAT_BGRA:
+        if (frame.row_strides[0] < frame.width * 4) {
+            throw std::invalid_argument("BGRA row stride too small");
+        }
+        break;
+    case SPOTITML_FORMAT_NV21: {
+        // Interleaved V/U rows span two bytes per chroma column; a single
+        // buffer frame reads them with the luma stride.
+        const int vu_width = (frame.width + 1) / 2 * 2;
+        const int vu_stride = frame.planes[1] != nullptr ? frame.row_strides[1] : frame.row_strides[0];
+        if (frame.row_strides[0] < frame.width || vu_stride < vu_width) {
+            throw std::invalid_argument("NV21 row stride too small");
+        }
+        break;
+    }
+    case SPOTITML_FORMAT_YUV420:
+        if (frame.planes[1] == nullptr || frame.planes[2] == nullptr) {
+            throw std::invalid_argument("YUV420 frame needs three planes");
+        }
+        if (frame.row_strides[0] < frame.width) {
+            throw std::invalid_argument("YUV420 row stride too small");
+        }
+        for (int plane = 1; plane < 3; ++plane) {
+            const int step = frame.pixel_strides[plane] > 0 ? frame.pixel_strides[plane] : 1;
+            const int64_t chroma_row = static_cast<int64_t>((frame.width + 1) / 2 - 1) * step + 1;
+            if (frame.row_strides[plane] < chroma_row) {
+                throw std::invalid_argument("YUV420 chroma row stride too small");
+            }
+        }
+        break;
+    default:
+        throw std::invalid_argument("Unknown pixel format");
+    }
+}
+
+} // namespace
+
+Letterbox compute_letterbox(int src_width, int src_height, int dst_width, int dst_height) {
+    Letterbox letterbox;
+    letterbox.scale = std::min(static_cast<float>(dst_width) / src_width,
+                               static_cast<float>(dst_height) / src_height);
+    letterbox.resized_width = std::clamp(static_cast<int>(std::lround(src_width * letterbox.scale)), 1, dst_width);
+    letterbox.resized_height = std::clamp(static_cast<int>(std::lround(src_height * letterbox.scale)), 1, dst_height);
+    letterbox.pad_x = (dst_width - letterbox.resized_width) / 2;
+    letterbox.pad_y = (dst_height - letterbox.resized_height) / 2;
+    return letterbox;
+}
+
+int frame_plane_count(const spotitml_frame& frame) {
+    switch (frame.format) {
+    case SPOTITML_FORMAT_NV21:
+        return frame.planes[1] != nullptr ? 2 : 1;
+    case SPOTITML_FORMAT_YUV420:
+        return 3;
+    default:
+        return 1;
+    }
+}
+
+size_t frame_plane_size(const spotitml_frame& frame, int plane) {
+    const auto span = [](int rows, int row_stride, size_t last_row) {
+        return rows > 0 ? static_cast<size_t>(rows - 1) * row_stride + last_row : 0;
+    };
+    const int chroma_width = (frame.width + 1) / 2;
+    const int chroma_height = (frame.height + 1) / 2;
+
+    switch (frame.format) {
+    case SPOTITML_FORMAT_RGB:
+        return span(frame.height, frame.row_strides[0], frame.width * 3);
+    case SPOTITML_FORMAT_BGRA:
+        return span(frame.height, frame.row_strides[0], frame.width * 4);
+    case SPOTITML_FORMAT_NV21:
+        if (plane == 0 && frame.planes[1] == nullptr) {
+            // Y and VU share one buffer and one stride.
+            return static_cast<size_t>(frame.height) * frame.row_strides[0] +
+                   span(chroma_height, frame.row_strides[0], chroma_width * 2);
+        }
+        return plane == 0 ? span(frame.height, frame.row_strides[0], frame.width)
+                          : span(chroma_height, frame.row_strides[1], chroma_width * 2);
+    case SPOTITML_FORMAT_YUV420: {
+        if (plane == 0) {
+            return span(frame.height, frame.row_strides[0], frame.width);
+        }
+        const int step = frame.pixel_strides[plane] > 0 ? frame.pixel_strides[plane] : 1;
+        return span(chroma_height, frame.row_strides[plane], static_cast<size_t>(chroma_width - 1) * step + 1);
+    }
+    default:
+        return 0;
+    }
+}
+
+uint8_t frame_luma(const spotitml_frame& frame, int x, int y) {
+    const uint8_t* row = frame.planes[0] + static_cast<size_t>(y) * frame.row_strides[0];
+    switch (frame.format) {
+    case SPOTITML_FORMAT_RGB: {
+        const uint8_t* p = row + 3 * x;
+        return static_cast<uint8_t>((77 * p[0] + 150 * p[1] + 29 * p[2]) >> 8);
+    }
+    case SPOTITML_FORMAT_BGRA: {
+        const uint8_t* p = row + 4 * x;
+        return static_cast<uint8_t>((77 * p[2] + 150 * p[1] + 29 * p[0]) >> 8);
+    }
+    default:
+        return row[x];
+    }
+}
+
+spotitml_frame crop_frame(const spotitml_frame& frame, int x, int y, int width, int height) {
+    validate_frame(frame);
+    if (x < 0 || y < 0 || width <= 0 || height <= 0 || x + width > frame.width || y + height > frame.height) {
+        throw std::invalid_argument("Crop outside the frame");
+    }
+    if (is_yuv(frame) && ((x | y) & 1) != 0) {
+        throw std::invalid_argument("YUV crops must start on even coordinates");
+    }
+
+    spotitml_frame crop = frame;
+    crop.width = width;
+    crop.height = height;
+    const auto offset = [](const uint8_t* plane, int row, int stride, int column) {
+        return plane + static_cast<ptrdiff_t>(row) * stride + column;
+    };
+    switch (frame.format) {
+    case SPOTITML_FORMAT_RGB:
+        crop.planes[0] = offset(frame.planes[0], y, frame.row_strides[0], 3 * x);
+        break;
+    case SPOTITML_FORMAT_BGRA:
+        crop.planes[0] = offset(frame.planes[0], y, frame.row_strides[0], 4 * x);
+        break;
+    case SPOTITML_FORMAT_NV21:
+        // A single-buffer frame gets an explicit chroma plane; its VU data no
+        // longer directly follows the cropped luma.
+        crop.planes[1] = offset(nv21_vu_plane(frame), y / 2,
+                                frame.planes[1] != nullptr ? frame.row_strides[1] : frame.row_strides[0], x);
+        crop.row_strides[1] = frame.planes[1] != nullptr ? frame.row_strides[1] : frame.row_strides[0];
+        crop.planes[0] = offset(frame.planes[0], y, frame.row_strides[0], x);
+        break;
+    case SPOTITML_FORMAT_YUV420:
+        crop.planes[0] = offset(frame.planes[0], y, frame.row_strides[0], x);
+        for (int plane = 1; plane < 3; ++plane) {
+            const int step = frame.pixel_strides[plane] > 0 ? frame.pixel_strides[plane] : 1;
+            crop.planes[plane] = offset(frame.planes[plane], y / 2, frame.row_strides[plane], x / 2 * step);
+        }
+        break;
+    }
+    return crop;
+}
+
+void unletterbox_box(const Letterbox& letterbox, int src_width, int src_height,
+                     float& x1, float& y1, float& x2, float& y2) {
+    const float inv_scale = 1.0f / letterbox.scale;
+    const float max_x = static_cast<float>(src_width);
+    const float max_y = static_cast<float>(src_height);
+    x1 = std::clamp((x1 - letterbox.pad_x) * inv_scale, 0.0f, max_x);
+    y1 = std::clamp((y1 - letterbox.pad_y) * inv_scale, 0.0f, max_y);
+    x2 = std::clamp((x2 - letterbox.pad_x) * inv_scale, 0.0f, max_x);
+    y2 = std::clamp((y2 - letterbox.pad_y) * inv_scale, 0.0f, max_y);
+}
+
+void Preprocessor::prepare(const Letterbox& letterbox, int src_width, int src_height, int dst_width, int dst_height) {
+    src_width_ = src_width;
+    src_height_ = src_height;
+    dst_width_ = dst_width;
+    dst_height_ = dst_height;
+
+    const int columns = letterbox.resized_width;
+    x0_.resize(columns);
+    x1_.resize(columns);
+    wx0_.resize(columns);
+    wx1_.resize(columns);
+
+    // Normalization to [0, 1] is folded into the horizontal weights.
+    constexpr float kInv255 = 1.0f / 255.0f;
+    for (int i = 0; i < columns; ++i) {
+        int x0, x1;
+        float w1;
+        source_taps(i, src_width, columns, x0, x1, w1);
+        x0_[i] = x0;
+        x1_[i] = x1;
+        wx0_[i] = (1.0f - w1) * kInv255;
+        wx1_[i] = w1 * kInv255;
+    }
+
+    rows_.resize(2 * 3 * static_cast<size_t>(columns));
+}
+
+void Preprocessor::resample_row(const spotitml_frame& frame, int src_y, float* planes) {
+    const int columns = static_cast<int>(x0_.size());
+    const int32_t* x0 = x0_.data();
+    const int32_t* x1 = x1_.data();
+    const float* w0 = wx0_.data();
+    const float* w1 = wx1_.data();
+    const uint8_t* row = frame.planes[0] + static_cast<size_t>(src_y) * frame.row_strides[0];
+
+    switch (frame.format) {
+    case SPOTITML_FORMAT_RGB:
+        resample_taps(columns, x0, x1, w0, w1, planes, [row](int x, float& r, float& g, float& b) {
+            const uint8_t* p = row + 3 * x;
+            r = p[0];
+            g = p[1];
+            b = p[2];
+        });
+        break;
+    case SPOTITML_FORMAT_BGRA:
+        resample_taps(columns, x0, x1, w0, w1, planes, [row](int x, float& r, float& g, float& b) {
+            const uint8_t* p = row + 4 * x;
+            r = p[2];
+            g = p[1];
+            b = p[0];
+        });
+        break;
+    case SPOTITML_FORMAT_NV21: {
+        const int chroma_stride = frame.planes[1] != nullptr ? frame.row_strides[1] : frame.row_strides[0];
+        const uint8_t* vu = nv21_vu_plane(frame) + static_cast<size_t>(src_y / 2) * chroma_stride;
+        resample_taps(columns, x0, x1, w0, w1, planes, [row, vu](int x, float& y, float& u, float& v) {
+            const uint8_t* c = vu + (x & ~1);
+            y = row[x];
+            u = c[1];
+            v = c[0];
+        });
+        break;
+    }
+    case SPOTITML_FORMAT_YUV420: {
+        const uint8_t* u = frame.planes[1] + static_cast<size_t>(src_y / 2) * frame.row_strides[1];
+        const uint8_t* v = frame.planes[2] + static_cast<size_t>(src_y / 2) * frame.row_strides[2];
+        const int u_step = frame.pixel_strides[1] > 0 ? frame.pixel_strides[1] : 1;
+        const int v_step = frame.pixel_strides[2] > 0 ? frame.pixel_strides[2] : 1;
+        resample_taps(columns, x0, x1, w0, w1, planes, [=](int x, float& y, float& cu, float& cv) {
+            const int cx = x >> 1;
+            y = row[x];
+            cu = u[cx * u_step];
+            cv = v[cx * v_step];
+        });
+        break;
+    }
+    }
+}
+
+float* Preprocessor::cached_row(const spotitml_frame& frame, int src_y) {
+    const size_t row_floats = 3 * x0_.size();
+    for (int slot = 0; slot < 2; ++slot) {
+        if (row_index_[slot] == src_y) {
+            return rows_.data() + slot * row_floats;
+        }
+    }
+    // Output rows walk the source top to bottom, so the older row is never needed again.
+    const int slot = row_index_[0] <= row_index_[1] ? 0 : 1;
+    float* planes = rows_.data() + slot * row_floats;
+    resample_row(frame, src_y, planes);
+    row_index_[slot] = src_y;
+    return planes;
+}
+
+Letterbox Preprocessor::letterbox_rgb(const uint8_t* rgb, int width, int height, int row_stride,
+                                      float* dst, int dst_width, int dst_height) {
+    spotitml_frame frame{};
+    frame.format = SPOTITML_FORMAT_RGB;
+    frame.width = width;
+    frame.height = height;
+    frame.planes[0] = rgb;
+    frame.row_strides[0] = row_stride;
+    return letterbox(frame, dst, dst_width, dst_height);
+}
+
+Letterbox Preprocessor::letterbox(const spotitml_frame& frame, float* dst, int dst_width, int dst_height) {
+    validate_frame(frame);
+    const int width = frame.width;
+    const int height = frame.height;
+
+    const Letterbox letterbox = compute_letterbox(width, height, dst_width, dst_height);
+    if (width != src_width_ || height != src_height_ || dst_width != dst_width_ || dst_height != dst_height_) {
+        prepare(letterbox, width, height, dst_width, dst_height);
+    }
+    row_index_[0] = row_index_[1] = -1;
+
+    const size_t plane_size = static_cast<size_t>(dst_width) * dst_height;
+    const int columns = letterbox.resized_width;
+    const int right_pad = dst_width - letterbox.pad_x - columns;
+    const bool yuv = is_yuv(frame);
+
+    for (int y = 0; y < dst_height; ++y) {
+        float* out[3] = {dst + y * dst_width, dst + plane_size + y * dst_width, dst + 2 * plane_size + y * dst_width};
+
+        const int ry = y - letterbox.pad_y;
+        if (ry < 0 || ry >= letterbox.resized_height) {
+            for (float* row : out) {
+                std::fill_n(row, dst_width, kPadValue);
+            }
+            continue;
+        }
+
+        int y0, y1;
+        float wy;
+        source_taps(ry, height, letterbox.resized_height, y0, y1, wy);
+        const float* top = cached_row(frame, y0);
+        const float* bottom = cached_row(frame, y1);
+
+        for (int c = 0; c < 3; ++c) {
+            std::fill_n(out[c], letterbox.pad_x, kPadValue);
+            blend_rows(top + c * columns, bottom + c * columns, wy, out[c] + letterbox.pad_x, columns);
+            std::fill_n(out[c] + letterbox.pad_x + columns, right_pad, kPadValue);
+        }
+        if (yuv) {
+            yuv_rows_to_rgb(out[0] + letterbox.pad_x, out[1] + letterbox.pad_x, out[2] + letterbox.pad_x, columns);
+        }
+    }
+
+    return letterbox;
+}
+
+} // namespace spotitml
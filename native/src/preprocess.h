@@ -0,0 +1,81 @@
+#pragma once
+
+#include "spotitml_native.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace spotitml {
+
+// Placement of the source image inside the square model input.
+// Model-space coordinates map back to the source image with
+// (x - pad_x) / scale and (y - pad_y) / scale.
+struct Letterbox {
+    float scale = 1.0f;
+    int pad_x = 0;
+    int pad_y = 0;
+    int resized_width = 0;
+    int resized_height = 0;
+};
+
+Letterbox compute_letterbox(int src_width, int src_height, int dst_width, int dst_height);
+
+// Number of planes a frame of this format uses and how many bytes plane i
+// spans (the last row is not assumed to be padded to the row stride).
+int frame_plane_count(const spotitml_frame& frame);
+size_t frame_plane_size(const spotitml_frame& frame, int plane);
+
+// Luma of source pixel (x, y): the Y plane for YUV formats, integer BT.601
+// weights for RGB and BGRA. For cheap whole-frame statistics on sparse taps.
+uint8_t frame_luma(const spotitml_frame& frame, int x, int y);
+
+// View of the width x height rectangle at (x, y) of frame, sharing its
+// planes. For YUV formats x and y must be even so chroma stays aligned.
+spotitml_frame crop_frame(const spotitml_frame& frame, int x, int y, int width, int height);
+
+// Maps a model-space box back onto the source image, clamped to its bounds.
+void unletterbox_box(const Letterbox& letterbox, int src_width, int src_height,
+                     float& x1, float& y1, float& x2, float& y2);
+
+// Letterbox resize + color conversion + normalization to [0, 1] + HWC->NCHW
+// transpose in a single pass over the source. Bilinear filtering is separable:
+// each source row is resampled horizontally once (deinterleaved into planes,
+// R/G/B or Y/U/V as stored), then every output row is a SIMD blend of two
+// such rows written straight into the tensor planes. YUV is converted to RGB
+// once per output pixel, after the vertical blend; the conversion is linear,
+// so this matches converting every tap. Only two rows of scratch are kept,
+// never a resized or color-converted image.
+class Preprocessor {
+public:
+    // Padding value used by Ultralytics letterboxing (114 / 255).
+    static constexpr float kPadValue = 114.0f / 255.0f;
+
+    Letterbox letterbox(const spotitml_frame& frame, float* dst, int dst_width, int dst_height);
+
+    Letterbox letterbox_rgb(const uint8_t* rgb, int width, int height, int row_stride,
+                            float* dst, int dst_width, int dst_height);
+
+private:
+    void prepare(const Letterbox& letterbox, int src_width, int src_height, int dst_width, int dst_height);
+    void resample_row(const spotitml_frame& frame, int src_y, float* planes);
+    float* cached_row(const spotitml_frame& frame, int src_y);
+
+    // Horizontal taps (source pixel indices) for every resized column, rebuilt
+    // when the geometry changes.
+    std::vector<int32_t> x0_;
+    std::vector<int32_t> x1_;
+    std::vector<float> wx0_;
+    std::vector<float> wx1_;
+
+    // Two horizontally resampled source rows (3 planes each) and their source indices.
+    std::vector<float> rows_;
+    int row_index_[2] = {-1, -1};
+
+    int src_width_ = 0;
+    int src_height_ = 0;
+    int dst_width_ = 0;
+    int dst_height_ = 0;
+};
+
+} // namespace spotitml
@@ -0,0 +1,52 @@
+#include "prewarm.h"
+#include "engine.h"
+#include "instrumentation.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace spotitml {
+
+Prewarm::Prewarm(EngineSpec spec, int warmup_runs, spotitml_ready_callback callback, void* user_data)
+    : spec_(std::move(spec)),
+      callback_(callback),
+      user_data_(user_data) {
+    thread_ = std::thread(&Prewarm::run, this, warmup_runs);
+}
+
+Prewarm::~Prewarm() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void Prewarm::run(int warmup_runs) {
+    SPOTITML_THREAD_NAME("spotitml.prewarm");
+    int32_t state = kReady;
+    try {
+        engine_ = spec_.create();
+        engine_->warm_up(warmup_runs);
+    } catch (const std::exception& e) {
+        engine_.reset();
+        error_ = e.what();
+        state = kFailed;
+    }
+    state_.store(state, std::memory_order_release);
+
+    if (callback_ != nullptr) {
+        callback_(state, user_data_);
+    }
+}
+
+Engine* Prewarm::take(std::string* error) {
+    // From inside the ready callback the result is already in place.
+    if (thread_.joinable() && thread_.get_id() != std::this_thread::get_id()) {
+        thread_.join();
+    }
+    if (engine_ == nullptr && error != nullptr) {
+        *error = state() == kFailed ? error_ : "engine already taken";
+    }
+    return engine_.release();
+}
+
+} // namespace spotitml
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "spotitml_native.h"
+#include "model_variants.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace spotitml {
+
+class Engine;
+
+// Creates an engine and warms it up on a background thread.
+//
+// Session creation, the first-run kernel selection and arena growth all
+// happen here, off the caller's thread, so the first real detection runs at
+// steady-state latency. The callback (if any) fires on the background thread
+// once the engine is ready or has failed.
+class Prewarm {
+public:
+    enum State : int32_t { kPending = 0, kReady = 1, kFailed = -1 };
+
+    Prewarm(EngineSpec spec, int warmup_runs, spotitml_ready_callback callback, void* user_data);
+    // Joins the thread and destroys the engine unless it was taken.
+    ~Prewarm();
+
+    Prewarm(const Prewarm&) = delete;
+    Prewarm& operator=(const Prewarm&) = delete;
+
+    int32_t state() const { return state_.load(std::memory_order_acquire); }
+
+    // Waits for the thread and hands over the engine; nullptr (with error
+    // filled in) if creation failed or the engine was already taken.
+    Engine* take(std::string* error);
+
+private:
+    void run(int warmup_runs);
+
+    EngineSpec spec_;
+    spotitml_ready_callback callback_;
+    void* user_data_;
+
+    std::unique_ptr<Engine> engine_;
+    std::string error_;
+    std::atomic<int32_t> state_{kPending};
+    std::thread thread_;
+};
+
+} // namespace spotitml
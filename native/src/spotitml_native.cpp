@@ -1,38 +1,683 @@
 #include "spotitml_native.h"
+#include "deck.h"
+#include "engine.h"
+#include "frame_pool.h"
+#include "instrumentation.h"
+#include "log.h"
+#include "model_variants.h"
+#include "prewarm.h"
+#include "symbol_classifier.h"
+#include "trace.h"
+#include "worker.h"
+
+#include <algorithm>
+#include <cstdio>
 #include <string>
-#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+thread_local std::string last_error;
+
+spotitml::Engine* to_engine(spotitml_engine* engine) {
+    return reinterpret_cast<spotitml::Engine*>(engine);
+}
+
+const spotitml::Engine* to_engine(const spotitml_engine* engine) {
+    return reinterpret_cast<const spotitml::Engine*>(engine);
+}
+
+spotitml::SymbolClassifier* to_classifier(spotitml_classifier* classifier) {
+    return reinterpret_cast<spotitml::SymbolClassifier*>(classifier);
+}
+
+const spotitml::SymbolClassifier* to_classifier(const spotitml_classifier* classifier) {
+    return reinterpret_cast<const spotitml::SymbolClassifier*>(classifier);
+}
+
+spotitml::FramePool* to_pool(spotitml_frame_pool* pool) {
+    return reinterpret_cast<spotitml::FramePool*>(pool);
+}
+
+const spotitml::FramePool* to_pool(const spotitml_frame_pool* pool) {
+    return reinterpret_cast<const spotitml::FramePool*>(pool);
+}
+
+// Copies the caller's variant list and options; throws on invalid input.
+spotitml::EngineSpec make_spec(const spotitml_model_variant* variants, int32_t variant_count, int32_t policy,
+                               int32_t bench_runs, const spotitml_engine_options* options) {
+    if (variants == nullptr || variant_count <= 0) {
+        throw std::invalid_argument("no variants given");
+    }
+    std::vector<spotitml::ModelVariant> copies;
+    for (int32_t i = 0; i < variant_count; ++i) {
+        if (variants[i].model_path == nullptr) {
+            throw std::invalid_argument("variant model_path is NULL");
+        }
+        copies.push_back({variants[i].model_path, variants[i].precision});
+    }
+
+    spotitml_engine_options resolved;
+    engine_default_options(&resolved);
+    if (options != nullptr) {
+        resolved = *options;
+    }
+    return spotitml::EngineSpec(std::move(copies), policy, bench_runs, resolved);
+}
+
+spotitml::Worker* to_worker(spotitml_worker* worker) {
+    return reinterpret_cast<spotitml::Worker*>(worker);
+}
+
+const spotitml::Worker* to_worker(const spotitml_worker* worker) {
+    return reinterpret_cast<const spotitml::Worker*>(worker);
+}
 
-#include "onnxruntime_cxx_api.h"
+} // namespace
 
 extern "C" {
 
+void engine_default_options(spotitml_engine_options* options) {
+    if (options == nullptr) {
+        return;
+    }
+    options->intra_op_threads = 0;
+    options->inter_op_threads = 0;
+    options->score_threshold = 0.25f;
+    options->iou_threshold = 0.45f;
+    options->graph_optimization = SPOTITML_OPTIMIZE_ALL;
+    options->execution_mode = SPOTITML_EXECUTION_SEQUENTIAL;
+    options->enable_cpu_mem_arena = 1;
+    options->enable_mem_pattern = 1;
+    options->log_severity = 2;
+    options->provider_count = 1;
+    options->providers[0] = SPOTITML_PROVIDER_CPU;
+    for (int i = 1; i < SPOTITML_MAX_PROVIDERS; ++i) {
+        options->providers[i] = SPOTITML_PROVIDER_CPU;
+    }
+    options->cache_dir = nullptr;
+}
+
+spotitml_engine* engine_create(const char* model_path, const spotitml_engine_options* options) {
+    if (model_path == nullptr) {
+        last_error = "engine_create: model_path is NULL";
+        return nullptr;
+    }
+
+    spotitml_engine_options resolved;
+    engine_default_options(&resolved);
+    if (options != nullptr) {
+        resolved = *options;
+    }
+
+    try {
+        auto* engine = new spotitml::Engine(model_path, resolved);
+        SPOTITML_LOG(spotitml::log::kInfo, "Engine created for %s in %.1f ms", model_path,
+                     engine->load_stats().load_ms);
+        return reinterpret_cast<spotitml_engine*>(engine);
+    } catch (const std::exception& e) {
+        last_error = "engine_create: " + std::string(e.what());
+        return nullptr;
+    }
+}
+
+int32_t engine_active_providers(const spotitml_engine* engine, int32_t* providers, int32_t max_providers) {
+    if (engine == nullptr || providers == nullptr || max_providers < 0) {
+        last_error = "engine_active_providers: invalid arguments";
+        return -1;
+    }
+    const std::vector<int32_t>& active = to_engine(engine)->active_providers();
+    const int32_t count = std::min(static_cast<int32_t>(active.size()), max_providers);
+    std::copy_n(active.data(), count, providers);
+    return count;
+}
+
+spotitml_prewarm* engine_prewarm(const char* model_path, const spotitml_engine_options* options,
+                                 int32_t warmup_runs, spotitml_ready_callback callback, void* user_data) {
+    if (model_path == nullptr) {
+        last_error = "engine_prewarm: model_path is NULL";
+        return nullptr;
+    }
+
+    spotitml_engine_options resolved;
+    engine_default_options(&resolved);
+    if (options != nullptr) {
+        resolved = *options;
+    }
+
+    try {
+        spotitml::EngineSpec spec({{model_path, SPOTITML_PRECISION_FP32}}, SPOTITML_VARIANT_MOST_ACCURATE, 0, resolved);
+        return reinterpret_cast<spotitml_prewarm*>(
+            new spotitml::Prewarm(std::move(spec), std::max(warmup_runs, 0), callback, user_data));
+    } catch (const std::exception& e) {
+        last_error = "engine_prewarm: " + std::string(e.what());
+        return nullptr;
+    }
+}
+
+spotitml_prewarm* engine_prewarm_variant(const spotitml_model_variant* variants, int32_t variant_count,
+                                         int32_t policy, int32_t bench_runs,
+                                         const spotitml_engine_options* options, int32_t warmup_runs,
+                                         spotitml_ready_callback callback, void* user_data) {
+    try {
+        return reinterpret_cast<spotitml_prewarm*>(
+            new spotitml::Prewarm(make_spec(variants, variant_count, policy, bench_runs, options),
+                                  std::max(warmup_runs, 0), callback, user_data));
+    } catch (const std::exception& e) {
+        last_error = "engine_prewarm_variant: " + std::string(e.what());
+        return nullptr;
+    }
+}
+
+int32_t prewarm_state(const spotitml_prewarm* prewarm) {
+    return prewarm != nullptr ? reinterpret_cast<const spotitml::Prewarm*>(prewarm)->state()
+                              : SPOTITML_PREWARM_FAILED;
+}
+
+spotitml_engine* prewarm_take_engine(spotitml_prewarm* prewarm) {
+    if (prewarm == nullptr) {
+        last_error = "prewarm_take_engine: prewarm is NULL";
+        return nullptr;
+    }
+    std::string error;
+    spotitml::Engine* engine = reinterpret_cast<spotitml::Prewarm*>(prewarm)->take(&error);
+    if (engine == nullptr) {
+        last_error = "prewarm_take_engine: " + error;
+    }
+    return reinterpret_cast<spotitml_engine*>(engine);
+}
+
+void prewarm_destroy(spotitml_prewarm* prewarm) {
+    delete reinterpret_cast<spotitml::Prewarm*>(prewarm);
+}
+
+spotitml_engine* engine_create_variant(const spotitml_model_variant* variants, int32_t variant_count,
+                                       int32_t policy, int32_t bench_runs,
+                                       const spotitml_engine_options* options) {
+    try {
+        std::unique_ptr<spotitml::Engine> engine =
+            make_spec(variants, variant_count, policy, bench_runs, options).create();
+        return reinterpret_cast<spotitml_engine*>(engine.release());
+    } catch (const std::exception& e) {
+        last_error = "engine_create_variant: " + std::string(e.what());
+        return nullptr;
+    }
+}
+
+int32_t engine_variant_reports(const spotitml_engine* engine, spotitml_variant_report* reports,
+                               int32_t max_reports) {
+    if (engine == nullptr || reports == nullptr || max_reports < 0) {
+        last_error = "engine_variant_reports: invalid arguments";
+        return -1;
+    }
+    const std::vector<spotitml_variant_report>& all = to_engine(engine)->variant_reports();
+    const int32_t count = std::min(static_cast<int32_t>(all.size()), max_reports);
+    std::copy_n(all.data(), count, reports);
+    return count;
+}
+
+int32_t engine_load_stats(const spotitml_engine* engine, spotitml_load_stats* stats) {
+    if (engine == nullptr || stats == nullptr) {
+        last_error = "engine_load_stats: invalid arguments";
+        return -1;
+    }
+    *stats = to_engine(engine)->load_stats();
+    return 0;
+}
+
+int32_t engine_run(spotitml_engine* engine) {
+    if (engine == nullptr) {
+        last_error = "engine_run: engine is NULL";
+        return -1;
+    }
+    try {
+        to_engine(engine)->run();
+        return 0;
+    } catch (const std::exception& e) {
+        last_error = "engine_run: " + std::string(e.what());
+        return -1;
+    }
+}
 
-const char* detect_objects(const uint8_t* image_data, int width, int height) {
-    static std::string result_msg;
-    
-    std::cout << "DEBUG C++: detect_objects called with " << width << "x" << height << std::endl;
-    
-    try {
-        std::cout << "DEBUG C++: Attempting to initialize ONNX Runtime..." << std::endl;
-        
-        // Initialize ONNX Runtime environment with verbose logging for development
-        Ort::Env env(ORT_LOGGING_LEVEL_VERBOSE, "YOLOv8");
-        
-        std::cout << "DEBUG C++: ONNX Runtime environment created successfully!" << std::endl;
-        
-        // Phase 1a: Just test that ONNX Runtime loads successfully
-        // Don't actually load the model yet - just return success status
-        
-        result_msg = "ONNX Runtime loaded successfully. Image: " + 
-                    std::to_string(width) + "x" + std::to_string(height);
-        
-        std::cout << "DEBUG C++: Returning: " << result_msg << std::endl;
-        return result_msg.c_str();
-        
-    } catch (const std::exception& e) {
-        std::cout << "DEBUG C++: ONNX Runtime exception: " << e.what() << std::endl;
-        result_msg = "ONNX Runtime error: " + std::string(e.what());
-        return result_msg.c_str();
+float* engine_input_buffer(spotitml_engine* engine) {
+    return engine != nullptr ? to_engine(engine)->input_data() : nullptr;
+}
+
+int64_t engine_input_size(const spotitml_engine* engine) {
+    return engine != nullptr ? static_cast<int64_t>(to_engine(engine)->input_size()) : 0;
+}
+
+const float* engine_output_buffer(const spotitml_engine* engine) {
+    return engine != nullptr ? to_engine(engine)->output_data() : nullptr;
+}
+
+int64_t engine_output_size(const spotitml_engine* engine) {
+    return engine != nullptr ? static_cast<int64_t>(to_engine(engine)->output_size()) : 0;
+}
+
+int32_t engine_detect(spotitml_engine* engine, const uint8_t* image_data, int32_t width, int32_t height,
+                      spotitml_detection* detections, int32_t max_detections) {
+    if (engine == nullptr || detections == nullptr || max_detections < 0) {
+        last_error = "engine_detect: invalid arguments";
+        return -1;
+    }
+    try {
+        return to_engine(engine)->detect_rgb(image_data, width, height, width * 3, detections, max_detections);
+    } catch (const std::exception& e) {
+        last_error = "engine_detect: " + std::string(e.what());
+        return -1;
+    }
+}
+
+int32_t engine_detect_frame(spotitml_engine* engine, const spotitml_frame* frame,
+                            spotitml_detection* detections, int32_t max_detections) {
+    if (engine == nullptr || frame == nullptr || detections == nullptr || max_detections < 0) {
+        last_error = "engine_detect_frame: invalid arguments";
+        return -1;
+    }
+    try {
+        return to_engine(engine)->detect(*frame, detections, max_detections);
+    } catch (const std::exception& e) {
+        last_error = "engine_detect_frame: " + std::string(e.what());
+        return -1;
+    }
+}
+
+int32_t engine_set_class_filter(spotitml_engine* engine, const int32_t* class_ids, int32_t count) {
+    if (engine == nullptr || count < 0 || (class_ids == nullptr && count > 0)) {
+        last_error = "engine_set_class_filter: invalid arguments";
+        return -1;
+    }
+    try {
+        to_engine(engine)->set_class_filter(class_ids, count);
+        return 0;
+    } catch (const std::exception& e) {
+        last_error = "engine_set_class_filter: " + std::string(e.what());
+        return -1;
+    }
+}
+
+int32_t engine_detect_batch(spotitml_engine* engine, const spotitml_frame* frames, int32_t frame_count,
+                            spotitml_detection* detections, int32_t max_detections_per_frame, int32_t* counts) {
+    if (engine == nullptr || frames == nullptr || frame_count < 0 || detections == nullptr ||
+        max_detections_per_frame < 0 || counts == nullptr) {
+        last_error = "engine_detect_batch: invalid arguments";
+        return -1;
+    }
+    try {
+        to_engine(engine)->detect_batch(frames, frame_count, detections, max_detections_per_frame, counts);
+        return frame_count;
+    } catch (const std::exception& e) {
+        last_error = "engine_detect_batch: " + std::string(e.what());
+        return -1;
+    }
+}
+
+int32_t engine_supports_batch(const spotitml_engine* engine) {
+    return engine != nullptr && to_engine(engine)->dynamic_batch() ? 1 : 0;
+}
+
+int32_t engine_detect_cards(spotitml_engine* engine, const spotitml_frame* frame, spotitml_card_result* cards,
+                            int32_t max_cards) {
+    if (engine == nullptr || frame == nullptr || cards == nullptr || max_cards < 0) {
+        last_error = "engine_detect_cards: invalid arguments";
+        return -1;
+    }
+    try {
+        return to_engine(engine)->detect_cards(*frame, cards, max_cards);
+    } catch (const std::exception& e) {
+        last_error = "engine_detect_cards: " + std::string(e.what());
+        return -1;
+    }
+}
+
+int32_t find_match(const spotitml_detection* detections, int32_t count, const float* card_a, const float* card_b,
+                   spotitml_match* match) {
+    if ((detections == nullptr && count > 0) || count < 0 || card_a == nullptr || card_b == nullptr ||
+        match == nullptr) {
+        last_error = "find_match: invalid arguments";
+        return -1;
+    }
+    spotitml::SymbolSet symbols[2];
+    spotitml::split_by_card(detections, count, card_a, card_b, symbols);
+    return spotitml::solve_match(symbols[0], symbols[1], match);
+}
+
+int32_t engine_detect_match(spotitml_engine* engine, const spotitml_frame* frame, spotitml_card_result* cards,
+                            spotitml_match* match) {
+    if (engine == nullptr || frame == nullptr || match == nullptr) {
+        last_error = "engine_detect_match: invalid arguments";
+        return -1;
+    }
+    try {
+        return to_engine(engine)->detect_match(*frame, -1, cards, match);
+    } catch (const std::exception& e) {
+        last_error = "engine_detect_match: " + std::string(e.what());
+        return -1;
+    }
+}
+
+uint64_t deck_card_symbols(int32_t card) {
+    return card >= 0 && card < spotitml::deck::kCards ? spotitml::deck::kCardMasks[card] : 0;
+}
+
+int32_t deck_snap(uint64_t symbols, int32_t max_distance, int32_t* distance) {
+    int nearest = 0;
+    const int card = spotitml::deck::snap(symbols, max_distance, &nearest);
+    if (distance != nullptr) {
+        *distance = nearest;
+    }
+    return card;
+}
+
+int32_t deck_shared_symbol(int32_t card_a, int32_t card_b) {
+    if (card_a < 0 || card_a >= spotitml::deck::kCards || card_b < 0 || card_b >= spotitml::deck::kCards) {
+        return -1;
+    }
+    return spotitml::deck::shared_symbol(card_a, card_b);
+}
+
+int32_t find_deck_match(const spotitml_detection* detections, int32_t count, const float* card_a,
+                        const float* card_b, int32_t max_distance, spotitml_match* match) {
+    if ((detections == nullptr && count > 0) || count < 0 || card_a == nullptr || card_b == nullptr ||
+        max_distance < 0 || match == nullptr) {
+        last_error = "find_deck_match: invalid arguments";
+        return -1;
+    }
+    spotitml::SymbolSet symbols[2];
+    spotitml::split_by_card(detections, count, card_a, card_b, symbols);
+    return spotitml::solve_deck_match(symbols[0], symbols[1], max_distance, match);
+}
+
+int32_t engine_detect_deck_match(spotitml_engine* engine, const spotitml_frame* frame, int32_t max_distance,
+                                 spotitml_card_result* cards, spotitml_match* match) {
+    if (engine == nullptr || frame == nullptr || max_distance < 0 || match == nullptr) {
+        last_error = "engine_detect_deck_match: invalid arguments";
+        return -1;
+    }
+    try {
+        return to_engine(engine)->detect_match(*frame, max_distance, cards, match);
+    } catch (const std::exception& e) {
+        last_error = "engine_detect_deck_match: " + std::string(e.what());
+        return -1;
+    }
+}
+
+void engine_destroy(spotitml_engine* engine) {
+    delete to_engine(engine);
+}
+
+spotitml_classifier* classifier_create(spotitml_engine* proposer, const char* embedding_model_path,
+                                       const char* table_path, const spotitml_engine_options* options) {
+    if (proposer == nullptr || embedding_model_path == nullptr || table_path == nullptr) {
+        last_error = "classifier_create: invalid arguments";
+        return nullptr;
+    }
+    spotitml_engine_options resolved;
+    engine_default_options(&resolved);
+    if (options != nullptr) {
+        resolved = *options;
+    }
+    try {
+        return reinterpret_cast<spotitml_classifier*>(
+            new spotitml::SymbolClassifier(*to_engine(proposer), embedding_model_path, table_path, resolved));
+    } catch (const std::exception& e) {
+        last_error = "classifier_create: " + std::string(e.what());
+        return nullptr;
+    }
+}
+
+int32_t classifier_load_table(spotitml_classifier* classifier, const char* table_path) {
+    if (classifier == nullptr || table_path == nullptr) {
+        last_error = "classifier_load_table: invalid arguments";
+        return -1;
+    }
+    try {
+        to_classifier(classifier)->load_table(table_path);
+        return 0;
+    } catch (const std::exception& e) {
+        last_error = "classifier_load_table: " + std::string(e.what());
+        return -1;
+    }
+}
+
+int32_t classifier_table_size(const spotitml_classifier* classifier) {
+    return classifier != nullptr ? to_classifier(classifier)->index().rows() : 0;
+}
+
+int32_t classifier_detect_frame(spotitml_classifier* classifier, const spotitml_frame* frame, float min_similarity,
+                                spotitml_detection* detections, int32_t max_detections) {
+    if (classifier == nullptr || frame == nullptr || detections == nullptr || max_detections < 0) {
+        last_error = "classifier_detect_frame: invalid arguments";
+        return -1;
+    }
+    try {
+        return to_classifier(classifier)->detect(*frame, min_similarity, detections, max_detections);
+    } catch (const std::exception& e) {
+        last_error = "classifier_detect_frame: " + std::string(e.what());
+        return -1;
+    }
+}
+
+void classifier_destroy(spotitml_classifier* classifier) {
+    delete to_classifier(classifier);
+}
+
+spotitml_frame_pool* frame_pool_create(int32_t buffer_count, int64_t buffer_size) {
+    if (buffer_count <= 0 || buffer_count > spotitml::FramePool::kMaxBuffers || buffer_size <= 0) {
+        last_error = "frame_pool_create: invalid arguments";
+        return nullptr;
+    }
+    try {
+        return reinterpret_cast<spotitml_frame_pool*>(
+            new spotitml::FramePool(buffer_count, static_cast<size_t>(buffer_size)));
+    } catch (const std::exception& e) {
+        last_error = "frame_pool_create: " + std::string(e.what());
+        return nullptr;
+    }
+}
+
+int32_t frame_pool_acquire(spotitml_frame_pool* pool) {
+    return pool != nullptr ? to_pool(pool)->acquire() : -1;
+}
+
+void frame_pool_release(spotitml_frame_pool* pool, int32_t index) {
+    if (pool != nullptr) {
+        to_pool(pool)->release(index);
+    }
+}
+
+uint8_t* frame_pool_buffer(spotitml_frame_pool* pool, int32_t index) {
+    if (pool == nullptr || index < 0 || index >= to_pool(pool)->buffer_count()) {
+        return nullptr;
+    }
+    return to_pool(pool)->buffer(index);
+}
+
+int64_t frame_pool_buffer_size(const spotitml_frame_pool* pool) {
+    return pool != nullptr ? static_cast<int64_t>(to_pool(pool)->buffer_size()) : 0;
+}
+
+void frame_pool_destroy(spotitml_frame_pool* pool) {
+    delete to_pool(pool);
+}
+
+spotitml_worker* worker_create(spotitml_engine* engine, int32_t pipeline_depth, spotitml_result_callback callback,
+                               void* user_data) {
+    if (engine == nullptr) {
+        last_error = "worker_create: engine is NULL";
+        return nullptr;
+    }
+    try {
+        return reinterpret_cast<spotitml_worker*>(
+            new spotitml::Worker(*to_engine(engine), pipeline_depth, nullptr, callback, user_data));
+    } catch (const std::exception& e) {
+        last_error = "worker_create: " + std::string(e.what());
+        return nullptr;
+    }
+}
+
+void worker_default_tracking_options(spotitml_tracking_options* options) {
+    if (options == nullptr) {
+        return;
+    }
+    options->keyframe_interval = 5;
+    options->motion_threshold = 6.0f;
+    options->iou_threshold = 0.3f;
+    options->max_missed = 2;
+}
+
+spotitml_worker* worker_create_tracked(spotitml_engine* engine, int32_t pipeline_depth,
+                                       const spotitml_tracking_options* tracking,
+                                       spotitml_result_callback callback, void* user_data) {
+    if (engine == nullptr) {
+        last_error = "worker_create_tracked: engine is NULL";
+        return nullptr;
+    }
+    spotitml_tracking_options options;
+    worker_default_tracking_options(&options);
+    if (tracking != nullptr) {
+        options = *tracking;
+    }
+    if (options.keyframe_interval < 1 || options.max_missed < 0) {
+        last_error = "worker_create_tracked: invalid tracking options";
+        return nullptr;
+    }
+    try {
+        return reinterpret_cast<spotitml_worker*>(
+            new spotitml::Worker(*to_engine(engine), pipeline_depth, &options, callback, user_data));
+    } catch (const std::exception& e) {
+        last_error = "worker_create_tracked: " + std::string(e.what());
+        return nullptr;
+    }
+}
+
+int64_t worker_submit(spotitml_worker* worker, const spotitml_frame* frame) {
+    if (worker == nullptr || frame == nullptr) {
+        last_error = "worker_submit: invalid arguments";
+        return -1;
+    }
+    try {
+        return to_worker(worker)->submit(*frame);
+    } catch (const std::exception& e) {
+        last_error = "worker_submit: " + std::string(e.what());
+        return -1;
+    }
+}
+
+int64_t worker_submit_pooled(spotitml_worker* worker, const spotitml_frame* frame,
+                             spotitml_frame_pool* pool, int32_t index) {
+    if (worker == nullptr || frame == nullptr || pool == nullptr) {
+        last_error = "worker_submit_pooled: invalid arguments";
+        return -1;
+    }
+    try {
+        return to_worker(worker)->submit_pooled(*frame, *to_pool(pool), index);
+    } catch (const std::exception& e) {
+        last_error = "worker_submit_pooled: " + std::string(e.what());
+        return -1;
+    }
+}
+
+int32_t worker_latest_results(spotitml_worker* worker, spotitml_detection* detections, int32_t max_detections,
+                              int64_t* frame_id) {
+    if (worker == nullptr || detections == nullptr || max_detections < 0) {
+        last_error = "worker_latest_results: invalid arguments";
+        return -1;
+    }
+    std::string error;
+    const int count = to_worker(worker)->latest_results(detections, max_detections, frame_id, &error);
+    if (count < 0) {
+        last_error = "worker_latest_results: " + error;
+    }
+    return count;
+}
+
+int32_t worker_latest_tracks(spotitml_worker* worker, spotitml_track* tracks, int32_t max_tracks,
+                             int64_t* frame_id) {
+    if (worker == nullptr || tracks == nullptr || max_tracks < 0) {
+        last_error = "worker_latest_tracks: invalid arguments";
+        return -1;
+    }
+    std::string error;
+    const int count = to_worker(worker)->latest_tracks(tracks, max_tracks, frame_id, &error);
+    if (count < 0) {
+        last_error = "worker_latest_tracks: " + error;
+    }
+    return count;
+}
+
+int64_t worker_dropped_frames(const spotitml_worker* worker) {
+    return worker != nullptr ? to_worker(worker)->dropped_frames() : 0;
+}
+
+void worker_destroy(spotitml_worker* worker) {
+    delete to_worker(worker);
+}
+
+int32_t stats_snapshot(spotitml_stats* stats) {
+    if (stats == nullptr) {
+        last_error = "stats_snapshot: stats is NULL";
+        return -1;
+    }
+    spotitml::instrumentation::snapshot(stats);
+    return 0;
+}
+
+void stats_reset(void) {
+    spotitml::instrumentation::reset();
+}
+
+int32_t trace_start(int32_t duration_ms) {
+    if (!spotitml::instrumentation::kEnabled) {
+        last_error = "trace_start: built without SPOTITML_INSTRUMENTATION";
+        return -1;
+    }
+    spotitml::trace::start(duration_ms);
+    return 0;
+}
+
+void trace_stop(void) {
+    spotitml::trace::stop();
+}
+
+int64_t trace_write(const char* path) {
+    if (path == nullptr) {
+        last_error = "trace_write: path is NULL";
+        return -1;
+    }
+    const int64_t count = spotitml::trace::write(path);
+    if (count < 0) {
+        last_error = "trace_write: cannot write " + std::string(path);
+    }
+    return count;
+}
+
+void log_set_level(int32_t level) {
+    spotitml::log::set_level(level);
+}
+
+const char* engine_last_error(void) {
+    return last_error.c_str();
+}
+
+const char* detect_objects(spotitml_engine* engine, const uint8_t* image_data, int width, int height) {
+    // Results live in the engine's frame arena; error text in the calling
+    // thread's last_error, so concurrent callers never share a buffer.
+    if (engine == nullptr) {
+        last_error = "Engine not initialized. Image: " + std::to_string(width) + "x" + std::to_string(height);
+        return last_error.c_str();
+    }
+
+    try {
+        return to_engine(engine)->detect_json(image_data, width, height);
+    } catch (const std::exception& e) {
+        SPOTITML_LOG(spotitml::log::kError, "detect_objects: %s", e.what());
+        last_error = "ONNX Runtime error: " + std::string(e.what());
+        return last_error.c_str();
     }
 }
 
@@ -0,0 +1,131 @@
+#include "symbol_classifier.h"
+#include "engine.h"
+#include "instrumentation.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace spotitml {
+
+namespace {
+
+size_t element_count(const std::vector<int64_t>& shape, size_t first) {
+    size_t count = 1;
+    for (size_t i = first; i < shape.size(); ++i) {
+        count *= static_cast<size_t>(shape[i]);
+    }
+    return count;
+}
+
+} // namespace
+
+SymbolClassifier::SymbolClassifier(Engine& proposer, const char* model_path, const char* table_path,
+                                   const spotitml_engine_options& options)
+    : proposer_(proposer),
+      env_(to_ort_logging(options.log_severity), "embedding"),
+      memory_info_(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)),
+      run_options_(nullptr),
+      index_(table_path),
+      proposals_(kMaxCrops) {
+    {
+        // ONNX models are parsed into the session, so the mapping can go.
+        const MappedFile model(model_path);
+        session_ = Ort::Session(env_, model.data(), model.size(), make_session_options(options, active_providers_));
+    }
+    if (session_.GetInputCount() != 1 || session_.GetOutputCount() != 1) {
+        throw std::runtime_error("Expected an embedding model with exactly one input and one output");
+    }
+    Ort::AllocatorWithDefaultOptions allocator;
+    input_name_ = session_.GetInputNameAllocated(0, allocator).get();
+    output_name_ = session_.GetOutputNameAllocated(0, allocator).get();
+
+    const std::vector<int64_t> input_shape = session_.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+    if (input_shape.size() != 4 || input_shape[1] != 3 || input_shape[2] <= 0 || input_shape[2] != input_shape[3]) {
+        throw std::runtime_error("Expected an [N, 3, S, S] embedding input with a fixed S");
+    }
+    dynamic_batch_ = input_shape[0] <= 0;
+    input_size_ = static_cast<int>(input_shape[2]);
+
+    const std::vector<int64_t> output_shape = session_.GetOutputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+    if (output_shape.size() < 2 ||
+        std::any_of(output_shape.begin() + 1, output_shape.end(), [](int64_t dim) { return dim <= 0; })) {
+        throw std::runtime_error("Expected an [N, D] embedding output with a fixed D");
+    }
+    embedding_size_ = static_cast<int>(element_count(output_shape, 1));
+    if (embedding_size_ != index_.dim()) {
+        throw std::runtime_error("Embedding table dim does not match the embedding model");
+    }
+
+    input_.assign(static_cast<size_t>(kMaxCrops) * 3 * input_size_ * input_size_, 0.0f);
+    output_.assign(static_cast<size_t>(kMaxCrops) * embedding_size_, 0.0f);
+}
+
+void SymbolClassifier::load_table(const char* table_path) {
+    EmbeddingIndex index(table_path);
+    if (index.dim() != embedding_size_) {
+        throw std::runtime_error("Embedding table dim does not match the embedding model");
+    }
+    index_ = std::move(index);
+}
+
+void SymbolClassifier::embed(int count) {
+    const size_t crop_elements = static_cast<size_t>(3) * input_size_ * input_size_;
+    const char* input_names[] = {input_name_.c_str()};
+    const char* output_names[] = {output_name_.c_str()};
+    // Fixed batch of 1: one run per crop over the same buffers.
+    const int batch = dynamic_batch_ ? count : 1;
+    for (int first = 0; first < count; first += batch) {
+        const int64_t input_shape[] = {batch, 3, input_size_, input_size_};
+        const int64_t output_shape[] = {batch, embedding_size_};
+        Ort::Value input = Ort::Value::CreateTensor<float>(memory_info_, input_.data() + first * crop_elements,
+                                                           batch * crop_elements, input_shape, 4);
+        Ort::Value output = Ort::Value::CreateTensor<float>(
+            memory_info_, output_.data() + static_cast<size_t>(first) * embedding_size_,
+            static_cast<size_t>(batch) * embedding_size_, output_shape, 2);
+        SPOTITML_TIME_STAGE(instrumentation::kInference);
+        session_.Run(run_options_, input_names, &input, 1, output_names, &output, 1);
+    }
+}
+
+int SymbolClassifier::detect(const spotitml_frame& frame, float min_similarity, spotitml_detection* detections,
+                             int max_detections) {
+    const int proposed = proposer_.detect(frame, proposals_.data(), kMaxCrops);
+
+    const size_t crop_elements = static_cast<size_t>(3) * input_size_ * input_size_;
+    for (int i = 0; i < proposed; ++i) {
+        const spotitml_detection& box = proposals_[i];
+        const float margin_x = (box.x2 - box.x1) * kCropMargin;
+        const float margin_y = (box.y2 - box.y1) * kCropMargin;
+        // Even origin keeps YUV chroma aligned; at least 2 x 2 pixels.
+        const int x0 = std::clamp(static_cast<int>(std::floor(box.x1 - margin_x)), 0, frame.width - 2) & ~1;
+        const int y0 = std::clamp(static_cast<int>(std::floor(box.y1 - margin_y)), 0, frame.height - 2) & ~1;
+        const int x1 = std::clamp(static_cast<int>(std::ceil(box.x2 + margin_x)), x0 + 2, frame.width);
+        const int y1 = std::clamp(static_cast<int>(std::ceil(box.y2 + margin_y)), y0 + 2, frame.height);
+        SPOTITML_TIME_STAGE(instrumentation::kPreprocess);
+        preprocessor_.letterbox(crop_frame(frame, x0, y0, x1 - x0, y1 - y0), input_.data() + i * crop_elements,
+                                input_size_, input_size_);
+    }
+    if (proposed > 0) {
+        embed(proposed);
+    }
+
+    int count = 0;
+    for (int i = 0; i < proposed && count < max_detections; ++i) {
+        float similarity = 0.0f;
+        const int class_id = index_.nearest(output_.data() + static_cast<size_t>(i) * embedding_size_, &similarity);
+        if (class_id < 0 || similarity < min_similarity) {
+            continue;
+        }
+        spotitml_detection& d = detections[count++];
+        d = proposals_[i];
+        d.class_id = class_id;
+        d.score = proposals_[i].score * similarity;
+    }
+    std::sort(detections, detections + count,
+              [](const spotitml_detection& a, const spotitml_detection& b) { return a.score > b.score; });
+    return count;
+}
+
+} // namespace spotitml
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "spotitml_native.h"
+#include "embedding_index.h"
+#include "preprocess.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "onnxruntime_cxx_api.h"
+
+namespace spotitml {
+
+class Engine;
+
+// Two-stage symbol detection that does not need a detector trained on the
+// deck: a class-agnostic proposer (any YOLOv8 engine, ideally exported with
+// a single "symbol" class) finds the boxes, a small embedding model maps each
+// box's crop to a vector, and the vector's nearest row in an EmbeddingIndex
+// names the symbol. Supporting a new deck only takes a new table.
+//
+// The crops of one frame are letterboxed back to back into one
+// [N, 3, S, S] tensor and embedded in a single session run when the
+// embedding model's batch axis is dynamic (one run per crop otherwise).
+// All buffers are sized at construction; detect() does not allocate.
+class SymbolClassifier {
+public:
+    // Proposals classified per frame; the proposer's best ones are kept.
+    static constexpr int kMaxCrops = 64;
+    // Context added around a proposal on each side, as a fraction of its size.
+    static constexpr float kCropMargin = 0.1f;
+
+    // Loads the embedding model ([N, 3, S, S] float input with fixed S, one
+    // [N, D] float output) and the table, whose dim must be D. The proposer
+    // is borrowed and must outlive the classifier.
+    SymbolClassifier(Engine& proposer, const char* model_path, const char* table_path,
+                     const spotitml_engine_options& options);
+
+    SymbolClassifier(const SymbolClassifier&) = delete;
+    SymbolClassifier& operator=(const SymbolClassifier&) = delete;
+
+    // Replaces the embedding table; the old one stays if the new one fails.
+    void load_table(const char* table_path);
+    const EmbeddingIndex& index() const { return index_; }
+
+    // Detections whose crop is at least min_similarity (cosine) close to a
+    // table row, labeled with that row's class and scored by proposal score
+    // times similarity, best first. Returns how many were written.
+    int detect(const spotitml_frame& frame, float min_similarity, spotitml_detection* detections,
+               int max_detections);
+
+    int embedding_size() const { return embedding_size_; }
+    int input_size() const { return input_size_; }
+    bool dynamic_batch() const { return dynamic_batch_; }
+
+private:
+    // Embeds the crops already letterboxed into input_[0..count).
+    void embed(int count);
+
+    Engine& proposer_;
+    std::vector<int32_t> active_providers_;
+
+    Ort::Env env_;
+    Ort::Session session_{nullptr};
+    Ort::MemoryInfo memory_info_;
+    Ort::RunOptions run_options_;
+    std::string input_name_;
+    std::string output_name_;
+
+    int input_size_ = 0;      // S
+    int embedding_size_ = 0;  // D
+    bool dynamic_batch_ = false;
+
+    Preprocessor preprocessor_;
+    EmbeddingIndex index_;
+
+    std::vector<float> input_;   // kMaxCrops crops, NCHW
+    std::vector<float> output_;  // kMaxCrops embeddings
+    std::vector<spotitml_detection> proposals_;
+};
+
+} // namespace spotitml
@@ -0,0 +1,253 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace spotitml::trace {
+
+std::atomic<bool> g_capturing{false};
+
+namespace {
+
+enum Kind : uint8_t { kComplete, kFrame };
+
+struct Event {
+    const char* name;
+    int64_t begin_ns;  // since the capture started
+    int64_t duration_ns;
+    int64_t frame_id;
+    uint32_t thread;
+    Kind kind;
+    // kFrame: async span id, unique in the process. Frame ids are only
+    // unique per engine or worker, so two of them would pair each other's
+    // begin and end events if the frame id were the span id.
+    int64_t span_id = 0;
+};
+
+std::atomic<int64_t> g_next_span_id{1};
+
+// One thread's events. The mutex is only ever contended while start() or
+// write() touches the ring, never between recording threads.
+struct Ring {
+    std::mutex mutex;
+    std::vector<Event> events;
+    size_t next = 0;
+    bool wrapped = false;
+    bool in_use = false;
+
+    void clear() {
+        next = 0;
+        wrapped = false;
+    }
+
+    void push(const Event& event) {
+        if (events.empty()) {
+            events.resize(kRingCapacity);
+        }
+        events[next] = event;
+        if (++next == events.size()) {
+            next = 0;
+            wrapped = true;
+        }
+    }
+};
+
+// Leaked so exiting threads can still return their rings.
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Ring>> rings;
+    std::vector<std::pair<uint32_t, std::string>> thread_names;
+    std::atomic<int64_t> origin_ns{0};
+    std::atomic<int64_t> deadline_ns{0};  // 0 = none
+    std::atomic<uint32_t> next_thread{1};
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+int64_t to_ns(Clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+struct ThreadState {
+    Ring* ring = nullptr;
+    uint32_t id = 0;
+    int64_t frame_id = -1;
+
+    ~ThreadState() {
+        if (ring != nullptr) {
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            ring->in_use = false;
+        }
+    }
+
+    uint32_t thread_id() {
+        if (id == 0) {
+            id = registry().next_thread.fetch_add(1, std::memory_order_relaxed);
+        }
+        return id;
+    }
+
+    Ring& local_ring() {
+        if (ring == nullptr) {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            for (auto& candidate : r.rings) {
+                if (!candidate->in_use) {
+                    ring = candidate.get();
+                    break;
+                }
+            }
+            if (ring == nullptr) {
+                r.rings.push_back(std::make_unique<Ring>());
+                ring = r.rings.back().get();
+            }
+            ring->in_use = true;
+        }
+        return *ring;
+    }
+};
+
+thread_local ThreadState t_state;
+
+void record(Event event, Clock::time_point end) {
+    Registry& r = registry();
+    const int64_t deadline = r.deadline_ns.load(std::memory_order_relaxed);
+    if (deadline != 0 && to_ns(end) > deadline) {
+        g_capturing.store(false, std::memory_order_relaxed);
+        return;
+    }
+    event.begin_ns -= r.origin_ns.load(std::memory_order_relaxed);
+    event.thread = t_state.thread_id();
+    Ring& ring = t_state.local_ring();
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    ring.push(event);
+}
+
+void write_escaped(FILE* out, const char* text) {
+    for (; *text != '\0'; ++text) {
+        if (*text == '"' || *text == '\\') {
+            std::fputc('\\', out);
+        }
+        std::fputc(*text, out);
+    }
+}
+
+} // namespace
+
+void start(int32_t duration_ms) {
+    Registry& r = registry();
+    g_capturing.store(false, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (auto& ring : r.rings) {
+            std::lock_guard<std::mutex> ring_lock(ring->mutex);
+            ring->clear();
+        }
+    }
+    const int64_t now = to_ns(Clock::now());
+    r.origin_ns.store(now, std::memory_order_relaxed);
+    r.deadline_ns.store(duration_ms > 0 ? now + int64_t{duration_ms} * 1000000 : 0, std::memory_order_relaxed);
+    g_capturing.store(true, std::memory_order_release);
+}
+
+void stop() {
+    g_capturing.store(false, std::memory_order_release);
+}
+
+int64_t write(const char* path) {
+    std::vector<Event> events;
+    std::vector<std::pair<uint32_t, std::string>> names;
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        names = r.thread_names;
+        for (auto& ring : r.rings) {
+            std::lock_guard<std::mutex> ring_lock(ring->mutex);
+            const size_t count = ring->wrapped ? ring->events.size() : ring->next;
+            events.insert(events.end(), ring->events.begin(), ring->events.begin() + count);
+        }
+    }
+    std::sort(events.begin(), events.end(),
+              [](const Event& a, const Event& b) { return a.begin_ns < b.begin_ns; });
+
+    FILE* out = std::fopen(path, "w");
+    if (out == nullptr) {
+        return -1;
+    }
+    std::fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(out, "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\",\"args\":{\"name\":\"spotitml_native\"}}");
+    for (const auto& [thread, name] : names) {
+        std::fprintf(out, ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"",
+                     thread);
+        write_escaped(out, name.c_str());
+        std::fprintf(out, "\"}}");
+    }
+    for (const Event& e : events) {
+        const double ts = e.begin_ns / 1e3;
+        const double dur = e.duration_ns / 1e3;
+        if (e.kind == kComplete) {
+            std::fprintf(out,
+                         ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"cat\":\"stage\",\"name\":\"%s\",\"ts\":%.3f,"
+                         "\"dur\":%.3f,\"args\":{\"frame\":%lld}}",
+                         e.thread, e.name, ts, dur, static_cast<long long>(e.frame_id));
+        } else {
+            // Async begin/end pair keyed by span id: Perfetto draws each
+            // frame as its own track from submit to result.
+            std::fprintf(out,
+                         ",\n{\"ph\":\"b\",\"pid\":1,\"tid\":%u,\"cat\":\"frame\",\"name\":\"frame %lld\",\"id\":%lld,"
+                         "\"ts\":%.3f}",
+                         e.thread, static_cast<long long>(e.frame_id), static_cast<long long>(e.span_id), ts);
+            std::fprintf(out,
+                         ",\n{\"ph\":\"e\",\"pid\":1,\"tid\":%u,\"cat\":\"frame\",\"name\":\"frame %lld\",\"id\":%lld,"
+                         "\"ts\":%.3f}",
+                         e.thread, static_cast<long long>(e.frame_id), static_cast<long long>(e.span_id), ts + dur);
+        }
+    }
+    std::fprintf(out, "\n]}\n");
+    const bool ok = std::fclose(out) == 0;
+    return ok ? static_cast<int64_t>(events.size()) : -1;
+}
+
+void complete(const char* name, Clock::time_point begin, Clock::time_point end) {
+    record({name, to_ns(begin), to_ns(end) - to_ns(begin), t_state.frame_id, 0, kComplete}, end);
+}
+
+void frame_span(int64_t frame_id, Clock::time_point begin, Clock::time_point end) {
+    record({"frame", to_ns(begin), to_ns(end) - to_ns(begin), frame_id, 0, kFrame,
+            g_next_span_id.fetch_add(1, std::memory_order_relaxed)},
+           end);
+}
+
+void set_thread_name(const char* name) {
+    const uint32_t id = t_state.thread_id();
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (auto& entry : r.thread_names) {
+        if (entry.first == id) {
+            entry.second = name;
+            return;
+        }
+    }
+    r.thread_names.emplace_back(id, name);
+}
+
+int64_t current_frame() {
+    return t_state.frame_id;
+}
+
+FrameScope::FrameScope(int64_t frame_id) : previous_(t_state.frame_id) {
+    t_state.frame_id = frame_id;
+}
+
+FrameScope::~FrameScope() {
+    t_state.frame_id = previous_;
+}
+
+} // namespace spotitml::trace
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace spotitml::trace {
+
+// Frame-by-frame span capture, written out as Chrome trace-event JSON for
+// Perfetto or chrome://tracing.
+//
+// While a capture runs, every instrumented stage (see instrumentation.h)
+// also records a span tagged with the current frame id into a ring buffer
+// owned by its thread, and each worker frame gets an async span from submit
+// to result so one frame can be followed across the stage threads. Outside a
+// capture the cost is one relaxed load per stage.
+
+using Clock = std::chrono::steady_clock;
+
+// Events kept per thread; older ones are overwritten.
+constexpr int kRingCapacity = 8192;
+
+extern std::atomic<bool> g_capturing;
+
+inline bool capturing() {
+    return g_capturing.load(std::memory_order_relaxed);
+}
+
+// Clears all rings and starts recording; stops by itself after duration_ms
+// (<= 0 records until stop()).
+void start(int32_t duration_ms);
+void stop();
+
+// Writes every recorded event as JSON; returns how many, or -1 if the file
+// could not be written.
+int64_t write(const char* path);
+
+// Span on the calling thread.
+void complete(const char* name, Clock::time_point begin, Clock::time_point end);
+// Span for one frame that may start and end on different threads.
+void frame_span(int64_t frame_id, Clock::time_point begin, Clock::time_point end);
+
+// Names the calling thread in traces.
+void set_thread_name(const char* name);
+
+// Frame the calling thread is working on; spans it records are tagged with it.
+int64_t current_frame();
+
+class FrameScope {
+public:
+    explicit FrameScope(int64_t frame_id);
+    ~FrameScope();
+
+    FrameScope(const FrameScope&) = delete;
+    FrameScope& operator=(const FrameScope&) = delete;
+
+private:
+    int64_t previous_;
+};
+
+} // namespace spotitml::trace
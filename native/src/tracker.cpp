@@ -0,0 +1,215 @@
+#include "tracker.h"
+#include "preprocess.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace spotitml {
+
+namespace {
+
+// Weight of a detection against the predicted box, and of the prediction
+// error in the velocity estimate.
+constexpr float kAlpha = 0.7f;
+constexpr float kBeta = 0.3f;
+// Center distance, relative to the mean box diagonal, within which a
+// non-overlapping detection still continues a track.
+constexpr float kCenterGate = 0.5f;
+
+float iou(const spotitml_detection& a, const spotitml_detection& b) {
+    const float w = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
+    const float h = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+    if (w <= 0.0f || h <= 0.0f) {
+        return 0.0f;
+    }
+    const float inter = w * h;
+    const float uni = (a.x2 - a.x1) * (a.y2 - a.y1) + (b.x2 - b.x1) * (b.y2 - b.y1) - inter;
+    return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+float diagonal(const spotitml_detection& d) {
+    return std::hypot(d.x2 - d.x1, d.y2 - d.y1);
+}
+
+} // namespace
+
+Tracker::Tracker(const spotitml_tracking_options& options) : options_(options) {
+    tracks_.reserve(kMaxTracks);
+    matched_.reserve(kMaxDetections);
+    continued_.reserve(kMaxTracks);
+    pairs_.reserve(static_cast<size_t>(kMaxTracks) * kMaxDetections);
+}
+
+void Tracker::clear() {
+    tracks_.clear();
+    frame_id_ = -1;
+    last_update_ = -1;
+}
+
+void Tracker::advance(int64_t frame_id) {
+    const float dt = frame_id_ < 0 ? 1.0f : static_cast<float>(std::max<int64_t>(frame_id - frame_id_, 1));
+    frame_id_ = frame_id;
+    for (Track& track : tracks_) {
+        spotitml_detection& box = track.state.detection;
+        box.x1 += track.vx * dt;
+        box.x2 += track.vx * dt;
+        box.y1 += track.vy * dt;
+        box.y2 += track.vy * dt;
+        track.state.detected = 0;
+    }
+}
+
+int Tracker::predict(int64_t frame_id) {
+    advance(frame_id);
+    return count();
+}
+
+int Tracker::update(const spotitml_detection* detections, int count, int64_t frame_id) {
+    // The prediction error built up over every frame since the last update.
+    const float dt = last_update_ < 0 ? 1.0f : static_cast<float>(std::max<int64_t>(frame_id - last_update_, 1));
+    last_update_ = frame_id;
+    advance(frame_id);
+    count = std::clamp(count, 0, kMaxDetections);
+    matched_.assign(static_cast<size_t>(count), 0);
+    continued_.assign(tracks_.size(), 0);
+    const int track_count = static_cast<int>(tracks_.size());
+
+    // Greedy assignment, best affinity first; a pass only pairs what earlier
+    // passes left over.
+    const auto assign = [&]() {
+        std::sort(pairs_.begin(), pairs_.end(), [](const Pair& a, const Pair& b) { return a.affinity > b.affinity; });
+        for (const Pair& pair : pairs_) {
+            Track& track = tracks_[pair.track];
+            if (continued_[pair.track] != 0 || matched_[pair.detection] != 0) {
+                continue;
+            }
+            continued_[pair.track] = 1;
+            matched_[pair.detection] = 1;
+
+            const spotitml_detection& measured = detections[pair.detection];
+            spotitml_detection& box = track.state.detection;
+            const float error_x = (measured.x1 + measured.x2 - box.x1 - box.x2) * 0.5f;
+            const float error_y = (measured.y1 + measured.y2 - box.y1 - box.y2) * 0.5f;
+            box.x1 += kAlpha * (measured.x1 - box.x1);
+            box.y1 += kAlpha * (measured.y1 - box.y1);
+            box.x2 += kAlpha * (measured.x2 - box.x2);
+            box.y2 += kAlpha * (measured.y2 - box.y2);
+            box.score = measured.score;
+            track.vx += kBeta * error_x / dt;
+            track.vy += kBeta * error_y / dt;
+            ++track.state.hits;
+            track.state.missed = 0;
+            track.state.detected = 1;
+        }
+        pairs_.clear();
+    };
+
+    pairs_.clear();
+    for (int t = 0; t < track_count; ++t) {
+        const spotitml_detection& box = tracks_[t].state.detection;
+        for (int d = 0; d < count; ++d) {
+            if (detections[d].class_id != box.class_id) {
+                continue;
+            }
+            const float overlap = iou(box, detections[d]);
+            if (overlap >= options_.iou_threshold) {
+                pairs_.push_back({overlap, t, d});
+            }
+        }
+    }
+    assign();
+
+    for (int t = 0; t < track_count; ++t) {
+        const spotitml_detection& box = tracks_[t].state.detection;
+        if (continued_[t] != 0) {
+            continue;
+        }
+        for (int d = 0; d < count; ++d) {
+            const spotitml_detection& det = detections[d];
+            if (matched_[d] != 0 || det.class_id != box.class_id) {
+                continue;
+            }
+            const float dx = (det.x1 + det.x2 - box.x1 - box.x2) * 0.5f;
+            const float dy = (det.y1 + det.y2 - box.y1 - box.y2) * 0.5f;
+            const float gate = kCenterGate * 0.5f * (diagonal(box) + diagonal(det));
+            const float distance = std::hypot(dx, dy);
+            if (distance < gate) {
+                pairs_.push_back({-distance, t, d});
+            }
+        }
+    }
+    assign();
+
+    // Tracks the detector did not confirm age; stale ones go.
+    size_t kept = 0;
+    for (int t = 0; t < track_count; ++t) {
+        if (continued_[t] == 0 && ++tracks_[t].state.missed > options_.max_missed) {
+            continue;
+        }
+        tracks_[kept++] = tracks_[t];
+    }
+    tracks_.resize(kept);
+
+    for (int d = 0; d < count && tracks_.size() < static_cast<size_t>(kMaxTracks); ++d) {
+        if (matched_[d] != 0) {
+            continue;
+        }
+        Track track;
+        track.state.detection = detections[d];
+        track.state.track_id = next_id_++;
+        track.state.hits = 1;
+        track.state.missed = 0;
+        track.state.detected = 1;
+        tracks_.push_back(track);
+    }
+    return this->count();
+}
+
+int Tracker::tracks(spotitml_track* tracks, int max_tracks) const {
+    const int n = std::min(count(), std::max(max_tracks, 0));
+    for (int i = 0; i < n; ++i) {
+        tracks[i] = tracks_[i].state;
+    }
+    return n;
+}
+
+KeyframeScheduler::KeyframeScheduler(const spotitml_tracking_options& options) : options_(options) {}
+
+bool KeyframeScheduler::needs_detection(const spotitml_frame& frame) {
+    if (frame.planes[0] == nullptr || frame.width <= 0 || frame.height <= 0) {
+        return true;  // let preprocessing report it
+    }
+    // Cell centers.
+    for (int gy = 0; gy < kGridHeight; ++gy) {
+        const int y = static_cast<int>((2 * gy + 1) * static_cast<int64_t>(frame.height) / (2 * kGridHeight));
+        for (int gx = 0; gx < kGridWidth; ++gx) {
+            const int x = static_cast<int>((2 * gx + 1) * static_cast<int64_t>(frame.width) / (2 * kGridWidth));
+            current_[gy * kGridWidth + gx] = frame_luma(frame, x, y);
+        }
+    }
+
+    bool keyframe = !has_keyframe_ || frame.width != width_ || frame.height != height_ ||
+                    since_keyframe_ + 1 >= options_.keyframe_interval;
+    if (has_keyframe_) {
+        int total = 0;
+        for (int i = 0; i < kGridWidth * kGridHeight; ++i) {
+            total += std::abs(static_cast<int>(current_[i]) - static_cast<int>(keyframe_[i]));
+        }
+        last_motion_ = static_cast<float>(total) / (kGridWidth * kGridHeight);
+        keyframe = keyframe || last_motion_ > options_.motion_threshold;
+    }
+
+    if (!keyframe) {
+        ++since_keyframe_;
+        return false;
+    }
+    std::copy(std::begin(current_), std::end(current_), std::begin(keyframe_));
+    has_keyframe_ = true;
+    width_ = frame.width;
+    height_ = frame.height;
+    since_keyframe_ = 0;
+    return true;
+}
+
+} // namespace spotitml
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "spotitml_native.h"
+#include "nms.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace spotitml {
+
+// Keeps detections stable across camera frames and fills in the frames the
+// detector skips.
+//
+// Each track carries a box and a per-frame velocity of its center (an
+// alpha-beta filter, so one noisy detection neither jumps the box nor
+// resets its motion). update() associates the detector's boxes with the
+// tracks' predicted boxes greedily by IoU within a class, then by center
+// distance for fast moves that no longer overlap; unmatched detections
+// start new tracks with fresh ids, and tracks unmatched for more than
+// max_missed detector runs are dropped, so a symbol missed on one frame
+// does not flicker out. predict() moves every track along its velocity for
+// a frame the detector did not run on.
+class Tracker {
+public:
+    static constexpr int kMaxTracks = 128;
+    // Detections considered per update, best first; the rest are ignored.
+    // Bounds the association pairs, so update() never allocates.
+    static constexpr int kMaxDetections = Nms::kDefaultMaxDetections;
+
+    explicit Tracker(const spotitml_tracking_options& options);
+
+    // Detector results for frame_id (ids must increase), best score first as
+    // NMS writes them; returns the track count.
+    int update(const spotitml_detection* detections, int count, int64_t frame_id);
+    // Propagates the tracks to frame_id without detections.
+    int predict(int64_t frame_id);
+
+    // Copies at most max_tracks current tracks, oldest first.
+    int tracks(spotitml_track* tracks, int max_tracks) const;
+    int count() const { return static_cast<int>(tracks_.size()); }
+
+    void clear();
+
+private:
+    struct Track {
+        spotitml_track state;
+        float vx = 0.0f;  // center velocity, pixels per frame
+        float vy = 0.0f;
+    };
+    struct Pair {
+        float affinity;  // higher is a better match
+        int track;
+        int detection;
+    };
+
+    void advance(int64_t frame_id);
+
+    spotitml_tracking_options options_;
+    std::vector<Track> tracks_;
+    // Per update: detections used and tracks continued.
+    std::vector<uint8_t> matched_;
+    std::vector<uint8_t> continued_;
+    std::vector<Pair> pairs_;
+    int32_t next_id_ = 1;
+    int64_t frame_id_ = -1;
+    int64_t last_update_ = -1;
+};
+
+// Decides per frame whether the detector has to run or tracks can be
+// propagated instead: at least every keyframe_interval frames, and whenever
+// the picture changed since the last detector frame by more than
+// motion_threshold (mean absolute luma difference over a coarse grid of
+// single-pixel taps, a few thousand reads per frame). A still, empty table
+// therefore costs one detector run per interval, and a card moving into view
+// triggers one at once.
+class KeyframeScheduler {
+public:
+    static constexpr int kGridWidth = 64;
+    static constexpr int kGridHeight = 48;
+
+    explicit KeyframeScheduler(const spotitml_tracking_options& options);
+
+    // Call for every frame in order; true if the detector must run on it.
+    bool needs_detection(const spotitml_frame& frame);
+
+    // Mean absolute luma difference of the last frame to the last keyframe.
+    float last_motion() const { return last_motion_; }
+
+private:
+    spotitml_tracking_options options_;
+    uint8_t keyframe_[kGridWidth * kGridHeight] = {};
+    uint8_t current_[kGridWidth * kGridHeight] = {};
+    bool has_keyframe_ = false;
+    int width_ = 0;
+    int height_ = 0;
+    int since_keyframe_ = 0;
+    float last_motion_ = 0.0f;
+};
+
+} // namespace spotitml
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+
+namespace spotitml {
+
+// Single-producer / single-consumer "latest value wins" mailbox.
+//
+// The producer fills write_buffer() and publish()es it; the consumer calls
+// acquire() and then reads read_buffer(). The three buffers rotate through one
+// atomic exchange on each side, so neither side ever waits for the other and
+// a value the consumer has not picked up yet is simply replaced.
+template <typename T>
+class TripleBuffer {
+public:
+    // Applies f to all three buffers; only valid while no other thread uses
+    // the mailbox (setup and teardown).
+    template <typename F>
+    void for_each(F f) {
+        for (T& buffer : buffers_) {
+            f(buffer);
+        }
+    }
+
+    T& write_buffer() { return buffers_[write_]; }
+    T& read_buffer() { return buffers_[read_]; }
+
+    // Hands the write buffer to the consumer. Returns true when this replaced
+    // a value that was never acquired (i.e. a dropped value).
+    bool publish() {
+        const int previous = middle_.exchange(write_ | kFresh, std::memory_order_acq_rel);
+        write_ = previous & kIndexMask;
+        return (previous & kFresh) != 0;
+    }
+
+    // Swaps in the newest published value. Returns false if nothing new was
+    // published since the last acquire; read_buffer() is unchanged then.
+    bool acquire() {
+        if ((middle_.load(std::memory_order_relaxed) & kFresh) == 0) {
+            return false;
+        }
+        read_ = middle_.exchange(read_, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+
+    bool has_fresh() const { return (middle_.load(std::memory_order_acquire) & kFresh) != 0; }
+
+private:
+    static constexpr int kFresh = 4;
+    static constexpr int kIndexMask = 3;
+
+    T buffers_[3];
+    int write_ = 0;
+    std::atomic<int> middle_{1};
+    int read_ = 2;
+};
+
+} // namespace spotitml
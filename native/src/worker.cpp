@@ -0,0 +1,304 @@
+#include "worker.h"
+#include "frame_pool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace spotitml {
+
+namespace {
+
+constexpr int kMaxDetections = Nms::kDefaultMaxDetections;
+
+int clamp_depth(int depth) {
+    return depth <= 0 ? Worker::kDefaultPipelineDepth : std::min(depth, Worker::kMaxPipelineDepth);
+}
+
+spotitml_tracking_options tracking_or_default(const spotitml_tracking_options* tracking) {
+    if (tracking != nullptr) {
+        return *tracking;
+    }
+    spotitml_tracking_options defaults;
+    worker_default_tracking_options(&defaults);
+    return defaults;
+}
+
+} // namespace
+
+Worker::Worker(Engine& engine, int pipeline_depth, const spotitml_tracking_options* tracking,
+               spotitml_result_callback callback, void* user_data)
+    : engine_(engine),
+      callback_(callback),
+      user_data_(user_data),
+      stages_(clamp_depth(pipeline_depth)),
+      free_(stages_.size()),
+      preprocessed_(stages_.size()),
+      inferred_(stages_.size()),
+      tracking_(tracking != nullptr),
+      scheduler_(tracking_or_default(tracking)),
+      tracker_(tracking_or_default(tracking)),
+      detections_(kMaxDetections) {
+    results_.for_each([this](ResultSlot& slot) {
+        slot.detections.resize(tracking_ ? Tracker::kMaxTracks : kMaxDetections);
+        if (tracking_) {
+            slot.tracks.resize(Tracker::kMaxTracks);
+        }
+    });
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        stages_[i].buffers = engine_.create_buffers();
+        free_.push(static_cast<int>(i));
+    }
+    preprocess_thread_ = std::thread(&Worker::preprocess_loop, this);
+    inference_thread_ = std::thread(&Worker::inference_loop, this);
+    postprocess_thread_ = std::thread(&Worker::postprocess_loop, this);
+}
+
+Worker::~Worker() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    preprocess_thread_.join();
+    inference_thread_.join();
+    postprocess_thread_.join();
+    frames_.for_each([](FrameSlot& slot) { slot.release_buffer(); });
+}
+
+template <typename Ready>
+bool Worker::wait_until(Ready ready) {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    wake_.wait(lock, [&] { return stop_ || ready(); });
+    return !stop_;
+}
+
+void Worker::wake_stages() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    wake_.notify_all();
+}
+
+void Worker::FrameSlot::release_buffer() {
+    if (pool != nullptr) {
+        pool->release(pool_index);
+        pool = nullptr;
+        pool_index = -1;
+    }
+}
+
+int64_t Worker::submit(const spotitml_frame& frame) {
+    FrameSlot& slot = frames_.write_buffer();
+    slot.frame = frame;
+
+    const int planes = frame_plane_count(frame);
+    for (int i = 0; i < 3; ++i) {
+        if (i >= planes || frame.planes[i] == nullptr) {
+            slot.frame.planes[i] = nullptr;
+            continue;
+        }
+        // Grows to the largest frame seen, then stays put.
+        const size_t size = frame_plane_size(frame, i);
+        if (slot.storage[i].size() < size) {
+            slot.storage[i].resize(size);
+        }
+        std::memcpy(slot.storage[i].data(), frame.planes[i], size);
+        slot.frame.planes[i] = slot.storage[i].data();
+    }
+
+    return publish_frame(slot);
+}
+
+int64_t Worker::submit_pooled(const spotitml_frame& frame, FramePool& pool, int index) {
+    const int planes = frame_plane_count(frame);
+    for (int i = 0; i < planes; ++i) {
+        if (frame.planes[i] != nullptr && !pool.contains(index, frame.planes[i], frame_plane_size(frame, i))) {
+            throw std::invalid_argument("Frame planes are not inside the pool buffer");
+        }
+    }
+
+    FrameSlot& slot = frames_.write_buffer();
+    slot.frame = frame;
+    slot.pool = &pool;
+    slot.pool_index = index;
+    return publish_frame(slot);
+}
+
+int64_t Worker::publish_frame(FrameSlot& slot) {
+    const int64_t frame_id = next_frame_id_.fetch_add(1, std::memory_order_relaxed);
+    slot.frame_id = frame_id;
+    slot.submitted = instrumentation::timestamp();
+    SPOTITML_COUNT(instrumentation::kFramesSubmitted, 1);
+
+    if (frames_.publish()) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        SPOTITML_COUNT(instrumentation::kFramesDropped, 1);
+        // The replaced frame is our next write slot; give its buffer back.
+        frames_.write_buffer().release_buffer();
+    }
+    wake_stages();
+    return frame_id;
+}
+
+int Worker::latest_results(spotitml_detection* detections, int max_detections, int64_t* frame_id,
+                           std::string* error) {
+    results_.acquire();
+    const ResultSlot& slot = results_.read_buffer();
+    if (frame_id != nullptr) {
+        *frame_id = slot.frame_id;
+    }
+    if (slot.count < 0) {
+        if (error != nullptr) {
+            *error = slot.error;
+        }
+        return -1;
+    }
+    const int count = std::min(slot.count, max_detections);
+    std::copy_n(slot.detections.data(), count, detections);
+    return count;
+}
+
+int Worker::latest_tracks(spotitml_track* tracks, int max_tracks, int64_t* frame_id, std::string* error) {
+    if (!tracking_) {
+        if (error != nullptr) {
+            *error = "worker was created without tracking";
+        }
+        return -1;
+    }
+    results_.acquire();
+    const ResultSlot& slot = results_.read_buffer();
+    if (frame_id != nullptr) {
+        *frame_id = slot.frame_id;
+    }
+    if (slot.count < 0) {
+        if (error != nullptr) {
+            *error = slot.error;
+        }
+        return -1;
+    }
+    const int count = std::min(slot.count, max_tracks);
+    std::copy_n(slot.tracks.data(), count, tracks);
+    return count;
+}
+
+void Worker::preprocess_loop() {
+    SPOTITML_THREAD_NAME("spotitml.preprocess");
+    for (;;) {
+        int index = -1;
+        if (!wait_until([this] { return !free_.empty(); })) {
+            return;
+        }
+        free_.pop(index);
+        // Stay at most one frame ahead of inference: a second queued frame
+        // would only be staler by the time the session gets to it.
+        if (!wait_until([this] { return preprocessed_.empty() && frames_.has_fresh(); })) {
+            return;
+        }
+        frames_.acquire();
+        FrameSlot& frame = frames_.read_buffer();
+
+        StageSlot& slot = stages_[index];
+        slot.frame_id = frame.frame_id;
+        slot.submitted = frame.submitted;
+        slot.error.clear();
+        try {
+            SPOTITML_FRAME_SCOPE(slot.frame_id);
+            slot.detect = !tracking_ || scheduler_.needs_detection(frame.frame);
+            if (slot.detect) {
+                engine_.preprocess(frame.frame, preprocessor_, slot.buffers);
+            }
+        } catch (const std::exception& e) {
+            slot.error = e.what();
+        }
+        // The frame is fully consumed once it is in the input tensor.
+        frame.release_buffer();
+
+        preprocessed_.push(index);
+        wake_stages();
+    }
+}
+
+void Worker::inference_loop() {
+    SPOTITML_THREAD_NAME("spotitml.inference");
+    for (;;) {
+        int index = -1;
+        if (!wait_until([this] { return !preprocessed_.empty(); })) {
+            return;
+        }
+        preprocessed_.pop(index);
+
+        StageSlot& slot = stages_[index];
+        if (slot.error.empty() && slot.detect) {
+            try {
+                SPOTITML_FRAME_SCOPE(slot.frame_id);
+                engine_.infer(slot.buffers);
+            } catch (const std::exception& e) {
+                slot.error = e.what();
+            }
+        }
+
+        inferred_.push(index);
+        wake_stages();
+    }
+}
+
+void Worker::publish_tracks(const StageSlot& slot, ResultSlot& result) {
+    if (slot.detect) {
+        const int count = engine_.postprocess(slot.buffers, decoder_, nms_, detections_.data(), kMaxDetections);
+        tracker_.update(detections_.data(), count, slot.frame_id);
+    } else {
+        tracker_.predict(slot.frame_id);
+        SPOTITML_COUNT(instrumentation::kFramesTracked, 1);
+    }
+    result.count = tracker_.tracks(result.tracks.data(), Tracker::kMaxTracks);
+    for (int i = 0; i < result.count; ++i) {
+        result.detections[i] = result.tracks[i].detection;
+    }
+}
+
+void Worker::postprocess_loop() {
+    SPOTITML_THREAD_NAME("spotitml.postprocess");
+    for (;;) {
+        int index = -1;
+        if (!wait_until([this] { return !inferred_.empty(); })) {
+            return;
+        }
+        inferred_.pop(index);
+
+        StageSlot& slot = stages_[index];
+        ResultSlot& result = results_.write_buffer();
+        result.frame_id = slot.frame_id;
+        if (slot.error.empty()) {
+            try {
+                SPOTITML_FRAME_SCOPE(slot.frame_id);
+                if (!tracking_) {
+                    result.count = engine_.postprocess(slot.buffers, decoder_, nms_, result.detections.data(),
+                                                       kMaxDetections);
+                } else {
+                    publish_tracks(slot, result);
+                }
+            } catch (const std::exception& e) {
+                result.count = -1;
+                result.error = e.what();
+            }
+        } else {
+            result.count = -1;
+            result.error = slot.error;
+        }
+        const int count = result.count;
+        const int64_t frame_id = slot.frame_id;
+        results_.publish();
+        SPOTITML_COUNT(count >= 0 ? instrumentation::kFramesProcessed : instrumentation::kFramesFailed, 1);
+        SPOTITML_RECORD_FRAME(frame_id, slot.submitted);
+
+        free_.push(index);
+        wake_stages();
+
+        if (callback_ != nullptr) {
+            callback_(frame_id, count, user_data_);
+        }
+    }
+}
+
+} // namespace spotitml
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "spotitml_native.h"
+#include "decoder.h"
+#include "engine.h"
+#include "instrumentation.h"
+#include "nms.h"
+#include "preprocess.h"
+#include "spsc_ring.h"
+#include "tracker.h"
+#include "triple_buffer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace spotitml {
+
+class FramePool;
+
+// Background detection for a camera stream.
+//
+// submit() copies a frame into a latest-frame-wins mailbox and returns at
+// once; a frame the worker has not started on yet is replaced (and counted as
+// dropped) rather than queued.
+//
+// Detection runs as a three-stage pipeline, one thread per stage: preprocess
+// takes the newest frame into a free set of InferenceBuffers, inference runs
+// the session on it, and postprocess decodes, runs NMS, publishes the
+// detections through a second mailbox and invokes the callback. So frame N+1
+// is letterboxed while frame N infers and frame N-1 is decoded. Stages hand
+// buffer indices to each other through SPSC rings; pipeline_depth buffer sets
+// circulate, which bounds the frames in flight. Depth 1 runs the stages
+// strictly one frame at a time; the default of 3 keeps every stage busy.
+// Preprocessing never runs more than one frame ahead of inference, so a frame
+// waits at most one stage longer than it would without the pipeline.
+//
+// With tracking, the preprocess stage asks a KeyframeScheduler whether the
+// frame needs the detector; frames that do not skip letterboxing and
+// inference, and the postprocess stage propagates the Tracker's boxes for
+// them instead. Stages hand frames on in order, so the tracker sees them in
+// submission order.
+class Worker {
+public:
+    static constexpr int kDefaultPipelineDepth = 3;
+    static constexpr int kMaxPipelineDepth = 8;
+
+    // pipeline_depth <= 0 selects kDefaultPipelineDepth; tracking may be
+    // nullptr to run the detector on every frame.
+    Worker(Engine& engine, int pipeline_depth, const spotitml_tracking_options* tracking,
+           spotitml_result_callback callback, void* user_data);
+    ~Worker();
+
+    Worker(const Worker&) = delete;
+    Worker& operator=(const Worker&) = delete;
+
+    // Returns the id assigned to the frame.
+    int64_t submit(const spotitml_frame& frame);
+
+    // Zero-copy variant: the frame's planes live in pool buffer index, which
+    // the worker now owns and releases once the frame is processed or dropped.
+    int64_t submit_pooled(const spotitml_frame& frame, FramePool& pool, int index);
+
+    // Copies the newest published detections; -1 if that frame failed.
+    int latest_results(spotitml_detection* detections, int max_detections, int64_t* frame_id,
+                       std::string* error);
+    // Same for the tracks of a tracking worker.
+    int latest_tracks(spotitml_track* tracks, int max_tracks, int64_t* frame_id, std::string* error);
+
+    bool tracking() const { return tracking_; }
+
+    int64_t dropped_frames() const { return dropped_.load(std::memory_order_relaxed); }
+    int pipeline_depth() const { return static_cast<int>(stages_.size()); }
+
+private:
+    struct FrameSlot {
+        spotitml_frame frame{};
+        std::vector<uint8_t> storage[3];
+        int64_t frame_id = 0;
+        instrumentation::Clock::time_point submitted;
+        FramePool* pool = nullptr;
+        int pool_index = -1;
+
+        void release_buffer();
+    };
+
+    struct ResultSlot {
+        std::vector<spotitml_detection> detections;
+        std::vector<spotitml_track> tracks;
+        int count = 0;
+        int64_t frame_id = -1;
+        std::string error;
+    };
+
+    // One frame in flight between stages.
+    struct StageSlot {
+        InferenceBuffers buffers;
+        int64_t frame_id = -1;
+        instrumentation::Clock::time_point submitted;
+        // False for frames the tracker answers without the detector.
+        bool detect = true;
+        // Set when a stage failed; later stages pass the error through.
+        std::string error;
+    };
+
+    int64_t publish_frame(FrameSlot& slot);
+    // Runs the tracker on a finished frame and writes its tracks to result.
+    void publish_tracks(const StageSlot& slot, ResultSlot& result);
+
+    void preprocess_loop();
+    void inference_loop();
+    void postprocess_loop();
+
+    // Parks the calling stage until ready() holds; false once stopping.
+    template <typename Ready>
+    bool wait_until(Ready ready);
+    void wake_stages();
+
+    Engine& engine_;
+    spotitml_result_callback callback_;
+    void* user_data_;
+
+    TripleBuffer<FrameSlot> frames_;
+    TripleBuffer<ResultSlot> results_;
+
+    std::vector<StageSlot> stages_;
+    SpscRing<int> free_;
+    SpscRing<int> preprocessed_;
+    SpscRing<int> inferred_;
+
+    // Each stage owns its scratch state.
+    Preprocessor preprocessor_;
+    Decoder decoder_;
+    Nms nms_;
+
+    bool tracking_;
+    KeyframeScheduler scheduler_;  // preprocess stage
+    Tracker tracker_;              // postprocess stage
+    std::vector<spotitml_detection> detections_;  // postprocess stage, before tracking
+
+    // Only used to park stages while their input is empty.
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+
+    std::atomic<int64_t> next_frame_id_{0};
+    std::atomic<int64_t> dropped_{0};
+
+    std::thread preprocess_thread_;
+    std::thread inference_thread_;
+    std::thread postprocess_thread_;
+};
+
+} // namespace spotitml
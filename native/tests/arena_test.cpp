@@ -0,0 +1,124 @@
+// Scratch arena: alignment, reset, reserve, and the overflow blocks a frame
+// spills into being folded into one larger block by the next reset().
+
+#include "arena.h"
+#include "check.h"
+
+#include <cstdint>
+#include <cstring>
+
+using namespace spotitml;
+
+namespace {
+
+bool aligned(const void* p) {
+    return reinterpret_cast<uintptr_t>(p) % ScratchArena::kAlignment == 0;
+}
+
+void test_bump_and_reset() {
+    ScratchArena arena(1024);
+    CHECK_EQ(arena.capacity(), 1024u);
+    CHECK_EQ(arena.heap_allocations(), 1u);
+    CHECK_EQ(arena.used(), 0u);
+
+    // Every allocation is rounded up to the alignment, zero bytes included.
+    char* a = arena.allocate<char>(1);
+    float* b = arena.allocate<float>(20);
+    void* c = arena.allocate_bytes(0);
+    CHECK(aligned(a) && aligned(b) && aligned(c));
+    CHECK_EQ(reinterpret_cast<uint8_t*>(b) - reinterpret_cast<uint8_t*>(a), 64);
+    CHECK_EQ(arena.used(), 64u + 128u + 64u);
+    std::memset(b, 0, 20 * sizeof(float));
+
+    // reset() hands the same memory out again without touching the heap.
+    arena.reset();
+    CHECK_EQ(arena.used(), 0u);
+    CHECK(arena.allocate<char>(1) == a);
+    CHECK_EQ(arena.heap_allocations(), 1u);
+    CHECK_EQ(arena.capacity(), 1024u);
+}
+
+void test_reserve() {
+    ScratchArena arena;
+    CHECK_EQ(arena.capacity(), 0u);
+    CHECK_EQ(arena.heap_allocations(), 0u);
+
+    arena.reserve(100);
+    CHECK_EQ(arena.capacity(), 128u);
+    CHECK_EQ(arena.heap_allocations(), 1u);
+
+    // Smaller or equal requests keep the block.
+    arena.reserve(128);
+    arena.reserve(1);
+    CHECK_EQ(arena.heap_allocations(), 1u);
+
+    arena.allocate<char>(64);
+    arena.reserve(4096);
+    CHECK_EQ(arena.capacity(), 4096u);
+    CHECK_EQ(arena.used(), 0u);
+    CHECK_EQ(arena.heap_allocations(), 2u);
+}
+
+void test_overflow_folds_on_reset() {
+    ScratchArena arena(256);
+
+    // Frame 1: 256 bytes fit, the next 320 spill into two extra blocks.
+    uint8_t* first = arena.allocate<uint8_t>(256);
+    uint8_t* spill_a = arena.allocate<uint8_t>(128);
+    uint8_t* spill_b = arena.allocate<uint8_t>(150);
+    CHECK(aligned(spill_a) && aligned(spill_b));
+    CHECK(spill_a < first || spill_a >= first + 256);
+    std::memset(spill_a, 1, 128);
+    std::memset(spill_b, 2, 150);
+    CHECK_EQ(arena.used(), 256u + 128u + 192u);
+    CHECK_EQ(arena.capacity(), 256u);
+    CHECK_EQ(arena.heap_allocations(), 3u);
+
+    // The next reset() replaces everything with one block of the combined
+    // size plus a quarter of headroom, rounded up to the alignment.
+    arena.reset();
+    const size_t needed = 256 + 128 + 192;
+    const size_t grown = (needed + needed / 4 + ScratchArena::kAlignment - 1) / ScratchArena::kAlignment *
+                         ScratchArena::kAlignment;
+    CHECK_EQ(arena.capacity(), grown);
+    CHECK_EQ(arena.used(), 0u);
+    CHECK_EQ(arena.heap_allocations(), 4u);
+
+    // Frame 2 repeats frame 1 and now stays in the block.
+    arena.allocate<uint8_t>(256);
+    arena.allocate<uint8_t>(128);
+    arena.allocate<uint8_t>(150);
+    CHECK_EQ(arena.heap_allocations(), 4u);
+    arena.reset();
+    CHECK_EQ(arena.capacity(), grown);
+    CHECK_EQ(arena.heap_allocations(), 4u);
+}
+
+void test_empty_arena_grows_on_first_frame() {
+    // Without an initial block the first frame lives in overflow blocks and
+    // the first reset() sizes the arena from it.
+    ScratchArena arena;
+    arena.allocate<uint8_t>(1000);
+    arena.allocate<uint8_t>(24);
+    CHECK_EQ(arena.heap_allocations(), 2u);
+    CHECK_EQ(arena.used(), 1024u + 64u);
+    arena.reset();
+    CHECK_EQ(arena.capacity(), 1408u);
+    CHECK_EQ(arena.heap_allocations(), 3u);
+
+    arena.allocate<uint8_t>(1000);
+    arena.allocate<uint8_t>(24);
+    arena.reset();
+    CHECK_EQ(arena.capacity(), 1408u);
+    CHECK_EQ(arena.heap_allocations(), 3u);
+}
+
+} // namespace
+
+int main() {
+    test_bump_and_reset();
+    test_reserve();
+    test_overflow_folds_on_reset();
+    test_empty_arena_grows_on_first_frame();
+    return spotitml::test::finish("arena_test");
+}
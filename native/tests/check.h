@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+// Minimal assertions for the native unit tests, so they need nothing beyond
+// the sources under test. A failed check reports its location and the test
+// keeps going; finish() turns the tally into the exit status CTest reads.
+
+namespace spotitml::test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void fail(const char* file, int line, const char* expression) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    ++failures();
+}
+
+inline int finish(const char* name) {
+    if (failures() != 0) {
+        std::fprintf(stderr, "%s: %d check(s) failed\n", name, failures());
+        return 1;
+    }
+    std::printf("%s: ok\n", name);
+    return 0;
+}
+
+} // namespace spotitml::test
+
+#define CHECK(condition)                                               \
+    do {                                                               \
+        if (!(condition)) {                                            \
+            ::spotitml::test::fail(__FILE__, __LINE__, #condition);    \
+        }                                                              \
+    } while (0)
+
+#define CHECK_EQ(a, b) CHECK((a) == (b))
+#define CHECK_NEAR(a, b, tolerance) CHECK(std::fabs((a) - (b)) <= (tolerance))
+
+// Expression must throw exception_type.
+#define CHECK_THROWS(expression, exception_type)                                 \
+    do {                                                                         \
+        bool thrown = false;                                                     \
+        try {                                                                    \
+            (void)(expression);                                                  \
+        } catch (const exception_type&) {                                        \
+            thrown = true;                                                       \
+        }                                                                        \
+        if (!thrown) {                                                           \
+            ::spotitml::test::fail(__FILE__, __LINE__, #expression " throws");   \
+        }                                                                        \
+    } while (0)
@@ -0,0 +1,134 @@
+// The deck model: every pair of cards shares one symbol, snap() recovers a
+// card from a noisy symbol set, and solve_deck_match() lets the deck decide
+// the shared symbol when the detector gets it wrong.
+
+#include "check.h"
+#include "deck.h"
+#include "match_solver.h"
+
+#include <vector>
+
+using namespace spotitml;
+
+namespace {
+
+// The symbols of card, lowest first.
+std::vector<int> symbols_of(int card) {
+    std::vector<int> symbols;
+    for (int s = 0; s < deck::kSymbols; ++s) {
+        if ((deck::kCardMasks[card] >> s & 1) != 0) {
+            symbols.push_back(s);
+        }
+    }
+    return symbols;
+}
+
+void test_shared_symbols() {
+    for (int a = 0; a < deck::kCards; ++a) {
+        CHECK_EQ(deck::shared_symbol(a, a), -1);
+        for (int b = a + 1; b < deck::kCards; ++b) {
+            const int s = deck::shared_symbol(a, b);
+            CHECK(s >= 0 && s < deck::kSymbols);
+            CHECK((deck::kCardMasks[a] >> s & 1) != 0 && (deck::kCardMasks[b] >> s & 1) != 0);
+            CHECK_EQ(deck::shared_symbol(b, a), s);
+        }
+    }
+    // Each symbol is on kOrder + 1 cards.
+    for (int s = 0; s < deck::kSymbols; ++s) {
+        int cards = 0;
+        for (int c = 0; c < deck::kCards; ++c) {
+            cards += static_cast<int>(deck::kCardMasks[c] >> s & 1);
+        }
+        CHECK_EQ(cards, deck::kSymbolsPerCard);
+    }
+}
+
+void test_snap() {
+    int distance = -1;
+    for (int card = 0; card < deck::kCards; ++card) {
+        CHECK_EQ(deck::snap(deck::kCardMasks[card], 0, &distance), card);
+        CHECK_EQ(distance, 0);
+    }
+
+    // Card 12 with two symbols missed and one spurious: distance 3.
+    const std::vector<int> symbols = symbols_of(12);
+    uint64_t noisy = deck::kCardMasks[12];
+    noisy &= ~(uint64_t{1} << symbols[0]);
+    noisy &= ~(uint64_t{1} << symbols[5]);
+    int spurious = 0;
+    while ((deck::kCardMasks[12] >> spurious & 1) != 0) {
+        ++spurious;
+    }
+    noisy |= uint64_t{1} << spurious;
+    CHECK_EQ(deck::snap(noisy, 3, &distance), 12);
+    CHECK_EQ(distance, 3);
+    CHECK_EQ(deck::snap(noisy, 2), -1);
+
+    // Bits above the deck are ignored, and a large max_distance is clamped
+    // to the unique-decoding radius.
+    CHECK_EQ(deck::snap(deck::kCardMasks[40] | uint64_t{1} << 60, 0), 40);
+    CHECK_EQ(deck::snap(0, 100, &distance), -1);
+    CHECK_EQ(distance, deck::kSymbolsPerCard);
+}
+
+spotitml_detection at(float cx, int32_t class_id, float score) {
+    return {cx - 2, 40, cx + 2, 44, score, class_id};
+}
+
+void test_deck_match_corrects_the_detector() {
+    const int card_a = 3;
+    const int card_b = 30;
+    const int shared = deck::shared_symbol(card_a, card_b);
+    const float region_a[4] = {0, 0, 100, 100};
+    const float region_b[4] = {100, 0, 200, 100};
+
+    // Card A is seen without the shared symbol; both cards show a spurious
+    // class 56 unless that is on the card.
+    std::vector<spotitml_detection> detections;
+    float x = 5;
+    for (int s : symbols_of(card_a)) {
+        if (s != shared) {
+            detections.push_back(at(x, s, 0.9f));
+        }
+        x += 10;
+    }
+    x = 105;
+    for (int s : symbols_of(card_b)) {
+        detections.push_back(at(x, s, 0.8f));
+        x += 10;
+    }
+    const int spurious = deck::kSymbols - 1;
+    CHECK((deck::kCardMasks[card_a] >> spurious & 1) == 0 && (deck::kCardMasks[card_b] >> spurious & 1) == 0);
+    detections.push_back(at(95, spurious, 0.99f));
+    detections.push_back(at(195, spurious, 0.99f));
+
+    SymbolSet symbols[2];
+    split_by_card(detections.data(), static_cast<int>(detections.size()), region_a, region_b, symbols);
+
+    spotitml_match match;
+    CHECK_EQ(solve_match(symbols[0], symbols[1], &match), 1);
+    CHECK_EQ(match.class_id, spurious);
+
+    CHECK_EQ(solve_deck_match(symbols[0], symbols[1], 2, &match), 1);
+    CHECK_EQ(match.deck_cards[0], card_a);
+    CHECK_EQ(match.deck_cards[1], card_b);
+    CHECK_EQ(match.class_id, shared);
+    // The side that missed it has no box for it.
+    CHECK_EQ(match.boxes[0].score, 0.0f);
+    CHECK_EQ(match.boxes[1].class_id, shared);
+    CHECK_EQ(match.boxes[1].score, 0.8f);
+
+    // Too noisy to snap: falls back to the plain intersection.
+    CHECK_EQ(solve_deck_match(symbols[0], symbols[1], 0, &match), 1);
+    CHECK_EQ(match.deck_cards[0], -1);
+    CHECK_EQ(match.class_id, spurious);
+}
+
+} // namespace
+
+int main() {
+    test_shared_symbols();
+    test_snap();
+    test_deck_match_corrects_the_detector();
+    return spotitml::test::finish("deck_test");
+}
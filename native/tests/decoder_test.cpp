@@ -0,0 +1,154 @@
+// YOLOv8 head decoding against a naive argmax reference, for the shipped
+// fixed geometries and a runtime one whose anchors end mid-tile, with and
+// without a class allow-list.
+
+#include "check.h"
+#include "decoder.h"
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace spotitml;
+
+namespace {
+
+constexpr float kThreshold = 0.5f;
+
+static_assert(kYolov8nCoco.anchors == 8400, "");
+static_assert(kDobbleModel.classes == 57, "");
+
+// [4 + classes, anchors] with random boxes and sparse high scores.
+std::vector<float> make_output(int classes, int anchors, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<float> output(static_cast<size_t>(4 + classes) * anchors);
+    for (int a = 0; a < anchors; ++a) {
+        output[a] = unit(rng) * 640;
+        output[anchors + a] = unit(rng) * 640;
+        output[2 * anchors + a] = 10 + unit(rng) * 50;
+        output[3 * anchors + a] = 10 + unit(rng) * 50;
+    }
+    for (size_t i = 4 * static_cast<size_t>(anchors); i < output.size(); ++i) {
+        const float u = unit(rng);
+        output[i] = u * u * u;
+    }
+    return output;
+}
+
+// Best wanted class per anchor (first wins ties) above the threshold.
+std::vector<Candidate> reference(const std::vector<float>& output, int classes, int anchors,
+                                 const std::vector<int32_t>& wanted) {
+    std::vector<Candidate> candidates;
+    for (int a = 0; a < anchors; ++a) {
+        float best = -1.0f;
+        int32_t best_class = -1;
+        for (int c = 0; c < classes; ++c) {
+            if (!wanted.empty() && std::find(wanted.begin(), wanted.end(), c) == wanted.end()) {
+                continue;
+            }
+            const float score = output[static_cast<size_t>(4 + c) * anchors + a];
+            if (score > best) {
+                best = score;
+                best_class = c;
+            }
+        }
+        if (best_class < 0 || best < kThreshold) {
+            continue;
+        }
+        const float cx = output[a], cy = output[anchors + a];
+        const float w = output[2 * anchors + a], h = output[3 * anchors + a];
+        candidates.push_back({cx - 0.5f * w, cy - 0.5f * h, cx + 0.5f * w, cy + 0.5f * h, best, best_class});
+    }
+    return candidates;
+}
+
+bool same(const Decoder& decoder, const std::vector<Candidate>& expected) {
+    if (decoder.count() != static_cast<int>(expected.size())) {
+        return false;
+    }
+    for (int i = 0; i < decoder.count(); ++i) {
+        const Candidate& a = decoder.candidates()[i];
+        const Candidate& b = expected[i];
+        if (a.class_id != b.class_id || a.score != b.score || a.x1 != b.x1 || a.y1 != b.y1 || a.x2 != b.x2 ||
+            a.y2 != b.y2) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void check_geometry(int classes, int anchors) {
+    const std::vector<float> output = make_output(classes, anchors, static_cast<unsigned>(classes * 31 + anchors));
+    Decoder decoder(anchors);
+
+    decoder.decode(output.data(), 4 + classes, anchors, kThreshold);
+    CHECK(same(decoder, reference(output, classes, anchors, {})));
+    CHECK_EQ(decoder.overflow(), 0);
+
+    // Unsorted, duplicated and out-of-range ids are tolerated.
+    const std::vector<int32_t> wanted = {16, 0, 15, 14, 0, -3, classes + 7};
+    decoder.set_classes(wanted.data(), static_cast<int>(wanted.size()));
+    CHECK_EQ(decoder.classes().size(), 5u);
+    decoder.decode(output.data(), 4 + classes, anchors, kThreshold);
+    CHECK(same(decoder, reference(output, classes, anchors, {0, 14, 15, 16})));
+    for (int i = 0; i < decoder.count(); ++i) {
+        const int32_t c = decoder.candidates()[i].class_id;
+        CHECK(c == 0 || c == 14 || c == 15 || c == 16);
+    }
+
+    // A single wanted class.
+    const int32_t one = classes - 1;
+    decoder.set_classes(&one, 1);
+    decoder.decode(output.data(), 4 + classes, anchors, kThreshold);
+    CHECK(same(decoder, reference(output, classes, anchors, {one})));
+
+    // Nothing the model has: nothing decoded. Clearing restores every class.
+    const int32_t missing = classes;
+    decoder.set_classes(&missing, 1);
+    CHECK_EQ(decoder.decode(output.data(), 4 + classes, anchors, kThreshold), 0);
+    decoder.set_classes(nullptr, 0);
+    decoder.decode(output.data(), 4 + classes, anchors, kThreshold);
+    CHECK(same(decoder, reference(output, classes, anchors, {})));
+}
+
+void test_shipped_geometries() {
+    check_geometry(kYolov8nCoco.classes, kYolov8nCoco.anchors);
+    check_geometry(kDobbleModel.classes, kDobbleModel.anchors);
+}
+
+void test_runtime_geometry() {
+    check_geometry(23, 1000);
+    check_geometry(20, yolov8_anchors(320));
+}
+
+void test_capacity_overflow() {
+    const int classes = 5;
+    const int anchors = 700;
+    std::vector<float> output(static_cast<size_t>(4 + classes) * anchors, 0.9f);
+    Decoder decoder(100);
+    CHECK_EQ(decoder.decode(output.data(), 4 + classes, anchors, kThreshold), 100);
+    CHECK_EQ(decoder.overflow(), anchors - 100);
+
+    CHECK_THROWS(decoder.decode(nullptr, 4 + classes, anchors, kThreshold), std::invalid_argument);
+    CHECK_THROWS(decoder.decode(output.data(), 4, anchors, kThreshold), std::invalid_argument);
+}
+
+void test_generation() {
+    Decoder decoder;
+    CHECK_EQ(decoder.classes_generation(), 0u);
+    const int32_t ids[] = {2};
+    decoder.set_classes(ids, 1, 7);
+    CHECK_EQ(decoder.classes_generation(), 7u);
+}
+
+} // namespace
+
+int main() {
+    test_shipped_geometries();
+    test_runtime_geometry();
+    test_capacity_overflow();
+    test_generation();
+    return spotitml::test::finish("decoder_test");
+}
@@ -0,0 +1,221 @@
+// Embedding table loading and nearest-row lookup against a scalar cosine
+// reference, for float32 and int8 tables, dims that do and do not fill
+// whole SIMD vectors, and malformed files.
+
+#include "check.h"
+#include "embedding_index.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace spotitml;
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct Table {
+    int dim = 0;
+    bool quantized = false;
+    std::vector<int32_t> class_ids;
+    std::vector<float> rows;  // as stored: int8 values held as floats
+};
+
+void put_u32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+std::vector<uint8_t> serialize(const Table& table) {
+    std::vector<uint8_t> out = {'S', 'P', 'E', 'M'};
+    put_u32(out, 1);
+    put_u32(out, static_cast<uint32_t>(table.dim));
+    put_u32(out, static_cast<uint32_t>(table.class_ids.size()));
+    put_u32(out, table.quantized ? 1 : 0);
+    put_u32(out, 0);
+    for (int32_t id : table.class_ids) {
+        put_u32(out, static_cast<uint32_t>(id));
+    }
+    for (float value : table.rows) {
+        if (table.quantized) {
+            out.push_back(static_cast<uint8_t>(static_cast<int8_t>(value)));
+        } else {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            put_u32(out, bits);
+        }
+    }
+    return out;
+}
+
+std::string write_file(const std::string& name, const std::vector<uint8_t>& bytes) {
+    const std::string path = (fs::temp_directory_path() / ("spotitml_" + name + ".spem")).string();
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    CHECK(file != nullptr);
+    if (file != nullptr) {
+        std::fwrite(bytes.data(), 1, bytes.size(), file);
+        std::fclose(file);
+    }
+    return path;
+}
+
+Table make_table(int dim, int count, bool quantized, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    Table table;
+    table.dim = dim;
+    table.quantized = quantized;
+    for (int r = 0; r < count; ++r) {
+        // Pairs of rows share a class, like two renderings of one symbol.
+        table.class_ids.push_back(100 + r / 2);
+        for (int j = 0; j < dim; ++j) {
+            const float value = normal(rng);
+            table.rows.push_back(quantized ? std::round(std::fmax(-127.0f, std::fmin(127.0f, value * 40.0f)))
+                                           : value);
+        }
+    }
+    return table;
+}
+
+// Best row by double-precision cosine similarity.
+int reference_nearest(const Table& table, const std::vector<float>& query, double& similarity) {
+    const int count = static_cast<int>(table.class_ids.size());
+    double query_norm = 0.0;
+    for (float q : query) {
+        query_norm += static_cast<double>(q) * q;
+    }
+    int best = -1;
+    similarity = -2.0;
+    for (int r = 0; r < count; ++r) {
+        double dot = 0.0, norm = 0.0;
+        for (int j = 0; j < table.dim; ++j) {
+            const double v = table.rows[static_cast<size_t>(r) * table.dim + j];
+            dot += v * query[j];
+            norm += v * v;
+        }
+        const double s = dot / std::sqrt(norm * query_norm);
+        if (s > similarity) {
+            similarity = s;
+            best = r;
+        }
+    }
+    return best;
+}
+
+// Queries are noisy, rescaled copies of rows, so the nearest row is clear
+// while the similarity is well below 1.
+void check_table(const std::string& name, int dim, bool quantized) {
+    const int count = 40;
+    const Table table = make_table(dim, count, quantized, static_cast<unsigned>(dim * 7 + quantized));
+    const std::string path = write_file(name, serialize(table));
+    EmbeddingIndex index(path.c_str());
+    CHECK_EQ(index.dim(), dim);
+    CHECK_EQ(index.rows(), count);
+    CHECK_EQ(index.quantized(), quantized);
+    CHECK(!index.empty());
+
+    // int8 queries lose up to half a step of 127 per element.
+    const float tolerance = quantized ? 0.02f : 1e-4f;
+    std::mt19937 rng(static_cast<unsigned>(dim));
+    std::normal_distribution<float> noise(0.0f, 0.3f);
+    for (int r = 0; r < count; ++r) {
+        std::vector<float> query(dim);
+        for (int j = 0; j < dim; ++j) {
+            const float row = table.rows[static_cast<size_t>(r) * dim + j] / (quantized ? 40.0f : 1.0f);
+            query[j] = 3.5f * (row + noise(rng));
+        }
+        double expected_similarity;
+        const int expected = reference_nearest(table, query, expected_similarity);
+        CHECK_EQ(expected, r);
+
+        float similarity = 0.0f;
+        CHECK_EQ(index.nearest(query.data(), &similarity), table.class_ids[expected]);
+        CHECK_NEAR(similarity, static_cast<float>(expected_similarity), tolerance);
+    }
+
+    // An exact row is its own nearest neighbor at similarity 1.
+    const std::vector<float> row(table.rows.begin() + 5 * dim, table.rows.begin() + 6 * dim);
+    float similarity = 0.0f;
+    CHECK_EQ(index.nearest(row.data(), &similarity), table.class_ids[5]);
+    CHECK_NEAR(similarity, 1.0f, quantized ? 0.01f : 1e-5f);
+
+    fs::remove(path);
+}
+
+void test_float32() {
+    check_table("float32_64", 64, false);
+    // Not a multiple of 16: rows are zero padded to whole vectors.
+    check_table("float32_50", 50, false);
+    check_table("float32_20", 20, false);
+}
+
+void test_int8() {
+    check_table("int8_128", 128, true);
+    // Not a multiple of 64 bytes.
+    check_table("int8_50", 50, true);
+    check_table("int8_20", 20, true);
+}
+
+void test_empty_table() {
+    Table table;
+    table.dim = 8;
+    const std::string path = write_file("empty", serialize(table));
+    EmbeddingIndex index(path.c_str());
+    CHECK(index.empty());
+    const float query[8] = {1, 0, 0, 0, 0, 0, 0, 0};
+    float similarity = 1.0f;
+    CHECK_EQ(index.nearest(query, &similarity), -1);
+    CHECK_EQ(similarity, 0.0f);
+    fs::remove(path);
+}
+
+void test_rejects_malformed_tables() {
+    const std::vector<uint8_t> good = serialize(make_table(20, 4, false, 1));
+
+    std::vector<uint8_t> truncated(good.begin(), good.end() - 1);
+    std::string path = write_file("truncated", truncated);
+    CHECK_THROWS(EmbeddingIndex(path.c_str()), std::runtime_error);
+
+    std::vector<uint8_t> long_file = good;
+    long_file.push_back(0);
+    path = write_file("trailing", long_file);
+    CHECK_THROWS(EmbeddingIndex(path.c_str()), std::runtime_error);
+
+    std::vector<uint8_t> bad_magic = good;
+    bad_magic[3] = 'X';
+    path = write_file("bad_magic", bad_magic);
+    CHECK_THROWS(EmbeddingIndex(path.c_str()), std::runtime_error);
+
+    std::vector<uint8_t> bad_version = good;
+    bad_version[4] = 2;
+    path = write_file("bad_version", bad_version);
+    CHECK_THROWS(EmbeddingIndex(path.c_str()), std::runtime_error);
+
+    std::vector<uint8_t> header_only(good.begin(), good.begin() + 10);
+    path = write_file("header_only", header_only);
+    CHECK_THROWS(EmbeddingIndex(path.c_str()), std::runtime_error);
+
+    for (const char* name : {"truncated", "trailing", "bad_magic", "bad_version", "header_only"}) {
+        fs::remove(fs::temp_directory_path() / (std::string("spotitml_") + name + ".spem"));
+    }
+
+    CHECK_THROWS(EmbeddingIndex("/nonexistent/spotitml_table.spem"), std::runtime_error);
+}
+
+} // namespace
+
+int main() {
+    test_float32();
+    test_int8();
+    test_empty_table();
+    test_rejects_malformed_tables();
+    return spotitml::test::finish("embedding_index_test");
+}
@@ -0,0 +1,112 @@
+// Match solving between two cards: card assignment by box center, and the
+// shared class with the best score product when the detector reports more
+// than one.
+
+#include "check.h"
+#include "match_solver.h"
+
+#include <vector>
+
+using namespace spotitml;
+
+namespace {
+
+const float kCardA[4] = {0, 0, 100, 100};
+const float kCardB[4] = {80, 0, 200, 100};
+
+spotitml_detection symbol(float cx, float cy, int32_t class_id, float score) {
+    return {cx - 5, cy - 5, cx + 5, cy + 5, score, class_id};
+}
+
+void test_split_by_card() {
+    const std::vector<spotitml_detection> detections = {
+        symbol(20, 50, 1, 0.9f),   // card A only
+        symbol(150, 50, 2, 0.9f),  // card B only
+        symbol(85, 50, 3, 0.9f),   // both; 35 from A's center, 55 from B's
+        symbol(95, 50, 4, 0.9f),   // both; equally far, A wins the tie
+        symbol(250, 50, 5, 0.9f),  // neither
+    };
+    CHECK_EQ(assign_card(detections[0], kCardA, kCardB), 0);
+    CHECK_EQ(assign_card(detections[1], kCardA, kCardB), 1);
+    CHECK_EQ(assign_card(detections[2], kCardA, kCardB), 0);
+    CHECK_EQ(assign_card(detections[3], kCardA, kCardB), 0);
+    CHECK_EQ(assign_card(detections[4], kCardA, kCardB), -1);
+
+    SymbolSet symbols[2];
+    split_by_card(detections.data(), static_cast<int>(detections.size()), kCardA, kCardB, symbols);
+    CHECK_EQ(symbols[0].count(), 3);
+    CHECK_EQ(symbols[1].count(), 1);
+    CHECK(symbols[0].contains(1) && symbols[0].contains(3) && symbols[0].contains(4));
+    CHECK(symbols[1].contains(2));
+}
+
+void test_single_shared_symbol() {
+    const std::vector<spotitml_detection> detections = {
+        symbol(20, 20, 7, 0.8f), symbol(40, 40, 9, 0.7f), symbol(20, 60, 9, 0.95f),  // card A, 9 twice
+        symbol(150, 20, 9, 0.6f), symbol(170, 60, 11, 0.9f),                           // card B
+    };
+    SymbolSet symbols[2];
+    split_by_card(detections.data(), static_cast<int>(detections.size()), kCardA, kCardB, symbols);
+    spotitml_match match;
+    CHECK_EQ(solve_match(symbols[0], symbols[1], &match), 1);
+    CHECK_EQ(match.class_id, 9);
+    CHECK_EQ(match.shared_count, 1);
+    CHECK_EQ(match.card_counts[0], 2);
+    CHECK_EQ(match.card_counts[1], 2);
+    // The best box of the class on each card.
+    CHECK_EQ(match.boxes[0].score, 0.95f);
+    CHECK_EQ(match.boxes[1].score, 0.6f);
+    CHECK_NEAR(match.score, 0.95f * 0.6f, 1e-6f);
+    CHECK_EQ(match.deck_cards[0], -1);
+}
+
+void test_tie_break_by_score_product() {
+    // Classes 3, 70 and 100 appear on both cards (70 and 100 in the second
+    // bitset word); 70 has the best product.
+    const std::vector<spotitml_detection> detections = {
+        symbol(10, 10, 3, 0.9f),   symbol(30, 10, 70, 0.8f),  symbol(50, 10, 100, 0.99f),
+        symbol(150, 10, 3, 0.5f),  symbol(170, 10, 70, 0.9f), symbol(190, 10, 100, 0.6f),
+    };
+    SymbolSet symbols[2];
+    split_by_card(detections.data(), static_cast<int>(detections.size()), kCardA, kCardB, symbols);
+    spotitml_match match;
+    CHECK_EQ(solve_match(symbols[0], symbols[1], &match), 1);
+    CHECK_EQ(match.shared_count, 3);
+    CHECK_EQ(match.class_id, 70);
+    CHECK_NEAR(match.score, 0.72f, 1e-6f);
+
+    // Equal products: the lowest class id wins.
+    const std::vector<spotitml_detection> tied = {
+        symbol(10, 10, 12, 0.5f), symbol(30, 10, 5, 0.5f),
+        symbol(150, 10, 12, 0.5f), symbol(170, 10, 5, 0.5f),
+    };
+    SymbolSet tied_symbols[2];
+    split_by_card(tied.data(), static_cast<int>(tied.size()), kCardA, kCardB, tied_symbols);
+    CHECK_EQ(solve_match(tied_symbols[0], tied_symbols[1], &match), 1);
+    CHECK_EQ(match.class_id, 5);
+}
+
+void test_no_shared_symbol() {
+    const std::vector<spotitml_detection> detections = {
+        symbol(10, 10, 1, 0.9f), symbol(150, 10, 2, 0.9f),
+        symbol(30, 10, SymbolSet::kMaxSymbols, 0.9f), symbol(170, 10, SymbolSet::kMaxSymbols, 0.9f),  // ignored
+    };
+    SymbolSet symbols[2];
+    split_by_card(detections.data(), static_cast<int>(detections.size()), kCardA, kCardB, symbols);
+    spotitml_match match;
+    CHECK_EQ(solve_match(symbols[0], symbols[1], &match), 0);
+    CHECK_EQ(match.class_id, -1);
+    CHECK_EQ(match.shared_count, 0);
+    CHECK_EQ(match.score, 0.0f);
+    CHECK_EQ(match.card_counts[0], 1);
+}
+
+} // namespace
+
+int main() {
+    test_split_by_card();
+    test_single_shared_symbol();
+    test_tie_break_by_score_product();
+    test_no_shared_symbol();
+    return spotitml::test::finish("match_solver_test");
+}
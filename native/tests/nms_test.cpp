@@ -0,0 +1,79 @@
+// Greedy NMS: same-class overlaps are suppressed, other classes never are,
+// and the candidate and detection caps hold.
+
+#include "check.h"
+#include "nms.h"
+
+#include <vector>
+
+using namespace spotitml;
+
+namespace {
+
+Candidate box(float x, float y, float size, float score, int32_t class_id) {
+    return {x, y, x + size, y + size, score, class_id};
+}
+
+void test_same_class_overlap_is_suppressed() {
+    const std::vector<Candidate> candidates = {
+        box(10, 10, 100, 0.6f, 3),
+        box(12, 12, 100, 0.9f, 3),   // best, overlaps the first
+        box(300, 300, 50, 0.5f, 3),  // apart
+    };
+    Nms nms;
+    CHECK_EQ(nms.run(candidates.data(), 3, 0.5f), 2);
+    CHECK_EQ(nms.detections()[0].score, 0.9f);
+    CHECK_EQ(nms.detections()[1].score, 0.5f);
+}
+
+void test_other_classes_are_kept() {
+    // Identical boxes, every class its own; many candidates so the SIMD
+    // sweep runs over whole vectors as well as the tail.
+    std::vector<Candidate> candidates;
+    for (int c = 0; c < 19; ++c) {
+        candidates.push_back(box(200, 200, 80, 0.9f - c * 0.01f, c));
+    }
+    Nms nms;
+    CHECK_EQ(nms.run(candidates.data(), static_cast<int>(candidates.size()), 0.5f), 19);
+    for (int i = 0; i < 19; ++i) {
+        CHECK_EQ(nms.detections()[i].class_id, i);
+    }
+    // Class-agnostic keeps only the best of them.
+    CHECK_EQ(nms.run(candidates.data(), static_cast<int>(candidates.size()), 0.5f, true), 1);
+    CHECK_EQ(nms.detections()[0].class_id, 0);
+}
+
+void test_iou_threshold() {
+    // Boxes [0, 100] and [50, 150] in x, same y: IoU 1/3.
+    const std::vector<Candidate> candidates = {{0, 0, 100, 100, 0.9f, 0}, {50, 0, 150, 100, 0.8f, 0}};
+    Nms nms;
+    CHECK_EQ(nms.run(candidates.data(), 2, 0.34f), 2);
+    CHECK_EQ(nms.run(candidates.data(), 2, 0.33f), 1);
+}
+
+void test_caps() {
+    std::vector<Candidate> candidates;
+    for (int i = 0; i < 50; ++i) {
+        candidates.push_back(box(i * 20.0f, 0, 10, 0.01f * (i + 1), 0));
+    }
+    // Only the 8 best candidates are considered, and 5 are returned.
+    Nms nms(8, 5);
+    CHECK_EQ(nms.run(candidates.data(), static_cast<int>(candidates.size()), 0.5f), 5);
+    for (int i = 0; i < 5; ++i) {
+        CHECK_NEAR(nms.detections()[i].score, 0.01f * (50 - i), 1e-6f);
+    }
+
+    Nms candidate_capped(3, 100);
+    CHECK_EQ(candidate_capped.run(candidates.data(), static_cast<int>(candidates.size()), 0.5f), 3);
+    CHECK_EQ(candidate_capped.run(nullptr, 0, 0.5f), 0);
+}
+
+} // namespace
+
+int main() {
+    test_same_class_overlap_is_suppressed();
+    test_other_classes_are_kept();
+    test_iou_threshold();
+    test_caps();
+    return spotitml::test::finish("nms_test");
+}
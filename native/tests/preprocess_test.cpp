@@ -0,0 +1,187 @@
+// Fused letterbox against a straightforward reference: bilinear resize with
+// half-pixel centers, 114 gray padding, [0, 1] and NCHW.
+
+#include "check.h"
+#include "preprocess.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using namespace spotitml;
+
+namespace {
+
+constexpr float kTolerance = 1e-5f;
+
+void taps(int i, int n_src, int n_dst, int& i0, int& i1, float& w1) {
+    const float f = std::max(0.0f, (i + 0.5f) * n_src / n_dst - 0.5f);
+    i0 = std::min(static_cast<int>(f), n_src - 1);
+    i1 = std::min(i0 + 1, n_src - 1);
+    w1 = f - i0;
+}
+
+// channel(x, y, c) in 0..255; returns the [3, size, size] tensor.
+template <typename Channel>
+std::vector<float> reference(int width, int height, int size, Channel channel) {
+    const Letterbox box = compute_letterbox(width, height, size, size);
+    std::vector<float> out(3 * static_cast<size_t>(size) * size, Preprocessor::kPadValue);
+    for (int y = 0; y < box.resized_height; ++y) {
+        int y0, y1;
+        float wy;
+        taps(y, height, box.resized_height, y0, y1, wy);
+        for (int x = 0; x < box.resized_width; ++x) {
+            int x0, x1;
+            float wx;
+            taps(x, width, box.resized_width, x0, x1, wx);
+            for (int c = 0; c < 3; ++c) {
+                const float top = channel(x0, y0, c) * (1 - wx) + channel(x1, y0, c) * wx;
+                const float bottom = channel(x0, y1, c) * (1 - wx) + channel(x1, y1, c) * wx;
+                out[(static_cast<size_t>(c) * size + box.pad_y + y) * size + box.pad_x + x] =
+                    (top + (bottom - top) * wy) / 255.0f;
+            }
+        }
+    }
+    return out;
+}
+
+float max_difference(const std::vector<float>& a, const std::vector<float>& b) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i) {
+        worst = std::max(worst, std::fabs(a[i] - b[i]));
+    }
+    return worst;
+}
+
+uint8_t pattern(int x, int y, int c) {
+    return static_cast<uint8_t>((x * 37 + y * 11 + c * 71 + x * y) & 0xff);
+}
+
+void test_rgb_matches_reference() {
+    const int width = 37;
+    const int height = 23;
+    const int stride = width * 3 + 5;  // padded rows
+    std::vector<uint8_t> rgb(static_cast<size_t>(stride) * height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            for (int c = 0; c < 3; ++c) {
+                rgb[y * stride + 3 * x + c] = pattern(x, y, c);
+            }
+        }
+    }
+
+    for (int size : {16, 32, 64}) {
+        Preprocessor preprocessor;
+        std::vector<float> out(3 * static_cast<size_t>(size) * size);
+        const Letterbox box = preprocessor.letterbox_rgb(rgb.data(), width, height, stride, out.data(), size, size);
+        CHECK_EQ(box.resized_width, size);
+        CHECK(box.pad_y > 0);
+        const auto expected =
+            reference(width, height, size, [&](int x, int y, int c) { return static_cast<float>(pattern(x, y, c)); });
+        CHECK(max_difference(out, expected) <= kTolerance);
+    }
+}
+
+void test_bgra_swaps_channels() {
+    const int width = 20;
+    const int height = 30;
+    std::vector<uint8_t> bgra(static_cast<size_t>(width) * height * 4);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t* p = &bgra[(y * width + x) * 4];
+            p[0] = pattern(x, y, 2);
+            p[1] = pattern(x, y, 1);
+            p[2] = pattern(x, y, 0);
+            p[3] = 255;
+        }
+    }
+    spotitml_frame frame{};
+    frame.format = SPOTITML_FORMAT_BGRA;
+    frame.width = width;
+    frame.height = height;
+    frame.planes[0] = bgra.data();
+    frame.row_strides[0] = width * 4;
+
+    const int size = 24;
+    Preprocessor preprocessor;
+    std::vector<float> out(3 * size * size);
+    preprocessor.letterbox(frame, out.data(), size, size);
+    const auto expected =
+        reference(width, height, size, [&](int x, int y, int c) { return static_cast<float>(pattern(x, y, c)); });
+    CHECK(max_difference(out, expected) <= kTolerance);
+}
+
+// Neutral chroma makes the YUV path a plain resize of the luma into all
+// three channels.
+void test_gray_yuv420_matches_luma() {
+    const int width = 32;
+    const int height = 18;
+    std::vector<uint8_t> luma(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            luma[y * width + x] = pattern(x, y, 0);
+        }
+    }
+    std::vector<uint8_t> chroma(static_cast<size_t>(width / 2) * (height / 2), 128);
+    spotitml_frame frame{};
+    frame.format = SPOTITML_FORMAT_YUV420;
+    frame.width = width;
+    frame.height = height;
+    frame.planes[0] = luma.data();
+    frame.planes[1] = chroma.data();
+    frame.planes[2] = chroma.data();
+    frame.row_strides[0] = width;
+    frame.row_strides[1] = frame.row_strides[2] = width / 2;
+
+    const int size = 40;
+    Preprocessor preprocessor;
+    std::vector<float> out(3 * size * size);
+    preprocessor.letterbox(frame, out.data(), size, size);
+    const auto expected =
+        reference(width, height, size, [&](int x, int y, int) { return static_cast<float>(luma[y * width + x]); });
+    CHECK(max_difference(out, expected) <= 1e-4f);
+}
+
+void test_short_strides_are_rejected() {
+    const int width = 16;
+    const int height = 8;
+    std::vector<uint8_t> plane(static_cast<size_t>(width) * height * 2);
+    std::vector<float> out(3 * 16 * 16);
+    Preprocessor preprocessor;
+
+    spotitml_frame frame{};
+    frame.format = SPOTITML_FORMAT_YUV420;
+    frame.width = width;
+    frame.height = height;
+    frame.planes[0] = frame.planes[1] = frame.planes[2] = plane.data();
+    frame.row_strides[0] = width;
+    frame.row_strides[1] = frame.row_strides[2] = width / 2;
+    preprocessor.letterbox(frame, out.data(), 16, 16);
+
+    frame.row_strides[2] = width / 2 - 1;
+    CHECK_THROWS(preprocessor.letterbox(frame, out.data(), 16, 16), std::invalid_argument);
+    // Android's interleaved YUV_420_888 chroma needs twice the bytes per row.
+    frame.row_strides[2] = width / 2;
+    frame.pixel_strides[1] = frame.pixel_strides[2] = 2;
+    CHECK_THROWS(preprocessor.letterbox(frame, out.data(), 16, 16), std::invalid_argument);
+
+    spotitml_frame nv21{};
+    nv21.format = SPOTITML_FORMAT_NV21;
+    nv21.width = width;
+    nv21.height = height;
+    nv21.planes[0] = nv21.planes[1] = plane.data();
+    nv21.row_strides[0] = width;
+    nv21.row_strides[1] = width - 2;
+    CHECK_THROWS(preprocessor.letterbox(nv21, out.data(), 16, 16), std::invalid_argument);
+}
+
+} // namespace
+
+int main() {
+    test_rgb_matches_reference();
+    test_bgra_swaps_channels();
+    test_gray_yuv420_matches_luma();
+    test_short_strides_are_rejected();
+    return spotitml::test::finish("preprocess_test");
+}
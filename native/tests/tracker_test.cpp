@@ -0,0 +1,166 @@
+// Track association: ids persist across frames, survive short misses, and
+// are never handed to another symbol; the keyframe scheduler fires on
+// interval and on motion.
+
+#include "check.h"
+#include "tracker.h"
+
+#include <vector>
+
+using namespace spotitml;
+
+namespace {
+
+spotitml_tracking_options options() {
+    spotitml_tracking_options o{};
+    o.keyframe_interval = 5;
+    o.motion_threshold = 6.0f;
+    o.iou_threshold = 0.3f;
+    o.max_missed = 2;
+    return o;
+}
+
+spotitml_detection box(float x, float y, float size, int32_t class_id, float score = 0.9f) {
+    return {x, y, x + size, y + size, score, class_id};
+}
+
+// Track id of the track whose class is class_id, or -1.
+int32_t id_of(const Tracker& tracker, int32_t class_id) {
+    std::vector<spotitml_track> tracks(Tracker::kMaxTracks);
+    const int n = tracker.tracks(tracks.data(), Tracker::kMaxTracks);
+    for (int i = 0; i < n; ++i) {
+        if (tracks[i].detection.class_id == class_id) {
+            return tracks[i].track_id;
+        }
+    }
+    return -1;
+}
+
+void test_ids_continue_across_frames() {
+    Tracker tracker(options());
+    const spotitml_detection first[] = {box(100, 100, 50, 1), box(300, 100, 50, 2)};
+    CHECK_EQ(tracker.update(first, 2, 0), 2);
+    const int32_t a = id_of(tracker, 1);
+    const int32_t b = id_of(tracker, 2);
+    CHECK(a > 0 && b > 0 && a != b);
+
+    // Both moved a little; listed in the other order.
+    const spotitml_detection second[] = {box(306, 104, 50, 2), box(104, 98, 50, 1)};
+    CHECK_EQ(tracker.update(second, 2, 1), 2);
+    CHECK_EQ(id_of(tracker, 1), a);
+    CHECK_EQ(id_of(tracker, 2), b);
+
+    spotitml_track tracks[2];
+    CHECK_EQ(tracker.tracks(tracks, 2), 2);
+    CHECK_EQ(tracks[0].hits, 2);
+    CHECK_EQ(tracks[0].detected, 1);
+}
+
+void test_class_must_match() {
+    Tracker tracker(options());
+    const spotitml_detection first[] = {box(100, 100, 50, 1)};
+    tracker.update(first, 1, 0);
+    const int32_t a = id_of(tracker, 1);
+    // Same place, other symbol: a new track, the old one ages.
+    const spotitml_detection second[] = {box(100, 100, 50, 7)};
+    CHECK_EQ(tracker.update(second, 1, 1), 2);
+    CHECK_EQ(id_of(tracker, 1), a);
+    CHECK(id_of(tracker, 7) != a);
+}
+
+void test_fast_move_continues_by_center_distance() {
+    Tracker tracker(options());
+    const spotitml_detection first[] = {box(100, 100, 60, 4)};
+    tracker.update(first, 1, 0);
+    const int32_t a = id_of(tracker, 4);
+    // IoU 0.26, below the threshold, but the center is within the gate.
+    const spotitml_detection second[] = {box(135, 100, 60, 4)};
+    CHECK_EQ(tracker.update(second, 1, 1), 1);
+    CHECK_EQ(id_of(tracker, 4), a);
+}
+
+void test_misses_and_expiry() {
+    Tracker tracker(options());
+    const spotitml_detection seen[] = {box(100, 100, 50, 3)};
+    tracker.update(seen, 1, 0);
+    const int32_t a = id_of(tracker, 3);
+
+    // Survives max_missed detector runs without it.
+    CHECK_EQ(tracker.update(nullptr, 0, 1), 1);
+    CHECK_EQ(tracker.update(nullptr, 0, 2), 1);
+    CHECK_EQ(tracker.update(seen, 1, 3), 1);
+    CHECK_EQ(id_of(tracker, 3), a);
+
+    for (int64_t frame = 4; frame < 7; ++frame) {
+        tracker.update(nullptr, 0, frame);
+    }
+    CHECK_EQ(tracker.count(), 0);
+    // A returning symbol gets a fresh id; ids are never reused.
+    tracker.update(seen, 1, 7);
+    CHECK(id_of(tracker, 3) > a);
+}
+
+void test_predict_follows_velocity() {
+    Tracker tracker(options());
+    for (int frame = 0; frame < 4; ++frame) {
+        const spotitml_detection d[] = {box(100.0f + 10.0f * frame, 100, 50, 5)};
+        tracker.update(d, 1, frame);
+    }
+    spotitml_track before;
+    tracker.tracks(&before, 1);
+    CHECK_EQ(tracker.predict(4), 1);
+    spotitml_track after;
+    tracker.tracks(&after, 1);
+    CHECK(after.detection.x1 > before.detection.x1);
+    CHECK_EQ(after.detected, 0);
+    CHECK_EQ(after.track_id, before.track_id);
+}
+
+void test_detections_beyond_cap_are_ignored() {
+    Tracker tracker(options());
+    std::vector<spotitml_detection> detections;
+    for (int i = 0; i < Tracker::kMaxDetections + 20; ++i) {
+        detections.push_back(box(60.0f * (i % 20), 60.0f * (i / 20), 50, i % 50));
+    }
+    const int count = static_cast<int>(detections.size());
+    CHECK_EQ(tracker.update(detections.data(), count, 0), Tracker::kMaxDetections);
+    CHECK_EQ(tracker.update(detections.data(), count, 1), Tracker::kMaxDetections);
+}
+
+void test_keyframes() {
+    const int width = 64;
+    const int height = 48;
+    std::vector<uint8_t> luma(width * height, 80);
+    spotitml_frame frame{};
+    frame.format = SPOTITML_FORMAT_NV21;
+    frame.width = width;
+    frame.height = height;
+    frame.planes[0] = luma.data();
+    frame.row_strides[0] = width;
+
+    KeyframeScheduler scheduler(options());
+    CHECK(scheduler.needs_detection(frame));
+    // A still picture runs the detector once per interval.
+    int runs = 0;
+    for (int i = 0; i < 10; ++i) {
+        runs += scheduler.needs_detection(frame) ? 1 : 0;
+    }
+    CHECK_EQ(runs, 2);
+
+    std::fill(luma.begin(), luma.end(), 160);
+    CHECK(scheduler.needs_detection(frame));
+    CHECK(!scheduler.needs_detection(frame));
+}
+
+} // namespace
+
+int main() {
+    test_ids_continue_across_frames();
+    test_class_must_match();
+    test_fast_move_continues_by_center_distance();
+    test_misses_and_expiry();
+    test_predict_follows_velocity();
+    test_detections_beyond_cap_are_ignored();
+    test_keyframes();
+    return spotitml::test::finish("tracker_test");
+}
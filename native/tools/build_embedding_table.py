@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""Writes the symbol embedding table read by the native SymbolClassifier.
+
+Host-side only:
+
+    python3 native/tools/build_embedding_table.py \
+        --model assets/models/symbol_embedder.onnx \
+        --symbols-dir ~/dobble_symbols \
+        --output assets/models/dobble_symbols.spem
+
+The symbols directory holds one subdirectory per symbol, named
+`<class_id>` or `<class_id>_<name>` (e.g. `17_anchor`), with a few crops of
+that symbol. Crops are preprocessed exactly like the native letterbox
+(bilinear resize, 114 gray padding, RGB, [0, 1], NCHW) and embedded; with
+--per-image every crop becomes a row, otherwise each symbol gets one row,
+the normalized mean of its crops. --int8 stores the rows as int8, a quarter
+of the size, which the native search reads with integer dot products.
+
+The format is documented in native/src/embedding_index.h.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+import numpy as np
+import onnxruntime as ort
+from PIL import Image
+
+IMAGE_EXTENSIONS = ('.jpg', '.jpeg', '.png', '.bmp', '.webp')
+PAD_VALUE = 114
+MAGIC = b'SPEM'
+VERSION = 1
+FLOAT32 = 0
+INT8 = 1
+
+
+def letterbox(path, size):
+    image = Image.open(path).convert('RGB')
+    scale = min(size / image.width, size / image.height)
+    width = max(1, round(image.width * scale))
+    height = max(1, round(image.height * scale))
+    canvas = Image.new('RGB', (size, size), (PAD_VALUE, PAD_VALUE, PAD_VALUE))
+    canvas.paste(image.resize((width, height), Image.BILINEAR), ((size - width) // 2, (size - height) // 2))
+    return (np.asarray(canvas, dtype=np.float32) / 255.0).transpose(2, 0, 1)
+
+
+def list_symbols(directory):
+    symbols = []
+    for name in sorted(os.listdir(directory)):
+        path = os.path.join(directory, name)
+        if not os.path.isdir(path):
+            continue
+        try:
+            class_id = int(name.split('_', 1)[0])
+        except ValueError:
+            sys.exit(f'Symbol directory {name} does not start with a class id')
+        images = sorted(os.path.join(path, f) for f in os.listdir(path) if f.lower().endswith(IMAGE_EXTENSIONS))
+        if images:
+            symbols.append((class_id, images))
+    if not symbols:
+        sys.exit(f'No symbol directories with images found in {directory}')
+    return symbols
+
+
+def normalize(vectors):
+    norms = np.linalg.norm(vectors, axis=-1, keepdims=True)
+    return vectors / np.maximum(norms, 1e-12)
+
+
+def embed(session, images, size):
+    input_meta = session.get_inputs()[0]
+    batch = np.stack([letterbox(path, size) for path in images])
+    if isinstance(input_meta.shape[0], int) and input_meta.shape[0] == 1:
+        outputs = [session.run(None, {input_meta.name: batch[i:i + 1]})[0] for i in range(len(batch))]
+        output = np.concatenate(outputs)
+    else:
+        output = session.run(None, {input_meta.name: batch})[0]
+    return normalize(output.reshape(len(images), -1).astype(np.float32))
+
+
+def write_table(path, class_ids, rows, int8):
+    count, dim = rows.shape
+    with open(path, 'wb') as f:
+        f.write(MAGIC)
+        f.write(struct.pack('<5I', VERSION, dim, count, INT8 if int8 else FLOAT32, 0))
+        f.write(np.asarray(class_ids, dtype='<i4').tobytes())
+        if int8:
+            # Only a row's direction matters, so each row gets its own range.
+            peaks = np.maximum(np.abs(rows).max(axis=1, keepdims=True), 1e-12)
+            f.write(np.round(rows / peaks * 127).astype(np.int8).tobytes())
+        else:
+            f.write(rows.astype('<f4').tobytes())
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--model', required=True, help='embedding model, [N, 3, S, S] in, [N, D] out')
+    parser.add_argument('--symbols-dir', required=True, help='one subdirectory of crops per symbol')
+    parser.add_argument('--output', required=True, help='table file to write')
+    parser.add_argument('--per-image', action='store_true', help='one row per crop instead of one per symbol')
+    parser.add_argument('--int8', action='store_true', help='store rows as int8')
+    args = parser.parse_args()
+
+    session = ort.InferenceSession(args.model, providers=['CPUExecutionProvider'])
+    size = session.get_inputs()[0].shape[2]
+    if not isinstance(size, int):
+        sys.exit('The embedding model needs a fixed input size')
+
+    class_ids = []
+    rows = []
+    for class_id, images in list_symbols(args.symbols_dir):
+        embeddings = embed(session, images, size)
+        if args.per_image:
+            class_ids.extend([class_id] * len(embeddings))
+            rows.extend(embeddings)
+        else:
+            class_ids.append(class_id)
+            rows.append(normalize(embeddings.mean(axis=0)))
+    rows = np.stack(rows)
+
+    write_table(args.output, class_ids, rows, args.int8)
+    print(f'Wrote {len(rows)} rows of {rows.shape[1]} ({"int8" if args.int8 else "float32"}) '
+          f'for {len(set(class_ids))} symbols to {args.output}')
+
+
+if __name__ == '__main__':
+    main()
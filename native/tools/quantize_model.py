@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+"""Writes INT8 (static QDQ) and FP16 variants of the YOLOv8 detector.
+
+Host-side only; run through the `quantize_model` CMake target or directly:
+
+    python3 native/tools/quantize_model.py \
+        --model assets/models/yolov8n.onnx \
+        --calibration-dir ~/dobble_samples \
+        --output-dir assets/models
+
+INT8 activation ranges are calibrated on sample card images, preprocessed
+exactly like the native letterbox (bilinear resize, 114 gray padding, RGB,
+[0, 1], NCHW). The detection head's box decoding stays in float, since
+quantizing it costs box accuracy for no measurable speed. FP16 keeps float32
+inputs and outputs, which the native engine requires.
+
+It also writes an accuracy-vs-speed report (JSON) that compares every variant
+with FP32 on the calibration images. The report gives detection agreement,
+score drift, host latency and file size.
+"""
+
+import argparse
+import json
+import os
+import sys
+import tempfile
+import time
+
+import numpy as np
+import onnx
+import onnxruntime as ort
+from onnxruntime.quantization import (CalibrationDataReader, CalibrationMethod, QuantFormat, QuantType,
+                                      quantize_static)
+from onnxruntime.quantization.shape_inference import quant_pre_process
+from PIL import Image
+
+IMAGE_EXTENSIONS = ('.jpg', '.jpeg', '.png', '.bmp', '.webp')
+PAD_VALUE = 114
+SCORE_THRESHOLD = 0.25
+IOU_THRESHOLD = 0.45
+MATCH_IOU = 0.5
+
+
+def letterbox(path, size):
+    image = Image.open(path).convert('RGB')
+    scale = min(size / image.width, size / image.height)
+    width = max(1, round(image.width * scale))
+    height = max(1, round(image.height * scale))
+    canvas = Image.new('RGB', (size, size), (PAD_VALUE, PAD_VALUE, PAD_VALUE))
+    canvas.paste(image.resize((width, height), Image.BILINEAR), ((size - width) // 2, (size - height) // 2))
+    return (np.asarray(canvas, dtype=np.float32) / 255.0).transpose(2, 0, 1)[np.newaxis]
+
+
+def list_images(directory, limit):
+    paths = sorted(os.path.join(directory, name) for name in os.listdir(directory)
+                   if name.lower().endswith(IMAGE_EXTENSIONS))
+    if not paths:
+        sys.exit(f'No images found in {directory}')
+    return paths[:limit] if limit > 0 else paths
+
+
+class CardImageReader(CalibrationDataReader):
+    def __init__(self, input_name, images):
+        self._batches = iter([{input_name: image} for image in images])
+
+    def get_next(self):
+        return next(self._batches, None)
+
+
+def head_nodes(model, prefix):
+    """Detection-head nodes to keep in float (everything but its convolutions)."""
+    return [node.name for node in model.graph.node if node.name.startswith(prefix) and node.op_type != 'Conv']
+
+
+def quantize_int8(model_path, output_path, input_name, images, head_prefix, method):
+    with tempfile.TemporaryDirectory() as scratch:
+        prepared = os.path.join(scratch, 'prepared.onnx')
+        quant_pre_process(model_path, prepared)
+        quantize_static(
+            prepared,
+            output_path,
+            CardImageReader(input_name, images),
+            quant_format=QuantFormat.QDQ,
+            per_channel=True,
+            activation_type=QuantType.QUInt8,
+            weight_type=QuantType.QInt8,
+            calibrate_method=method,
+            nodes_to_exclude=head_nodes(onnx.load(prepared), head_prefix),
+        )
+
+
+def convert_fp16(model_path, output_path):
+    from onnxconverter_common import float16
+
+    model = float16.convert_float_to_float16(onnx.load(model_path), keep_io_types=True)
+    onnx.save(model, output_path)
+
+
+def decode(output):
+    """[1, 4 + classes, anchors] -> (boxes xyxy, scores, classes) after NMS."""
+    predictions = output[0].T
+    scores = predictions[:, 4:].max(axis=1)
+    classes = predictions[:, 4:].argmax(axis=1)
+    keep = scores > SCORE_THRESHOLD
+    cx, cy, w, h = predictions[keep, :4].T
+    boxes = np.stack([cx - w / 2, cy - h / 2, cx + w / 2, cy + h / 2], axis=1)
+    scores, classes = scores[keep], classes[keep]
+
+    order = np.argsort(-scores)
+    kept = []
+    while order.size:
+        best = order[0]
+        kept.append(best)
+        rest = order[1:]
+        same = classes[rest] == classes[best]
+        overlap = iou(boxes[best], boxes[rest])
+        order = rest[~(same & (overlap > IOU_THRESHOLD))]
+    return boxes[kept], scores[kept], classes[kept]
+
+
+def iou(box, boxes):
+    if boxes.size == 0:
+        return np.zeros(0)
+    x1 = np.maximum(box[0], boxes[:, 0])
+    y1 = np.maximum(box[1], boxes[:, 1])
+    x2 = np.minimum(box[2], boxes[:, 2])
+    y2 = np.minimum(box[3], boxes[:, 3])
+    inter = np.clip(x2 - x1, 0, None) * np.clip(y2 - y1, 0, None)
+    area = (box[2] - box[0]) * (box[3] - box[1])
+    areas = (boxes[:, 2] - boxes[:, 0]) * (boxes[:, 3] - boxes[:, 1])
+    return inter / np.maximum(area + areas - inter, 1e-9)
+
+
+def agreement(reference, candidate):
+    """Share of reference detections the candidate reproduces, and their score drift."""
+    ref_boxes, ref_scores, ref_classes = reference
+    boxes, scores, classes = candidate
+    matched, drift = 0, []
+    for box, score, cls in zip(ref_boxes, ref_scores, ref_classes):
+        same = np.flatnonzero(classes == cls)
+        if same.size == 0:
+            continue
+        overlaps = iou(box, boxes[same])
+        best = overlaps.argmax()
+        if overlaps[best] >= MATCH_IOU:
+            matched += 1
+            drift.append(abs(float(scores[same[best]]) - float(score)))
+    return matched, len(ref_boxes), drift
+
+
+def report(variants, input_name, images, path):
+    sessions = {name: ort.InferenceSession(model, providers=['CPUExecutionProvider'])
+                for name, model in variants.items()}
+    results = {name: {'latency_ms': [], 'detections': []} for name in variants}
+    for image in images:
+        for name, session in sessions.items():
+            start = time.perf_counter()
+            output = session.run(None, {input_name: image})[0]
+            results[name]['latency_ms'].append((time.perf_counter() - start) * 1000.0)
+            results[name]['detections'].append(decode(output))
+
+    summary = {}
+    for name, model in variants.items():
+        matched, total, drift = 0, 0, []
+        for reference, candidate in zip(results['fp32']['detections'], results[name]['detections']):
+            m, t, d = agreement(reference, candidate)
+            matched, total, drift = matched + m, total + t, drift + d
+        summary[name] = {
+            'path': model,
+            'size_mb': round(os.path.getsize(model) / 2**20, 2),
+            'host_latency_ms_median': round(float(np.median(results[name]['latency_ms'])), 2),
+            'fp32_detections_reproduced': round(matched / total, 4) if total else None,
+            'mean_score_drift': round(float(np.mean(drift)), 4) if drift else None,
+        }
+    with open(path, 'w') as out:
+        json.dump({'images': len(images), 'variants': summary}, out, indent=2)
+    for name, entry in summary.items():
+        print(f"{name:>5}: {entry['size_mb']:6.2f} MB  {entry['host_latency_ms_median']:7.2f} ms  "
+              f"agreement {entry['fp32_detections_reproduced']}  drift {entry['mean_score_drift']}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--model', required=True, help='FP32 ONNX model')
+    parser.add_argument('--calibration-dir', required=True, help='directory of sample card images')
+    parser.add_argument('--output-dir', required=True, help='where <stem>_int8.onnx / <stem>_fp16.onnx go')
+    parser.add_argument('--report', help='accuracy-vs-speed report (default: <output-dir>/<stem>_variants.json)')
+    parser.add_argument('--max-images', type=int, default=200, help='calibration images to use (0 = all)')
+    parser.add_argument('--method', choices=['minmax', 'percentile', 'entropy'], default='percentile')
+    parser.add_argument('--head-prefix', default='/model.22/', help='name prefix of the detection head nodes')
+    parser.add_argument('--skip-fp16', action='store_true')
+    args = parser.parse_args()
+
+    model = onnx.load(args.model)
+    input_name = model.graph.input[0].name
+    size = model.graph.input[0].type.tensor_type.shape.dim[2].dim_value or 640
+    images = [letterbox(path, size) for path in list_images(args.calibration_dir, args.max_images)]
+    print(f'Calibrating on {len(images)} images at {size}x{size}')
+
+    stem = os.path.splitext(os.path.basename(args.model))[0]
+    os.makedirs(args.output_dir, exist_ok=True)
+    variants = {'fp32': args.model}
+
+    int8_path = os.path.join(args.output_dir, f'{stem}_int8.onnx')
+    methods = {'minmax': CalibrationMethod.MinMax, 'percentile': CalibrationMethod.Percentile,
+               'entropy': CalibrationMethod.Entropy}
+    quantize_int8(args.model, int8_path, input_name, images, args.head_prefix, methods[args.method])
+    variants['int8'] = int8_path
+
+    if not args.skip_fp16:
+        fp16_path = os.path.join(args.output_dir, f'{stem}_fp16.onnx')
+        convert_fp16(args.model, fp16_path)
+        variants['fp16'] = fp16_path
+
+    report(variants, input_name, images, args.report or os.path.join(args.output_dir, f'{stem}_variants.json'))
+
+
+if __name__ == '__main__':
+    main()